@@ -0,0 +1,191 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/BatchCalibrator.h"
+#include "doctest.h"
+#include <fstream>
+#include <vector>
+
+namespace sstcam::calibration {
+
+using namespace descriptions;
+
+TEST_CASE("BatchCalibrator Events") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    std::vector<uint8_t> example(packet_size);
+    file.read(reinterpret_cast<char*>(example.data()), packet_size);
+
+    // Events of two modules, each starting at a different first cell
+    size_t n_pixels = 2 * N_PIXELS_PER_MODULE;
+    size_t n_events = 9;
+    std::vector<std::shared_ptr<WaveformDataPacket>> packets;
+    std::vector<WaveformEventR0> events;
+    for (size_t i = 0; i < n_events; i++) {
+        WaveformEventR0 event(2, n_pixels, 0);
+        for (uint8_t slot = 0; slot < 2; slot++) {
+            if (i == 0) continue; // Event without packets
+            if (i == 4 && slot == 1) continue; // Missing packet
+            auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+            std::copy(example.begin(), example.end(), packet->GetDataPacket());
+            packet->GetDataPacket()[4] = slot;
+            packet->GetDataPacket()[14] ^= static_cast<uint8_t>(slot << 5u); // Column
+            packet->GetDataPacket()[15] = static_cast<uint8_t>(i); // Block phase
+            event.AddPacketShared(packet);
+        }
+        events.push_back(std::move(event));
+    }
+    size_t n_samples = events[1].GetNSamples();
+    size_t event_size = n_pixels * n_samples;
+
+    Calibrator calibrator(n_pixels);
+    std::vector<float> pedestals(n_pixels * N_STORAGE_CELLS);
+    for (size_t i = 0; i < pedestals.size(); i++) pedestals[i] = static_cast<float>(i % 701);
+    calibrator.SetPedestals(pedestals.data());
+
+    // The modules start in different cell groups
+    TransferFunction tf(n_pixels, -1000, 6000, 2);
+    std::vector<float> table(tf.GetNADC());
+    for (uint16_t group = 0; group < 2; group++) {
+        for (size_t i = 0; i < table.size(); i++) {
+            table[i] = 0.3f * (static_cast<float>(i) - 1000) + 50.f * group;
+        }
+        for (uint16_t pixel = 0; pixel < n_pixels; pixel++) tf.SetTable(pixel, group, table.data());
+    }
+    REQUIRE(tf.GetCellGroup(events[1].GetPackets()[0]->GetFirstCellID()) !=
+            tf.GetCellGroup(events[1].GetPackets()[1]->GetFirstCellID()));
+
+    // Reference, calibrated event by event
+    std::vector<float> expected(n_events * event_size, 0);
+    for (size_t i = 1; i < n_events; i++) {
+        calibrator.FillPedestalSubtractedArray(events[i], &expected[i * event_size]);
+    }
+
+    SUBCASE("Pedestal Subtraction") {
+        BatchCalibrator batch(calibrator, nullptr, 4);
+        CHECK(batch.GetNThreads() == 4);
+        CHECK(batch.GetNPixels() == n_pixels);
+        std::vector<float> output(n_events * event_size, -1);
+        batch.FillCalibratedArray(events, output.data());
+        CHECK(output == expected);
+    }
+
+    SUBCASE("Transfer Function") {
+        BatchCalibrator batch(calibrator, &tf, 3);
+        std::vector<float> output(n_events * event_size, -1);
+        batch.FillCalibratedArray(events, output.data());
+        // Each waveform is converted from the first cell of its packet
+        Waveform waveform;
+        for (size_t i = 1; i < n_events; i++) {
+            for (const WaveformDataPacket* packet : events[i].GetPackets()) {
+                if (!packet) continue;
+                for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++) {
+                    waveform.Associate(*packet, iwav);
+                    uint16_t pixel = packet->GetSlotID() * N_PIXELS_PER_MODULE + waveform.GetPixelID();
+                    for (size_t isample = 0; isample < n_samples; isample++) {
+                        auto cell = static_cast<uint16_t>((packet->GetFirstCellID() + isample) % N_STORAGE_CELLS);
+                        float& sample = expected[i * event_size + pixel * n_samples + isample];
+                        sample = tf.Lookup(pixel, cell, sample);
+                    }
+                }
+            }
+        }
+        CHECK(output == expected);
+    }
+
+    SUBCASE("Errors") {
+        TransferFunction other(n_pixels / 2);
+        CHECK_THROWS_AS(BatchCalibrator(calibrator, &other), std::runtime_error);
+
+        Calibrator mismatched(n_pixels / 2);
+        BatchCalibrator batch(mismatched, nullptr, 2);
+        std::vector<float> output(n_events * event_size);
+        CHECK_THROWS_AS(batch.FillCalibratedArray(events, output.data()), std::runtime_error);
+    }
+}
+
+TEST_CASE("BatchCalibrator Zero-Suppressed Waveform") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    std::vector<uint8_t> example(packet_size);
+    file.read(reinterpret_cast<char*>(example.data()), packet_size);
+
+    // Full module: the second packet holds the waveforms of ASICs 2 and 3
+    size_t n_pixels = N_PIXELS_PER_MODULE;
+    WaveformEventR0 event(2, n_pixels, example[4]);
+    std::vector<std::shared_ptr<WaveformDataPacket>> packets;
+    for (uint8_t ipack = 0; ipack < 2; ipack++) {
+        auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+        std::copy(example.begin(), example.end(), packet->GetDataPacket());
+        for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++) {
+            packet->GetDataPacket()[packet->GetWaveformStart(iwav)] += 0x40u * ipack;
+        }
+        event.AddPacketShared(packet);
+        packets.push_back(packet);
+    }
+    REQUIRE(event.GetNPixelsPresent() == n_pixels);
+
+    // Suppress a single waveform
+    Waveform waveform;
+    waveform.Associate(*packets[1], 3);
+    uint16_t pixel = waveform.GetPixelID();
+    packets[1]->GetDataPacket()[packets[1]->GetWaveformStart(3) + 1] |= 0x80u;
+    REQUIRE(waveform.IsZeroSuppressed());
+
+    Calibrator calibrator(n_pixels);
+    size_t n_samples = event.GetNSamples();
+    std::vector<float> expected(n_pixels * n_samples, 0);
+    calibrator.FillPedestalSubtractedArray(event, expected.data());
+
+    BatchCalibrator batch(calibrator, nullptr, 1);
+    std::vector<float> output(n_pixels * n_samples, -1);
+    batch.FillCalibratedArray({event}, output.data());
+    CHECK(output == expected);
+    CHECK(output[pixel * n_samples] == 0);
+}
+
+TEST_CASE("BatchCalibrator TIOReader") {
+    std::string path = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::ifstream file(path);
+    REQUIRE(file.good());
+    file.close();
+
+    io::TIOReader reader(path);
+    size_t n_pixels = reader.GetNPixels();
+    size_t event_size = n_pixels * reader.GetNSamples();
+    Calibrator calibrator(n_pixels);
+    std::vector<float> pedestals(n_pixels * N_STORAGE_CELLS, 400);
+    calibrator.SetPedestals(pedestals.data());
+    BatchCalibrator batch(calibrator, nullptr, 4);
+
+    size_t first_event_index = 1;
+    size_t n_events = reader.GetNEvents() - 1;
+    std::vector<float> output(n_events * event_size);
+    batch.FillCalibratedArray(reader, output.data(), first_event_index, n_events);
+
+    bool matches = true;
+    std::vector<float> expected(event_size);
+    for (size_t i = 0; i < n_events; i++) {
+        std::fill(expected.begin(), expected.end(), 0);
+        calibrator.FillPedestalSubtractedArray(
+            reader.GetEventR0(first_event_index + i), expected.data());
+        if (!std::equal(expected.begin(), expected.end(), &output[i * event_size])) {
+            matches = false;
+        }
+    }
+    CHECK(matches);
+
+    CHECK_THROWS_AS(batch.FillCalibratedArray(reader, output.data(), 1, reader.GetNEvents()),
+                    std::out_of_range);
+    io::TIOReader reader_r1("../../share/sstcam/io/targetmodule_r1.tio");
+    CHECK_THROWS_AS(batch.FillCalibratedArray(reader_r1, output.data(), 0, 1),
+                    std::runtime_error);
+}
+
+}
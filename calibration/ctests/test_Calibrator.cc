@@ -0,0 +1,125 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/Calibrator.h"
+#include "doctest.h"
+#include <fstream>
+#include <vector>
+
+namespace sstcam::calibration {
+
+using namespace descriptions;
+
+TEST_CASE("Calibrator") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+    file.read(reinterpret_cast<char*>(packet->GetDataPacket()), packet_size);
+
+    std::set<uint8_t> active_module_slots = {packet->GetSlotID()};
+    size_t n_samples = packet->GetWaveformNSamples();
+    size_t n_pixels;
+    uint8_t first_active_module_slot;
+    GetHardcodedModuleSituation(active_module_slots, n_pixels, first_active_module_slot);
+
+    WaveformEventR0 event(1, n_pixels, first_active_module_slot);
+    event.AddPacket(packet.get());
+
+    // Distinct pedestal for every pixel and cell
+    std::vector<float> pedestals(n_pixels * N_STORAGE_CELLS);
+    for (size_t i = 0; i < pedestals.size(); i++) {
+        pedestals[i] = static_cast<float>(i % 1000) * 0.25f;
+    }
+    Calibrator calibrator(n_pixels);
+    calibrator.SetPedestals(pedestals.data());
+    CHECK(calibrator.GetNPixels() == n_pixels);
+    CHECK(calibrator.GetPedestal(1, 3) == pedestals[N_STORAGE_CELLS + 3]);
+
+    // Reference subtraction with the scalar sample getter
+    auto reference = [&]() {
+        std::vector<float> samples(n_pixels * n_samples, 0);
+        uint16_t first_cell = packet->GetFirstCellID();
+        Waveform waveform;
+        for (uint16_t i_waveform = 0; i_waveform < packet->GetNWaveforms(); i_waveform++) {
+            waveform.Associate(*packet, i_waveform);
+            uint16_t pixel = waveform.GetPixelID();
+            for (uint16_t isample = 0; isample < n_samples; isample++) {
+                uint16_t cell = (first_cell + isample) % N_STORAGE_CELLS;
+                samples[pixel * n_samples + isample] =
+                    GetSampleR0(waveform, isample) - pedestals[pixel * N_STORAGE_CELLS + cell];
+            }
+        }
+        return samples;
+    };
+
+    SUBCASE("Pedestal Subtraction") {
+        REQUIRE(packet->GetFirstCellID() == 1448);
+        CHECK(calibrator.GetPedestalSubtractedVector(event) == reference());
+    }
+
+    SUBCASE("Kernels") {
+        std::vector<float> expected = reference();
+        Waveform waveform;
+        waveform.Associate(*packet, 0);
+        uint16_t pixel = waveform.GetPixelID();
+        uint16_t first_cell = packet->GetFirstCellID();
+        for (auto kernel : {SampleUnpackingKernel::SCALAR, SampleUnpackingKernel::SSE4,
+                            SampleUnpackingKernel::AVX2, SampleUnpackingKernel::AVX512}) {
+            if (!IsSampleUnpackingKernelSupported(kernel)) {
+                CHECK_THROWS_AS(GetSubtractPedestalFunction(kernel), std::runtime_error);
+                continue;
+            }
+            SubtractPedestalFunction subtract = GetSubtractPedestalFunction(kernel);
+            // Lengths that are not a multiple of the vector width
+            for (size_t n : {n_samples, n_samples - 1, size_t(5)}) {
+                std::vector<float> samples(n);
+                subtract(waveform.GetSampleData(),
+                         &pedestals[pixel * N_STORAGE_CELLS + first_cell],
+                         samples.data(), n);
+                for (size_t i = 0; i < n; i++) {
+                    CHECK(samples[i] == expected[pixel * n_samples + i]);
+                }
+            }
+        }
+    }
+
+    SUBCASE("Set Pixel Pedestal") {
+        Calibrator other(n_pixels);
+        std::vector<float> pedestal(N_STORAGE_CELLS, 10);
+        other.SetPixelPedestal(2, pedestal.data());
+        CHECK(other.GetPedestal(2, 100) == 10);
+        CHECK(other.GetPedestal(1, 100) == 0);
+        CHECK_THROWS_AS(other.SetPixelPedestal(n_pixels, pedestal.data()),
+                        std::out_of_range);
+    }
+
+    SUBCASE("Mismatched Event") {
+        Calibrator other(n_pixels * 2);
+        CHECK_THROWS_AS(other.GetPedestalSubtractedVector(event), std::runtime_error);
+    }
+
+    SUBCASE("Storage Array Wrap") {
+        // Move the first sample of the packet to the last cells of the array
+        packet->GetDataPacket()[14] = (packet->GetDataPacket()[14] & 0xC0u) | 63u;
+        packet->GetDataPacket()[15] = 0xE0u | 31u;
+        REQUIRE(packet->GetFirstCellID() == N_STORAGE_CELLS - 1);
+        CHECK(calibrator.GetPedestalSubtractedVector(event) == reference());
+    }
+
+    SUBCASE("Zero-Suppressed Waveform") {
+        Waveform waveform;
+        waveform.Associate(*packet, 0);
+        uint16_t pixel = waveform.GetPixelID();
+        std::vector<float> expected = reference();
+        std::fill_n(&expected[pixel * n_samples], n_samples, 0.f);
+        packet->GetDataPacket()[packet->GetWaveformStart(0) + 1] |= 0x80u;
+        REQUIRE(waveform.IsZeroSuppressed());
+        CHECK(calibrator.GetPedestalSubtractedVector(event) == expected);
+    }
+}
+
+}
@@ -0,0 +1,266 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/ChargeExtractor.h"
+#include "doctest.h"
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+namespace sstcam::calibration {
+
+using namespace descriptions;
+
+// Pulse of a pixel (peaking at a different sample in each pixel) on top of
+// a small alternating baseline
+float ExamplePulse(size_t pixel, size_t sample) {
+    auto peak = static_cast<float>((pixel * 7) % 40 + 5);
+    auto x = static_cast<float>(sample) - peak;
+    float amplitude = 10.f + static_cast<float>(pixel % 13);
+    return amplitude * std::exp(-0.5f * x * x / 4.f) + ((sample + pixel) % 2 ? 0.5f : -0.5f);
+}
+
+// Straightforward reference of a single pixel integrated in [start, start + width)
+void ReferenceWindow(const float* waveform, size_t start, size_t width,
+        float& charge, float& time) {
+    charge = 0;
+    float time_num = 0;
+    float time_den = 0;
+    for (size_t i = start; i < start + width; i++) {
+        charge += waveform[i];
+        if (waveform[i] > 0) {
+            time_num += waveform[i] * static_cast<float>(i);
+            time_den += waveform[i];
+        }
+    }
+    time = time_den > 0 ? time_num / time_den : static_cast<float>(start) + (width - 1) / 2.f;
+}
+
+TEST_CASE("ExtractChargeFunction") {
+    size_t n_pixels = 37; // Not a multiple of the vector widths
+    size_t n_samples = 50;
+    size_t stride = 40;
+    size_t width = 5;
+    std::vector<float> samples(n_samples * stride, 0); // [n_samples][stride]
+    std::vector<float> reference(n_samples * stride, 0);
+    for (size_t s = 0; s < n_samples; s++) {
+        for (size_t p = 0; p < n_pixels; p++) {
+            samples[s * stride + p] = ExamplePulse(p, s);
+            reference[s * stride + p] = ExamplePulse(p + 1, s);
+        }
+    }
+    std::vector<float> waveform(n_samples);
+
+    for (auto method : {ChargeExtractionMethod::FIXED_WINDOW,
+                        ChargeExtractionMethod::SLIDING_WINDOW,
+                        ChargeExtractionMethod::NEIGHBOUR_PEAK}) {
+        size_t offset = method == ChargeExtractionMethod::FIXED_WINDOW ? 20 : 2;
+        std::vector<float> expected_charge(n_pixels), expected_time(n_pixels);
+        auto scalar = GetExtractChargeFunction(SampleUnpackingKernel::SCALAR);
+        scalar(samples.data(), reference.data(), n_samples, n_pixels, stride,
+               method, width, offset, expected_charge.data(), expected_time.data());
+
+        for (size_t p = 0; p < n_pixels; p++) {
+            for (size_t s = 0; s < n_samples; s++) waveform[s] = samples[s * stride + p];
+            size_t start = offset;
+            if (method == ChargeExtractionMethod::SLIDING_WINDOW) {
+                float max_sum = -1e9;
+                for (size_t i = 0; i + width <= n_samples; i++) {
+                    float sum = 0;
+                    for (size_t j = i; j < i + width; j++) sum += waveform[j];
+                    if (sum > max_sum + 1e-3f) {
+                        max_sum = sum;
+                        start = i;
+                    }
+                }
+            }
+            else if (method == ChargeExtractionMethod::NEIGHBOUR_PEAK) {
+                size_t peak = 0;
+                for (size_t s = 1; s < n_samples; s++) {
+                    if (reference[s * stride + p] > reference[peak * stride + p]) peak = s;
+                }
+                start = std::min(peak > offset ? peak - offset : 0, n_samples - width);
+            }
+            float charge, time;
+            ReferenceWindow(waveform.data(), start, width, charge, time);
+            CHECK(expected_charge[p] == doctest::Approx(charge).epsilon(1e-4));
+            CHECK(expected_time[p] == doctest::Approx(time).epsilon(1e-4));
+        }
+
+        for (auto kernel : {SampleUnpackingKernel::SSE4, SampleUnpackingKernel::AVX2,
+                            SampleUnpackingKernel::AVX512}) {
+            if (!IsSampleUnpackingKernelSupported(kernel)) {
+                CHECK_THROWS_AS(GetExtractChargeFunction(kernel), std::runtime_error);
+                continue;
+            }
+            auto extract = GetExtractChargeFunction(kernel);
+            std::vector<float> charge(n_pixels), time(n_pixels);
+            extract(samples.data(), reference.data(), n_samples, n_pixels, stride,
+                    method, width, offset, charge.data(), time.data());
+            for (size_t p = 0; p < n_pixels; p++) {
+                CHECK(charge[p] == doctest::Approx(expected_charge[p]).epsilon(1e-5));
+                CHECK(time[p] == doctest::Approx(expected_time[p]).epsilon(1e-5));
+            }
+        }
+    }
+}
+
+TEST_CASE("ChargeExtractor Layouts") {
+    size_t n_pixels = 128;
+    size_t n_samples = 48;
+    std::vector<float> pixel_major(n_pixels * n_samples);
+    std::vector<float> sample_major(n_samples * n_pixels);
+    std::vector<float> module_tiles(n_pixels * n_samples);
+    for (size_t p = 0; p < n_pixels; p++) {
+        for (size_t s = 0; s < n_samples; s++) {
+            float sample = ExamplePulse(p, s);
+            pixel_major[p * n_samples + s] = sample;
+            sample_major[s * n_pixels + p] = sample;
+            module_tiles[((p / N_PIXELS_PER_MODULE) * n_samples + s) *
+                         N_PIXELS_PER_MODULE + p % N_PIXELS_PER_MODULE] = sample;
+        }
+    }
+
+    // Each pixel neighbours the next and previous pixels
+    std::vector<std::vector<uint16_t>> neighbours(n_pixels);
+    for (uint16_t p = 0; p < n_pixels; p++) {
+        if (p > 0) neighbours[p].push_back(p - 1);
+        if (p + 1u < n_pixels) neighbours[p].push_back(p + 1);
+    }
+
+    SUBCASE("Methods") {
+        ChargeExtractor fixed(ChargeExtractionMethod::FIXED_WINDOW, 7, 10);
+        ChargeExtractor sliding(ChargeExtractionMethod::SLIDING_WINDOW, 7);
+        ChargeExtractor neighbour(ChargeExtractionMethod::NEIGHBOUR_PEAK, 8, 4, neighbours);
+        CHECK(fixed.GetMethod() == ChargeExtractionMethod::FIXED_WINDOW);
+        CHECK(fixed.GetWindowWidth() == 7);
+        CHECK(fixed.GetWindowOffset() == 10);
+        CHECK(fixed.GetNNeighbourPixels() == 0);
+        CHECK(neighbour.GetNNeighbourPixels() == n_pixels);
+
+        for (const ChargeExtractor* extractor : {&fixed, &sliding, &neighbour}) {
+            std::vector<float> charge(n_pixels), time(n_pixels);
+            extractor->Extract(sample_major.data(), n_pixels, n_samples,
+                               charge.data(), time.data(), SampleLayout::SAMPLE_MAJOR);
+            for (auto layout : {SampleLayout::PIXEL_MAJOR, SampleLayout::MODULE_TILES}) {
+                const float* samples = layout == SampleLayout::PIXEL_MAJOR ?
+                    pixel_major.data() : module_tiles.data();
+                std::vector<float> charge_l(n_pixels), time_l(n_pixels);
+                extractor->Extract(samples, n_pixels, n_samples,
+                                   charge_l.data(), time_l.data(), layout);
+                CHECK(charge_l == charge);
+                CHECK(time_l == time);
+            }
+        }
+
+        // The sliding window finds the pulse of every pixel
+        std::vector<float> charge(n_pixels), time(n_pixels);
+        sliding.Extract(pixel_major.data(), n_pixels, n_samples, charge.data(), time.data());
+        for (size_t p = 0; p < n_pixels; p++) {
+            auto peak = static_cast<float>((p * 7) % 40 + 5);
+            CHECK(time[p] == doctest::Approx(peak).epsilon(0.02));
+            CHECK(charge[p] > 4.f * (10.f + static_cast<float>(p % 13)));
+        }
+    }
+
+    SUBCASE("Errors") {
+        std::vector<float> charge(n_pixels), time(n_pixels);
+        CHECK_THROWS_AS(ChargeExtractor(ChargeExtractionMethod::SLIDING_WINDOW, 0),
+                        std::runtime_error);
+        CHECK_THROWS_AS(ChargeExtractor(ChargeExtractionMethod::NEIGHBOUR_PEAK, 4),
+                        std::runtime_error);
+        CHECK_THROWS_AS(ChargeExtractor(ChargeExtractionMethod::NEIGHBOUR_PEAK, 4, 0,
+                                        {{1}, {2}}), std::out_of_range);
+
+        ChargeExtractor fixed(ChargeExtractionMethod::FIXED_WINDOW, 8, 41);
+        CHECK_THROWS_AS(fixed.Extract(pixel_major.data(), n_pixels, n_samples,
+                                      charge.data(), time.data()), std::runtime_error);
+        ChargeExtractor sliding(ChargeExtractionMethod::SLIDING_WINDOW, 41);
+        sliding.Extract(pixel_major.data(), n_pixels, n_samples, charge.data(), time.data());
+        CHECK_THROWS_AS(sliding.Extract(pixel_major.data(), n_pixels, 40,
+                                        charge.data(), time.data()), std::runtime_error);
+        CHECK_THROWS_AS(sliding.Extract(module_tiles.data(), 100, n_samples, charge.data(),
+                                        time.data(), SampleLayout::MODULE_TILES),
+                        std::runtime_error);
+        ChargeExtractor neighbour(ChargeExtractionMethod::NEIGHBOUR_PEAK, 8, 4, neighbours);
+        CHECK_THROWS_AS(neighbour.Extract(pixel_major.data(), 64, n_samples,
+                                          charge.data(), time.data()), std::runtime_error);
+    }
+}
+
+TEST_CASE("ChargeExtractor Event") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    std::vector<uint8_t> example(packet_size);
+    file.read(reinterpret_cast<char*>(example.data()), packet_size);
+
+    // Event with packets in the second and third modules only
+    size_t n_pixels = 256;
+    WaveformEventR0 event(2, n_pixels, 0);
+    for (uint8_t slot = 1; slot < 3; slot++) {
+        auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+        std::copy(example.begin(), example.end(), packet->GetDataPacket());
+        packet->GetDataPacket()[4] = slot;
+        event.AddPacketShared(packet);
+    }
+    size_t n_samples = event.GetNSamples();
+
+    Calibrator calibrator(n_pixels);
+    std::vector<float> pedestals(n_pixels * N_STORAGE_CELLS);
+    for (size_t i = 0; i < pedestals.size(); i++) pedestals[i] = static_cast<float>(i % 701);
+    calibrator.SetPedestals(pedestals.data());
+
+    TransferFunction tf(n_pixels, -1000, 6000);
+    std::vector<float> table(tf.GetNADC());
+    for (size_t i = 0; i < table.size(); i++) table[i] = 0.3f * (static_cast<float>(i) - 1000);
+    for (uint16_t pixel = 0; pixel < n_pixels; pixel++) tf.SetTable(pixel, 0, table.data());
+
+    std::vector<std::vector<uint16_t>> neighbours(n_pixels);
+    for (uint16_t p = 0; p < n_pixels; p++) {
+        neighbours[p] = {static_cast<uint16_t>((p + 1) % n_pixels),
+                         static_cast<uint16_t>((p + 64) % n_pixels)};
+    }
+
+    // Reference, extracted from the materialized waveforms
+    std::vector<float> samples(n_pixels * n_samples, 0);
+    calibrator.FillPedestalSubtractedArray(event, samples.data());
+    std::vector<float> samples_mv(samples);
+    tf.Apply(event, samples_mv.data(), samples_mv.data());
+
+    for (auto method : {ChargeExtractionMethod::FIXED_WINDOW,
+                        ChargeExtractionMethod::SLIDING_WINDOW,
+                        ChargeExtractionMethod::NEIGHBOUR_PEAK}) {
+        ChargeExtractor extractor(method, 5, 2, neighbours);
+        std::vector<float> expected_charge(n_pixels), expected_time(n_pixels);
+        std::vector<float> charge(n_pixels, -1), time(n_pixels, -1);
+
+        extractor.Extract(samples.data(), n_pixels, n_samples,
+                          expected_charge.data(), expected_time.data());
+        extractor.Extract(calibrator, event, charge.data(), time.data());
+        CHECK(charge == expected_charge);
+        CHECK(time == expected_time);
+        CHECK(charge[0] == 0); // Missing module
+        CHECK(charge[70] != 0);
+
+        extractor.Extract(samples_mv.data(), n_pixels, n_samples,
+                          expected_charge.data(), expected_time.data());
+        extractor.Extract(calibrator, event, charge.data(), time.data(), &tf);
+        CHECK(charge == expected_charge);
+        CHECK(time == expected_time);
+    }
+
+    TransferFunction other(n_pixels / 2);
+    ChargeExtractor extractor(ChargeExtractionMethod::SLIDING_WINDOW, 5);
+    std::vector<float> charge(n_pixels), time(n_pixels);
+    CHECK_THROWS_AS(extractor.Extract(calibrator, event, charge.data(), time.data(), &other),
+                    std::runtime_error);
+    Calibrator small(n_pixels / 2);
+    CHECK_THROWS_AS(extractor.Extract(small, event, charge.data(), time.data()),
+                    std::runtime_error);
+}
+
+}
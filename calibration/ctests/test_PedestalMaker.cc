@@ -0,0 +1,80 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/PedestalMaker.h"
+#include "doctest.h"
+#include <fstream>
+
+namespace sstcam::calibration {
+
+TEST_CASE("PedestalMaker") {
+    std::string path = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::ifstream file(path);
+    REQUIRE(file.good());
+    file.close();
+
+    io::TIOReader reader(path);
+
+    // Reference table, accumulated serially
+    PedestalTable expected(reader.GetNPixels());
+    for (size_t i = 0; i < reader.GetNEvents(); i++) {
+        expected.AddEvent(reader.GetEventR0(i));
+    }
+
+    SUBCASE("Default Threads") {
+        PedestalMaker maker;
+        CHECK(maker.GetNThreads() >= 1);
+        CHECK(maker.GetNThreads() <= PEDESTAL_MAKER_DEFAULT_MAX_THREADS);
+    }
+
+    SUBCASE("Single Thread") {
+        PedestalMaker maker(1);
+        CHECK(maker.GetNThreads() == 1);
+        PedestalTable table = maker.Process(reader);
+        CHECK(table.GetNEvents() == reader.GetNEvents());
+        CHECK(table.GetHitsVector() == expected.GetHitsVector());
+        CHECK(table.GetMeanVector() == expected.GetMeanVector());
+    }
+
+    SUBCASE("Multiple Threads") {
+        PedestalMaker maker(4, 2);
+        CHECK(maker.GetNThreads() == 4);
+        CHECK(maker.GetNEventsPerBlock() == 2);
+        PedestalTable table = maker.Process(reader);
+        CHECK(table.GetNEvents() == reader.GetNEvents());
+        CHECK(table.GetHitsVector() == expected.GetHitsVector());
+        bool matches = true;
+        for (size_t i = 0; i < table.GetNEntries(); i++) {
+            const auto& a = table.GetStatistics()[i];
+            const auto& b = expected.GetStatistics()[i];
+            if (std::abs(a.mean - b.mean) > 1e-3f) matches = false;
+            if (std::abs(a.GetStdDev() - b.GetStdDev()) > 1e-3f) matches = false;
+        }
+        CHECK(matches);
+    }
+
+    SUBCASE("Range") {
+        PedestalMaker maker(2, 1);
+        PedestalTable table(reader.GetNPixels());
+        maker.Process(reader, table, 2, 3);
+        CHECK(table.GetNEvents() == 3);
+        maker.Process(reader, table, reader.GetNEvents(), 3);
+        CHECK(table.GetNEvents() == 3);
+    }
+
+    SUBCASE("Mismatched Table") {
+        PedestalMaker maker;
+        PedestalTable table(reader.GetNPixels() * 2);
+        CHECK_THROWS_AS(maker.Process(reader, table), std::runtime_error);
+    }
+
+    SUBCASE("R1 File") {
+        io::TIOReader reader_r1("../../share/sstcam/io/targetmodule_r1.tio");
+        PedestalMaker maker;
+        CHECK_THROWS_AS(maker.Process(reader_r1), std::runtime_error);
+    }
+}
+
+}
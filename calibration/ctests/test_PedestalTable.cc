@@ -0,0 +1,146 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/PedestalTable.h"
+#include "sstcam/calibration/Calibrator.h"
+#include "doctest.h"
+#include <fstream>
+#include <vector>
+
+namespace sstcam::calibration {
+
+using namespace descriptions;
+
+TEST_CASE("PedestalCellStatistics") {
+    std::vector<float> samples = {500, 502, 497, 510, 499, 503, 501};
+    PedestalCellStatistics all, first, second;
+    for (size_t i = 0; i < samples.size(); i++) {
+        all.Add(samples[i]);
+        (i < 3 ? first : second).Add(samples[i]);
+    }
+    double mean = 0, variance = 0;
+    for (float s : samples) mean += s;
+    mean /= samples.size();
+    for (float s : samples) variance += (s - mean) * (s - mean);
+    variance /= samples.size() - 1;
+
+    CHECK(all.n_hits == samples.size());
+    CHECK(all.mean == doctest::Approx(mean));
+    CHECK(all.GetVariance() == doctest::Approx(variance));
+
+    first.Merge(second);
+    CHECK(first.n_hits == all.n_hits);
+    CHECK(first.mean == doctest::Approx(mean));
+    CHECK(first.GetVariance() == doctest::Approx(variance));
+
+    PedestalCellStatistics empty;
+    CHECK(empty.GetVariance() == 0);
+    empty.Merge(all);
+    CHECK(empty.mean == all.mean);
+}
+
+TEST_CASE("PedestalTable") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+    file.read(reinterpret_cast<char*>(packet->GetDataPacket()), packet_size);
+
+    std::set<uint8_t> active_module_slots = {packet->GetSlotID()};
+    size_t n_samples = packet->GetWaveformNSamples();
+    size_t n_pixels;
+    uint8_t first_active_module_slot;
+    GetHardcodedModuleSituation(active_module_slots, n_pixels, first_active_module_slot);
+
+    WaveformEventR0 event(1, n_pixels, first_active_module_slot);
+    event.AddPacket(packet.get());
+    uint16_t first_cell = packet->GetFirstCellID();
+    Waveform waveform;
+    waveform.Associate(*packet, 0);
+    uint16_t pixel = waveform.GetPixelID();
+
+    PedestalTable table(n_pixels);
+    CHECK(table.GetNPixels() == n_pixels);
+    CHECK(table.GetNEntries() == n_pixels * N_STORAGE_CELLS);
+
+    SUBCASE("Add Event") {
+        table.AddEvent(event);
+        table.AddEvent(event);
+        CHECK(table.GetNEvents() == 2);
+        for (uint16_t isample = 0; isample < n_samples; isample++) {
+            const auto& statistics = table.GetStatistics(pixel, first_cell + isample);
+            CHECK(statistics.n_hits == 2);
+            CHECK(statistics.mean == GetSampleR0(waveform, isample));
+            CHECK(statistics.GetVariance() == 0);
+        }
+        CHECK(table.GetStatistics(pixel, first_cell - 1).n_hits == 0);
+        CHECK(table.GetStatistics(pixel, first_cell + n_samples).n_hits == 0);
+
+        std::vector<uint32_t> hits = table.GetHitsVector();
+        CHECK(static_cast<size_t>(std::count(hits.begin(), hits.end(), 2u)) ==
+              packet->GetNWaveforms() * n_samples);
+
+        Calibrator calibrator(n_pixels);
+        calibrator.SetPedestals(table);
+        std::vector<float> calibrated = calibrator.GetPedestalSubtractedVector(event);
+        CHECK(std::all_of(calibrated.begin(), calibrated.end(),
+                          [](float s) { return s == 0; }));
+
+        table.Reset();
+        CHECK(table.GetNEvents() == 0);
+        CHECK(table.GetStatistics(pixel, first_cell).n_hits == 0);
+    }
+
+    SUBCASE("Merge") {
+        std::vector<PedestalTable> partials(3, PedestalTable(n_pixels));
+        partials[0].AddEvent(event);
+        partials[2].AddEvent(event);
+        table.AddEvent(event);
+        table.Merge(partials, 4);
+        CHECK(table.GetNEvents() == 3);
+        CHECK(table.GetStatistics(pixel, first_cell).n_hits == 3);
+        CHECK(table.GetStatistics(pixel, first_cell).mean == GetSampleR0(waveform, 0));
+
+        PedestalTable serial(n_pixels);
+        for (const auto& partial : partials) serial.Merge(partial);
+        serial.AddEvent(event);
+        CHECK(serial.GetHitsVector() == table.GetHitsVector());
+        CHECK(serial.GetMeanVector() == table.GetMeanVector());
+
+        PedestalTable other(n_pixels * 2);
+        CHECK_THROWS_AS(table.Merge(other), std::runtime_error);
+    }
+
+    SUBCASE("Storage Array Wrap") {
+        packet->GetDataPacket()[14] = (packet->GetDataPacket()[14] & 0xC0u) | 63u;
+        packet->GetDataPacket()[15] = 0xE0u | 31u;
+        table.AddEvent(event);
+        CHECK(table.GetStatistics(pixel, N_STORAGE_CELLS - 1).mean == GetSampleR0(waveform, 0));
+        CHECK(table.GetStatistics(pixel, 0).mean == GetSampleR0(waveform, 1));
+        CHECK(table.GetStatistics(pixel, n_samples - 2).n_hits == 1);
+        CHECK(table.GetStatistics(pixel, n_samples - 1).n_hits == 0);
+    }
+
+    SUBCASE("Mismatched Event") {
+        PedestalTable other(n_pixels * 2);
+        CHECK_THROWS_AS(other.AddEvent(event), std::runtime_error);
+        Calibrator calibrator(n_pixels * 2);
+        CHECK_THROWS_AS(calibrator.SetPedestals(table), std::runtime_error);
+    }
+
+    SUBCASE("Zero-Suppressed Waveform") {
+        packet->GetDataPacket()[packet->GetWaveformStart(0) + 1] |= 0x80u;
+        REQUIRE(waveform.IsZeroSuppressed());
+        PedestalTable suppressed(n_pixels);
+        suppressed.AddEvent(event);
+        CHECK(suppressed.GetStatistics(pixel, packet->GetFirstCellID()).n_hits == 0);
+        std::vector<uint32_t> hits = suppressed.GetHitsVector();
+        CHECK(static_cast<size_t>(std::count(hits.begin(), hits.end(), 1u)) ==
+              (packet->GetNWaveforms() - 1u) * n_samples);
+    }
+}
+
+}
@@ -0,0 +1,222 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/calibration/TransferFunction.h"
+#include "sstcam/calibration/Calibrator.h"
+#include "doctest.h"
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+namespace sstcam::calibration {
+
+using namespace descriptions;
+
+// Nonlinear transfer function, distinct for each pixel and cell group
+float ExampleTF(size_t pixel, size_t group, int32_t adc) {
+    return 0.5f * adc + 1e-4f * adc * adc + pixel + 0.25f * group;
+}
+
+TEST_CASE("TransferFunction") {
+    size_t n_pixels = 64;
+    int32_t adc_min = -100;
+    size_t n_adc = 4196;
+
+    SUBCASE("Construction") {
+        TransferFunction tf(n_pixels, adc_min, n_adc, 4);
+        CHECK(tf.GetNPixels() == n_pixels);
+        CHECK(tf.GetADCMin() == adc_min);
+        CHECK(tf.GetNADC() == n_adc);
+        CHECK(tf.GetNCellGroups() == 4);
+        CHECK(tf.GetTables().size() == n_pixels * 4 * n_adc);
+        CHECK(tf.GetCellGroup(0) == 0);
+        CHECK(tf.GetCellGroup(4095) == 0);
+        CHECK(tf.GetCellGroup(4096) == 1);
+        CHECK(tf.GetCellGroup(N_STORAGE_CELLS - 1) == 3);
+        CHECK_THROWS_AS(TransferFunction(n_pixels, 0, 4096, 3), std::runtime_error);
+        CHECK_THROWS_AS(TransferFunction(n_pixels, 0, 4096, 0), std::runtime_error);
+        CHECK_THROWS_AS(TransferFunction(n_pixels, 0, 0), std::runtime_error);
+        CHECK_THROWS_AS(TransferFunction(n_pixels, 0, 4096, 2 * N_STORAGE_CELLS),
+                        std::runtime_error);
+    }
+
+    SUBCASE("Tables") {
+        TransferFunction tf(n_pixels, adc_min, n_adc, 2);
+        std::vector<float> tables(n_pixels * 2 * n_adc);
+        for (size_t pixel = 0; pixel < n_pixels; pixel++) {
+            for (size_t group = 0; group < 2; group++) {
+                for (size_t i = 0; i < n_adc; i++) {
+                    tables[(pixel * 2 + group) * n_adc + i] = ExampleTF(pixel, group, adc_min + i);
+                }
+            }
+        }
+        tf.SetTables(tables.data());
+        CHECK(tf.GetTables() == tables);
+        CHECK(tf.GetTable(3, 1)[10] == ExampleTF(3, 1, adc_min + 10));
+        CHECK(tf.Lookup(3, N_STORAGE_CELLS - 1, 10.4f) == ExampleTF(3, 1, 10));
+        CHECK(tf.Lookup(3, 0, 10.6f) == ExampleTF(3, 0, 11));
+        CHECK(tf.Lookup(3, 0, -1000) == ExampleTF(3, 0, adc_min));
+        CHECK(tf.Lookup(3, 0, 1e9) == ExampleTF(3, 0, adc_min + n_adc - 1));
+        CHECK(tf.Lookup(3, 0, std::numeric_limits<float>::quiet_NaN()) ==
+              ExampleTF(3, 0, adc_min));
+
+        std::vector<float> table(n_adc, 7);
+        tf.SetTable(5, 1, table.data());
+        CHECK(tf.Lookup(5, N_STORAGE_CELLS - 1, 200) == 7);
+        CHECK(tf.Lookup(5, 0, 200) == ExampleTF(5, 0, 200));
+        CHECK_THROWS_AS(tf.SetTable(5, 2, table.data()), std::out_of_range);
+        CHECK_THROWS_AS(tf.SetTable(n_pixels, 0, table.data()), std::out_of_range);
+    }
+
+    SUBCASE("Table From Points") {
+        TransferFunction tf(n_pixels, adc_min, n_adc);
+        std::vector<float> adc = {0, 100, 1000};
+        std::vector<float> mv = {0, 50, 950};
+        tf.SetTableFromPoints(2, 0, adc.data(), mv.data(), adc.size());
+        CHECK(tf.Lookup(2, 0, -50) == 0);
+        CHECK(tf.Lookup(2, 0, 0) == 0);
+        CHECK(tf.Lookup(2, 0, 40) == doctest::Approx(20));
+        CHECK(tf.Lookup(2, 0, 100) == doctest::Approx(50));
+        CHECK(tf.Lookup(2, 0, 550) == doctest::Approx(500));
+        CHECK(tf.Lookup(2, 0, 3000) == 950);
+
+        std::vector<float> unordered = {0, 100, 50};
+        CHECK_THROWS_AS(tf.SetTableFromPoints(2, 0, unordered.data(), mv.data(), 3),
+                        std::runtime_error);
+        CHECK_THROWS_AS(tf.SetTableFromPoints(2, 0, adc.data(), mv.data(), 0),
+                        std::runtime_error);
+    }
+
+    SUBCASE("Kernels") {
+        std::vector<float> table(n_adc);
+        for (size_t i = 0; i < n_adc; i++) table[i] = ExampleTF(0, 0, adc_min + i);
+        auto adc_min_f = static_cast<float>(adc_min);
+        auto adc_max_f = static_cast<float>(adc_min + n_adc - 1);
+
+        // Samples across and beyond the range of the table
+        size_t n_samples = 67;
+        std::vector<uint16_t> r0(n_samples);
+        std::vector<float> r1(n_samples);
+        for (size_t i = 0; i < n_samples; i++) {
+            r0[i] = static_cast<uint16_t>(i * 97);
+            r1[i] = -150.f + i * 71.3f;
+        }
+        r1[5] = std::numeric_limits<float>::quiet_NaN();
+
+        std::vector<float> expected_r0(n_samples), expected_r1(n_samples);
+        auto scalar_r0 = GetApplyTransferFunctionFunction<uint16_t>(SampleUnpackingKernel::SCALAR);
+        auto scalar_r1 = GetApplyTransferFunctionFunction<float>(SampleUnpackingKernel::SCALAR);
+        scalar_r0(r0.data(), table.data(), expected_r0.data(), n_samples, adc_min_f, adc_max_f);
+        scalar_r1(r1.data(), table.data(), expected_r1.data(), n_samples, adc_min_f, adc_max_f);
+        CHECK(expected_r0[3] == ExampleTF(0, 0, 3 * 97));
+        CHECK(expected_r1[0] == ExampleTF(0, 0, adc_min));
+        CHECK(expected_r1[5] == ExampleTF(0, 0, adc_min));
+        CHECK(expected_r1[n_samples - 1] == ExampleTF(0, 0, adc_min + n_adc - 1));
+
+        for (auto kernel : {SampleUnpackingKernel::SSE4, SampleUnpackingKernel::AVX2,
+                            SampleUnpackingKernel::AVX512}) {
+            if (!IsSampleUnpackingKernelSupported(kernel)) {
+                CHECK_THROWS_AS(GetApplyTransferFunctionFunction<float>(kernel),
+                                std::runtime_error);
+                continue;
+            }
+            auto apply_r0 = GetApplyTransferFunctionFunction<uint16_t>(kernel);
+            auto apply_r1 = GetApplyTransferFunctionFunction<float>(kernel);
+            std::vector<float> output(n_samples);
+            apply_r0(r0.data(), table.data(), output.data(), n_samples, adc_min_f, adc_max_f);
+            CHECK(output == expected_r0);
+            apply_r1(r1.data(), table.data(), output.data(), n_samples, adc_min_f, adc_max_f);
+            CHECK(output == expected_r1);
+
+            // In place
+            std::vector<float> samples = r1;
+            apply_r1(samples.data(), table.data(), samples.data(), n_samples, adc_min_f, adc_max_f);
+            CHECK(samples == expected_r1);
+        }
+    }
+
+    SUBCASE("Apply To Event") {
+        std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+        size_t packet_size = 8276;
+        std::ifstream file (path, std::ios::in | std::ios::binary);
+        CHECK(file.is_open());
+        auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+        file.read(reinterpret_cast<char*>(packet->GetDataPacket()), packet_size);
+        std::set<uint8_t> active_module_slots = {packet->GetSlotID()};
+        uint8_t first_active_module_slot;
+        GetHardcodedModuleSituation(active_module_slots, n_pixels, first_active_module_slot);
+        WaveformEventR0 event(1, n_pixels, first_active_module_slot);
+        event.AddPacket(packet.get());
+        size_t n_samples = event.GetNSamples();
+
+        // Groups of 64 cells, so that the waveforms span several groups
+        size_t n_cell_groups = N_STORAGE_CELLS / 64;
+        TransferFunction tf(n_pixels, 0, 4096, n_cell_groups);
+        std::vector<float> tables(tf.GetTables().size());
+        for (size_t pixel = 0; pixel < n_pixels; pixel++) {
+            for (size_t group = 0; group < n_cell_groups; group++) {
+                for (size_t i = 0; i < 4096; i++) {
+                    tables[(pixel * n_cell_groups + group) * 4096 + i] = ExampleTF(pixel, group, i);
+                }
+            }
+        }
+        tf.SetTables(tables.data());
+
+        std::vector<uint16_t> adc = event.GetWaveformSamplesVector();
+        std::vector<float> mv(n_pixels * n_samples);
+        uint16_t first_cell = event.GetFirstCellID();
+        REQUIRE(first_cell % 64 != 0);
+        tf.Apply(adc.data(), mv.data(), n_samples, first_cell);
+        bool matches = true;
+        for (size_t pixel = 0; pixel < n_pixels; pixel++) {
+            for (size_t isample = 0; isample < n_samples; isample++) {
+                uint16_t cell = (first_cell + isample) % N_STORAGE_CELLS;
+                float expected = tf.Lookup(pixel, cell, adc[pixel * n_samples + isample]);
+                if (mv[pixel * n_samples + isample] != expected) matches = false;
+            }
+        }
+        CHECK(matches);
+
+        // Pedestal-subtracted samples, converted in place
+        Calibrator calibrator(n_pixels);
+        std::vector<float> pedestals(n_pixels * N_STORAGE_CELLS, 100);
+        calibrator.SetPedestals(pedestals.data());
+        std::vector<float> samples = calibrator.GetPedestalSubtractedVector(event);
+        std::vector<float> subtracted = samples;
+        tf.Apply(samples.data(), samples.data(), n_samples, first_cell);
+        matches = true;
+        for (size_t pixel = 0; pixel < n_pixels; pixel++) {
+            for (size_t isample = 0; isample < n_samples; isample++) {
+                uint16_t cell = (first_cell + isample) % N_STORAGE_CELLS;
+                size_t i = pixel * n_samples + isample;
+                if (samples[i] != tf.Lookup(pixel, cell, subtracted[i])) matches = false;
+            }
+        }
+        CHECK(matches);
+
+        // Converted from the first cell of the packet, only for its waveforms
+        std::vector<float> mv_event(samples.size(), -1);
+        tf.Apply(event, subtracted.data(), mv_event.data());
+        std::vector<bool> present(n_pixels, false);
+        Waveform waveform;
+        for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++) {
+            waveform.Associate(*packet, iwav);
+            present[(packet->GetSlotID() - first_active_module_slot) *
+                    N_PIXELS_PER_MODULE + waveform.GetPixelID()] = true;
+        }
+        matches = true;
+        for (size_t i = 0; i < samples.size(); i++) {
+            float expected = present[i / n_samples] ? samples[i] : -1;
+            if (mv_event[i] != expected) matches = false;
+        }
+        CHECK(matches);
+        TransferFunction other(n_pixels / 2);
+        CHECK_THROWS_AS(other.Apply(event, subtracted.data(), mv_event.data()),
+                        std::runtime_error);
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_CALIBRATION_BATCHCALIBRATOR_H
+#define SSTCAM_CALIBRATION_BATCHCALIBRATOR_H
+
+#include "sstcam/calibration/Calibrator.h"
+#include "sstcam/calibration/TransferFunction.h"
+#include "sstcam/io/TIOReader.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace sstcam {
+namespace calibration {
+
+/*!
+ * @class BatchCalibrator
+ * @brief Calibrates ranges of R0 events into a contiguous
+ * [n_events][n_pixels][n_samples] float array, using a pool of worker
+ * threads. Each task calibrates a single event into its slice of the array:
+ * the event is read, its pedestal is subtracted by the Calibrator, and it is
+ * optionally converted to mV by a TransferFunction. The tasks are claimed by
+ * the workers in turn, so the cores are kept busy even if some events take
+ * longer to read than others.
+ *
+ * Pixels without a waveform in an event (e.g. missing packets or zero
+ * suppression), including every pixel of an event without any packets,
+ * are filled with zeros.
+ *
+ * The Calibrator and TransferFunction must outlive the BatchCalibrator.
+ */
+class BatchCalibrator {
+public:
+    /*!
+     * @param calibrator
+     * Calibrator used to subtract the pedestals.
+     * @param transfer_function
+     * Optional TransferFunction applied after the pedestal subtraction (must
+     * have the same number of pixels as the calibrator).
+     * @param n_threads
+     * Number of threads used to calibrate the events, including the calling
+     * thread (0 for the number of hardware threads).
+     */
+    explicit BatchCalibrator(const Calibrator& calibrator,
+        const TransferFunction* transfer_function=nullptr, size_t n_threads=0);
+
+    // Number of threads used to calibrate the events.
+    [[nodiscard]] inline size_t GetNThreads() const { return n_threads_; }
+
+    // Number of pixels of the events that are calibrated.
+    [[nodiscard]] inline size_t GetNPixels() const { return calibrator_.GetNPixels(); }
+
+    /*!
+     * @brief Calibrate a range of events of an R0 file.
+     * @param reader
+     * Reader of the R0 file. The number of pixels of the file must match the
+     * calibrator.
+     * @param output
+     * [n_events][n_pixels][n_samples] array to fill, where n_samples is
+     * obtained from the reader. No range checks are included.
+     * @param first_event_index
+     * Index of the first event to calibrate.
+     * @param n_events
+     * Number of events to calibrate. Must not extend beyond the end of the
+     * file.
+     */
+    void FillCalibratedArray(const io::TIOReader& reader, float* output,
+        size_t first_event_index, size_t n_events) const;
+
+    // Calibrate events that have already been read into a
+    // [n_events][n_pixels][n_samples] array, where n_samples is obtained
+    // from the first event with packets (nothing is filled if there is none).
+    void FillCalibratedArray(const std::vector<descriptions::WaveformEventR0>& events,
+        float* output) const;
+
+private:
+    const Calibrator& calibrator_;
+    const TransferFunction* transfer_function_;
+    size_t n_threads_;
+
+    // Calibrate a single event into its slice of the output.
+    void CalibrateEvent(const descriptions::WaveformEventR0& event,
+        size_t n_samples, float* output) const;
+
+    // Run a task for each event index in [0, n_events) on the worker threads.
+    void RunTasks(size_t n_events, const std::function<void(size_t)>& task) const;
+};
+
+}}
+
+
+#endif //SSTCAM_CALIBRATION_BATCHCALIBRATOR_H
@@ -4,9 +4,115 @@
 #ifndef SSTCAM_CALIBRATION_CALIBRATOR_H
 #define SSTCAM_CALIBRATION_CALIBRATOR_H
 
+#include "sstcam/calibration/PedestalTable.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include <cstdint>
+#include <vector>
+
 namespace sstcam {
 namespace calibration {
 
+/*!
+ * @brief Signature of a kernel that unpacks the 12bit R0 samples of a
+ * waveform and subtracts the pedestal of the storage cell of each sample.
+ */
+using SubtractPedestalFunction = void (*)(const uint8_t* data,
+    const float* pedestal, float* samples, size_t n_samples);
+
+// Obtain the pedestal subtraction kernel for the instruction set. The
+// kernel must be supported by the CPU (see
+// descriptions::IsSampleUnpackingKernelSupported).
+SubtractPedestalFunction GetSubtractPedestalFunction(
+    descriptions::SampleUnpackingKernel kernel);
+
+/*!
+ * @class Calibrator
+ * @brief Converts R0 events into R1 waveform samples, subtracting a pedestal
+ * for each pixel and storage cell while the samples are decoded. The
+ * pedestal of sample i of a waveform is obtained from the cell
+ * (first_cell_id + i) % N_STORAGE_CELLS, where first_cell_id is given by the
+ * WaveformDataPacket. The conversion does not allocate memory.
+ */
+class Calibrator {
+public:
+    /*!
+     * @param n_pixels
+     * Number of pixels in the events that are calibrated (see
+     * descriptions::GetHardcodedModuleSituation).
+     */
+    explicit Calibrator(size_t n_pixels=descriptions::DEFAULT_N_MODULES *
+        descriptions::N_PIXELS_PER_MODULE);
+
+    // Number of pixels covered by the pedestal tables.
+    [[nodiscard]] inline size_t GetNPixels() const { return n_pixels_; }
+
+    // Set the pedestal tables of every pixel, from a
+    // [n_pixels][N_STORAGE_CELLS] array.
+    void SetPedestals(const float* pedestals);
+
+    // Set the pedestal tables of every pixel from the mean of each entry of a
+    // PedestalTable with the same number of pixels.
+    void SetPedestals(const PedestalTable& table);
+
+    // Set the pedestal table of a pixel, from a [N_STORAGE_CELLS] array.
+    void SetPixelPedestal(uint16_t pixel, const float* pedestal);
+
+    // Pedestal of a pixel for a storage cell.
+    [[nodiscard]] inline float GetPedestal(uint16_t pixel, uint16_t cell) const {
+        return pedestals_[pixel * N_STORAGE_CELLS + cell];
+    }
+
+    // Pedestal tables of every pixel ([n_pixels][N_STORAGE_CELLS]).
+    [[nodiscard]] inline const std::vector<float>& GetPedestals() const {
+        return pedestals_;
+    }
+
+    /*!
+     * @brief Fill a supplied [n_pixels][n_samples] array with the
+     * pedestal-subtracted waveform samples of an R0 event. The samples of
+     * each waveform are decoded and subtracted in a single pass. Pixels
+     * without a waveform in the event, or whose waveform is zero-suppressed,
+     * are not written.
+     * @param event
+     * R0 event with the same number of pixels as the Calibrator.
+     * @param samples
+     * Array to fill. No range checks are included.
+     */
+    void FillPedestalSubtractedArray(const descriptions::WaveformEventR0& event,
+        float* samples) const;
+
+    /*!
+     * @brief Fill the pedestal-subtracted waveform samples of a single
+     * packet into the [N_PIXELS_PER_MODULE][n_samples] array of its module.
+     * Used to calibrate an event module by module, without materializing
+     * the samples of the whole event. Zero-suppressed waveforms are not
+     * written.
+     * @param packet
+     * Packet to calibrate.
+     * @param module
+     * Index of the packet's module within the event (slot ID minus the
+     * first active module slot). Must be less than n_pixels /
+     * N_PIXELS_PER_MODULE.
+     * @param n_samples
+     * Number of samples in the waveforms of the packet.
+     * @param module_samples
+     * Array of the module to fill. No range checks are included.
+     */
+    void FillPedestalSubtractedPacket(const descriptions::WaveformDataPacket& packet,
+        size_t module, size_t n_samples, float* module_samples) const;
+
+    // Get the pedestal-subtracted waveforms of an R0 event as a contiguous
+    // 1D vector.
+    [[nodiscard]] std::vector<float> GetPedestalSubtractedVector(
+        const descriptions::WaveformEventR0& event) const;
+
+private:
+    size_t n_pixels_;
+    std::vector<float> pedestals_;
+    SubtractPedestalFunction subtract_pedestal_;
+};
+
 }}
 
 
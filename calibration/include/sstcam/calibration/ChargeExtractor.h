@@ -0,0 +1,177 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_CALIBRATION_CHARGEEXTRACTOR_H
+#define SSTCAM_CALIBRATION_CHARGEEXTRACTOR_H
+
+#include "sstcam/calibration/Calibrator.h"
+#include "sstcam/calibration/TransferFunction.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include <cstdint>
+#include <vector>
+
+namespace sstcam {
+namespace calibration {
+
+/*!
+ * @brief Choice of the window of samples that is integrated into the charge
+ * of a waveform.
+ */
+enum class ChargeExtractionMethod {
+    FIXED_WINDOW, // [window_offset, window_offset + window_width) for every pixel
+    SLIDING_WINDOW, // Window of window_width samples with the largest sum
+    NEIGHBOUR_PEAK // Window starting window_offset samples before the peak
+                   // of the summed waveforms of the neighbouring pixels
+};
+
+/*!
+ * @brief Signature of a kernel that extracts the charge and peak time of a
+ * block of pixels, with the samples stored as [n_samples][stride]. The
+ * pixels are processed in parallel across the lanes of the SIMD registers.
+ * @param samples
+ * Samples of the block of pixels (sample i of pixel j at i * stride + j).
+ * @param reference
+ * Waveforms whose peak positions the windows of NEIGHBOUR_PEAK, in the same
+ * layout as the samples. Not used by the other methods (may be nullptr).
+ * @param n_samples
+ * Number of samples in each waveform.
+ * @param n_pixels
+ * Number of pixels in the block (no larger than stride).
+ * @param stride
+ * Distance between consecutive samples of a pixel.
+ * @param method
+ * Method used to position the window.
+ * @param width
+ * Number of samples in the window. Must be in [1, n_samples].
+ * @param offset
+ * Start of the window for FIXED_WINDOW (offset + width must be no larger
+ * than n_samples), or its shift before the peak for NEIGHBOUR_PEAK.
+ * @param charge
+ * [n_pixels] array filled with the sum of the samples in the window.
+ * @param time
+ * [n_pixels] array filled with the peak time (in samples): the mean sample
+ * index in the window, weighted by the positive samples. The centre of the
+ * window is used if the window has no positive samples.
+ */
+using ExtractChargeFunction = void (*)(const float* samples,
+    const float* reference, size_t n_samples, size_t n_pixels, size_t stride,
+    ChargeExtractionMethod method, size_t width, size_t offset,
+    float* charge, float* time);
+
+// Obtain the charge extraction kernel for the instruction set. The kernel
+// must be supported by the CPU (see
+// descriptions::IsSampleUnpackingKernelSupported).
+ExtractChargeFunction GetExtractChargeFunction(
+    descriptions::SampleUnpackingKernel kernel);
+
+/*!
+ * @class ChargeExtractor
+ * @brief Reduces each waveform of an event to a charge and a peak time.
+ *
+ * The kernels operate on tiles of N_PIXELS_PER_MODULE pixels stored sample
+ * major, so that each SIMD register holds the same sample of several pixels
+ * and the window search is performed for all of them at once. Pixel-major
+ * samples are transposed one tile at a time. Events can also be extracted
+ * directly from their R0 packets, calibrating one module at a time into a
+ * tile, so that the calibrated waveforms of the whole event are never
+ * materialized.
+ *
+ * NEIGHBOUR_PEAK requires the samples of the neighbouring pixels, which can
+ * belong to other modules, so the whole event is transposed (or calibrated)
+ * into a working array for it.
+ */
+class ChargeExtractor {
+public:
+    /*!
+     * @param method
+     * Method used to position the window.
+     * @param window_width
+     * Number of samples integrated.
+     * @param window_offset
+     * Start of the window for FIXED_WINDOW, or the number of samples the
+     * window starts before the peak for NEIGHBOUR_PEAK. The window is
+     * shifted to remain inside the waveform.
+     * @param neighbours
+     * Neighbours of each pixel, required by NEIGHBOUR_PEAK (which can then
+     * only be used for events with neighbours.size() pixels). A pixel is only
+     * included in its own sum if it is listed as one of its neighbours.
+     */
+    ChargeExtractor(ChargeExtractionMethod method, size_t window_width,
+        size_t window_offset=0,
+        const std::vector<std::vector<uint16_t>>& neighbours={});
+
+    [[nodiscard]] inline ChargeExtractionMethod GetMethod() const { return method_; }
+    [[nodiscard]] inline size_t GetWindowWidth() const { return window_width_; }
+    [[nodiscard]] inline size_t GetWindowOffset() const { return window_offset_; }
+
+    // Number of pixels described by the neighbours (0 if none were given).
+    [[nodiscard]] inline size_t GetNNeighbourPixels() const {
+        return neighbour_offsets_.empty() ? 0 : neighbour_offsets_.size() - 1;
+    }
+
+    /*!
+     * @brief Extract the charge and peak time of every pixel from an array of
+     * waveform samples (e.g. filled by Calibrator::FillPedestalSubtractedArray
+     * or WaveformEvent::FillWaveformSamplesArray).
+     * @param samples
+     * Samples of every pixel, in the given layout.
+     * @param n_pixels
+     * Number of pixels. Must be a multiple of N_PIXELS_PER_MODULE for
+     * SampleLayout::MODULE_TILES.
+     * @param n_samples
+     * Number of samples in each waveform.
+     * @param charge
+     * [n_pixels] array to fill. No range checks are included.
+     * @param time
+     * [n_pixels] array to fill. No range checks are included.
+     * @param layout
+     * Layout of the samples.
+     */
+    void Extract(const float* samples, size_t n_pixels, size_t n_samples,
+        float* charge, float* time,
+        descriptions::SampleLayout layout=descriptions::SampleLayout::PIXEL_MAJOR) const;
+
+    /*!
+     * @brief Calibrate an R0 event and extract the charge and peak time of
+     * every pixel in the same pass. Each module is pedestal subtracted (and
+     * optionally converted to mV) into a tile that stays in cache while its
+     * charges are extracted. Pixels without a waveform in the event are
+     * treated as waveforms of zeros, as in BatchCalibrator.
+     * @param calibrator
+     * Calibrator used to subtract the pedestals.
+     * @param event
+     * R0 event with the same number of pixels as the calibrator.
+     * @param charge
+     * [n_pixels] array to fill. No range checks are included.
+     * @param time
+     * [n_pixels] array to fill. No range checks are included.
+     * @param transfer_function
+     * Optional TransferFunction applied after the pedestal subtraction (must
+     * have the same number of pixels as the calibrator).
+     */
+    void Extract(const Calibrator& calibrator,
+        const descriptions::WaveformEventR0& event, float* charge, float* time,
+        const TransferFunction* transfer_function=nullptr) const;
+
+private:
+    ChargeExtractionMethod method_;
+    size_t window_width_;
+    size_t window_offset_;
+    std::vector<size_t> neighbour_offsets_; // [n_pixels + 1] into neighbour_pixels_
+    std::vector<uint16_t> neighbour_pixels_;
+    ExtractChargeFunction extract_;
+
+    // Check that the window fits in waveforms of n_samples, and that the
+    // neighbours describe n_pixels pixels for NEIGHBOUR_PEAK.
+    void CheckDimensions(size_t n_pixels, size_t n_samples) const;
+
+    // Extract from [n_samples][n_pixels] samples.
+    void ExtractSampleMajor(const float* samples, size_t n_pixels,
+        size_t n_samples, float* charge, float* time) const;
+};
+
+}}
+
+
+#endif //SSTCAM_CALIBRATION_CHARGEEXTRACTOR_H
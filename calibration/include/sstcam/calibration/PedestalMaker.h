@@ -0,0 +1,80 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_CALIBRATION_PEDESTALMAKER_H
+#define SSTCAM_CALIBRATION_PEDESTALMAKER_H
+
+#include "sstcam/calibration/PedestalTable.h"
+#include "sstcam/io/TIOReader.h"
+#include <cstdint>
+#include <limits>
+
+namespace sstcam {
+namespace calibration {
+
+// Largest number of threads used by a PedestalMaker when the number of
+// threads is not specified, which bounds the memory of the partial tables.
+constexpr size_t PEDESTAL_MAKER_DEFAULT_MAX_THREADS = 4;
+
+/*!
+ * @class PedestalMaker
+ * @brief Generates a PedestalTable from the events of R0 TIO files. The
+ * events are streamed from the file in blocks (see TIOReader::GetEventsR0),
+ * which are claimed by the worker threads in turn. Each thread accumulates
+ * its blocks into its own partial table, and the partial tables are then
+ * combined with a reduction that is also split between the threads.
+ *
+ * Every thread other than the calling thread allocates a partial table (see
+ * PedestalTable for its size), so the memory grows with the number of
+ * threads.
+ */
+class PedestalMaker {
+public:
+    /*!
+     * @param n_threads
+     * Number of threads used to accumulate the events, including the calling
+     * thread (0 for the number of hardware threads, up to
+     * PEDESTAL_MAKER_DEFAULT_MAX_THREADS).
+     * @param n_events_per_block
+     * Number of events read from the file in a single call by a thread.
+     */
+    explicit PedestalMaker(size_t n_threads=0, size_t n_events_per_block=64);
+
+    // Number of threads used to accumulate the events.
+    [[nodiscard]] inline size_t GetNThreads() const { return n_threads_; }
+
+    // Number of events read from the file in a single call by a thread.
+    [[nodiscard]] inline size_t GetNEventsPerBlock() const {
+        return n_events_per_block_;
+    }
+
+    /*!
+     * @brief Accumulate the events of an R0 file into a table. Tables can be
+     * accumulated over several files of a run by calling this method for
+     * each file.
+     * @param reader
+     * Reader of the R0 file. The number of pixels of the file must match the
+     * table.
+     * @param table
+     * Table to accumulate the events into.
+     * @param first_event_index
+     * Index of the first event to accumulate.
+     * @param n_events
+     * Number of events to accumulate (defaults to the rest of the file).
+     */
+    void Process(const io::TIOReader& reader, PedestalTable& table,
+        size_t first_event_index=0,
+        size_t n_events=std::numeric_limits<size_t>::max()) const;
+
+    // Generate a table from the events of an R0 file.
+    [[nodiscard]] PedestalTable Process(const io::TIOReader& reader) const;
+
+private:
+    size_t n_threads_;
+    size_t n_events_per_block_;
+};
+
+}}
+
+
+#endif //SSTCAM_CALIBRATION_PEDESTALMAKER_H
@@ -0,0 +1,138 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_CALIBRATION_PEDESTALTABLE_H
+#define SSTCAM_CALIBRATION_PEDESTALTABLE_H
+
+#include "sstcam/descriptions/WaveformEvent.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace sstcam {
+namespace calibration {
+
+// Number of cells in the storage array of a TARGET ASIC channel
+// (64 columns x 8 rows x 32 block phases).
+constexpr uint16_t N_STORAGE_CELLS = 64 * 8 * descriptions::SAMPLES_PER_WAVEFORM_BLOCK;
+
+/*!
+ * @brief Running mean and variance of the samples read from a storage cell,
+ * accumulated with Welford's algorithm.
+ */
+struct PedestalCellStatistics {
+    uint32_t n_hits = 0;
+    float mean = 0;
+    float m2 = 0; // Sum of the squared differences from the mean
+
+    inline void Add(float sample) {
+        n_hits++;
+        float delta = sample - mean;
+        mean += delta / static_cast<float>(n_hits);
+        m2 += delta * (sample - mean);
+    }
+
+    // Combine with the statistics of another set of samples (Chan et al.).
+    inline void Merge(const PedestalCellStatistics& other) {
+        if (other.n_hits == 0) return;
+        if (n_hits == 0) {
+            *this = other;
+            return;
+        }
+        auto n_a = static_cast<float>(n_hits);
+        auto n_b = static_cast<float>(other.n_hits);
+        float n = n_a + n_b;
+        float delta = other.mean - mean;
+        mean += delta * n_b / n;
+        m2 += other.m2 + delta * delta * n_a * n_b / n;
+        n_hits += other.n_hits;
+    }
+
+    [[nodiscard]] inline float GetVariance() const {
+        return n_hits > 1 ? m2 / static_cast<float>(n_hits - 1) : 0;
+    }
+
+    [[nodiscard]] inline float GetStdDev() const {
+        return std::sqrt(GetVariance());
+    }
+};
+
+/*!
+ * @class PedestalTable
+ * @brief Pedestal statistics for every pixel and storage cell
+ * ([n_pixels][N_STORAGE_CELLS]), accumulated from R0 events. The sample i of
+ * a waveform is read from the cell (first_cell_id + i) % N_STORAGE_CELLS.
+ *
+ * A table is not thread-safe. To accumulate events from several threads,
+ * each thread fills its own table, and the tables are then combined with
+ * Merge (see PedestalMaker). Each table occupies
+ * n_pixels * N_STORAGE_CELLS * 12 bytes (~400 MB for a full camera).
+ */
+class PedestalTable {
+public:
+    /*!
+     * @param n_pixels
+     * Number of pixels in the events that are accumulated (see
+     * descriptions::GetHardcodedModuleSituation).
+     */
+    explicit PedestalTable(size_t n_pixels=descriptions::DEFAULT_N_MODULES *
+        descriptions::N_PIXELS_PER_MODULE);
+
+    // Number of pixels in the table.
+    [[nodiscard]] inline size_t GetNPixels() const { return n_pixels_; }
+
+    // Number of entries in the table (n_pixels * N_STORAGE_CELLS).
+    [[nodiscard]] inline size_t GetNEntries() const { return statistics_.size(); }
+
+    // Number of events accumulated into the table.
+    [[nodiscard]] inline size_t GetNEvents() const { return n_events_; }
+
+    // Accumulate the samples of an R0 event. Pixels without a waveform in the
+    // event, or whose waveform is zero-suppressed, are skipped.
+    void AddEvent(const descriptions::WaveformEventR0& event);
+
+    // Combine the statistics of another table with the same number of pixels.
+    void Merge(const PedestalTable& other);
+
+    // Combine the statistics of several tables with the same number of
+    // pixels, splitting the entries of the tables between n_threads threads.
+    // This table is skipped if it is contained in others.
+    void Merge(const std::vector<PedestalTable>& others, size_t n_threads);
+
+    // Clear the statistics of every entry.
+    void Reset();
+
+    // Statistics of a pixel for a storage cell.
+    [[nodiscard]] inline const PedestalCellStatistics& GetStatistics(
+            uint16_t pixel, uint16_t cell) const {
+        return statistics_[pixel * N_STORAGE_CELLS + cell];
+    }
+
+    // Statistics of every entry ([n_pixels][N_STORAGE_CELLS]).
+    [[nodiscard]] inline const std::vector<PedestalCellStatistics>& GetStatistics() const {
+        return statistics_;
+    }
+
+    // Mean of every entry ([n_pixels][N_STORAGE_CELLS]), in the format
+    // expected by Calibrator::SetPedestals.
+    [[nodiscard]] std::vector<float> GetMeanVector() const;
+
+    // Standard deviation of every entry ([n_pixels][N_STORAGE_CELLS]).
+    [[nodiscard]] std::vector<float> GetStdDevVector() const;
+
+    // Number of samples accumulated for every entry ([n_pixels][N_STORAGE_CELLS]).
+    [[nodiscard]] std::vector<uint32_t> GetHitsVector() const;
+
+private:
+    size_t n_pixels_;
+    size_t n_events_;
+    std::vector<PedestalCellStatistics> statistics_;
+    std::vector<uint16_t> buffer_; // Unpacked samples of a waveform
+
+    void CheckCompatible(const PedestalTable& other) const;
+};
+
+}}
+
+
+#endif //SSTCAM_CALIBRATION_PEDESTALTABLE_H
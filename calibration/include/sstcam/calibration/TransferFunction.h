@@ -0,0 +1,186 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_CALIBRATION_TRANSFERFUNCTION_H
+#define SSTCAM_CALIBRATION_TRANSFERFUNCTION_H
+
+#include "sstcam/calibration/PedestalTable.h"
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include <cstdint>
+#include <vector>
+
+namespace sstcam {
+namespace calibration {
+
+/*!
+ * @brief Signature of a kernel that converts samples into mV with a lookup
+ * table. Each sample is clamped to [adc_min, adc_max], rounded to the nearest
+ * integer, and replaced by the entry table[sample - adc_min]. The input and
+ * output may be the same array.
+ */
+template <typename T>
+using ApplyTransferFunctionFunction = void (*)(const T* input,
+    const float* table, float* output, size_t n_samples,
+    float adc_min, float adc_max);
+
+// Obtain the lookup kernel for the instruction set, for the uint16_t R0
+// samples of WaveformEventR0::FillWaveformSamplesArray, or the float
+// pedestal-subtracted samples of Calibrator::FillPedestalSubtractedArray.
+// The kernel must be supported by the CPU. There is no gather instruction in
+// SSE4, so the scalar kernel is returned for it.
+template <typename T>
+ApplyTransferFunctionFunction<T> GetApplyTransferFunctionFunction(
+    descriptions::SampleUnpackingKernel kernel);
+
+/*!
+ * @class TransferFunction
+ * @brief Dense ADC -> mV lookup tables for the nonlinear transfer function of
+ * each pixel, and optionally of each group of storage cells. Every integer
+ * ADC value in [adc_min, adc_min + n_adc) has an entry. Samples outside of
+ * the range are clamped to the first or last entry.
+ *
+ * The tables are stored as [n_pixels][n_cell_groups][n_adc] floats, so that
+ * the tables used by a pixel are contiguous. The samples are converted pixel
+ * by pixel, so the working set is a single table of a pixel (16 kB for
+ * n_adc = 4096) and its waveform, which stays in L1/L2 while the whole event
+ * is converted. The lookup is vectorized with the AVX2/AVX-512 gather
+ * instructions.
+ *
+ * The cell group of a sample is cell * n_cell_groups / N_STORAGE_CELLS,
+ * where the cell of sample i of a waveform is
+ * (first_cell_id + i) % N_STORAGE_CELLS.
+ */
+class TransferFunction {
+public:
+    /*!
+     * @param n_pixels
+     * Number of pixels in the events that are calibrated.
+     * @param adc_min
+     * ADC value of the first entry in the tables. Negative for
+     * pedestal-subtracted samples.
+     * @param n_adc
+     * Number of entries in each table.
+     * @param n_cell_groups
+     * Number of storage cell groups with their own table. Must be a power of
+     * two, no larger than N_STORAGE_CELLS.
+     */
+    TransferFunction(size_t n_pixels, int32_t adc_min=0, size_t n_adc=4096,
+        size_t n_cell_groups=1);
+
+    [[nodiscard]] inline size_t GetNPixels() const { return n_pixels_; }
+    [[nodiscard]] inline int32_t GetADCMin() const { return adc_min_; }
+    [[nodiscard]] inline size_t GetNADC() const { return n_adc_; }
+    [[nodiscard]] inline size_t GetNCellGroups() const { return n_cell_groups_; }
+
+    // Cell group of a storage cell.
+    [[nodiscard]] inline uint16_t GetCellGroup(uint16_t cell) const {
+        return static_cast<uint16_t>((cell % N_STORAGE_CELLS) >> group_shift_);
+    }
+
+    // Set every table, from a [n_pixels][n_cell_groups][n_adc] array.
+    void SetTables(const float* tables);
+
+    // Set the table of a pixel and cell group, from a [n_adc] array.
+    void SetTable(uint16_t pixel, uint16_t cell_group, const float* table);
+
+    /*!
+     * @brief Fill the table of a pixel and cell group by linear interpolation
+     * between measured points of the transfer function. The table is
+     * constant beyond the first and last points.
+     * @param adc
+     * ADC values of the points, in increasing order.
+     * @param mv
+     * Amplitude (mV) of the points.
+     * @param n_points
+     * Number of points.
+     */
+    void SetTableFromPoints(uint16_t pixel, uint16_t cell_group,
+        const float* adc, const float* mv, size_t n_points);
+
+    // Table of a pixel and cell group ([n_adc]).
+    [[nodiscard]] inline const float* GetTable(uint16_t pixel, uint16_t cell_group) const {
+        return &tables_[(pixel * n_cell_groups_ + cell_group) * n_adc_];
+    }
+
+    // Every table ([n_pixels][n_cell_groups][n_adc]).
+    [[nodiscard]] inline const std::vector<float>& GetTables() const { return tables_; }
+
+    // Look up the amplitude (mV) of a single sample.
+    [[nodiscard]] float Lookup(uint16_t pixel, uint16_t cell, float sample) const;
+
+    /*!
+     * @brief Convert the [n_pixels][n_samples] uint16_t samples filled by
+     * WaveformEventR0::FillWaveformSamplesArray (SampleLayout::PIXEL_MAJOR)
+     * into mV.
+     * @param adc
+     * Samples to convert.
+     * @param mv
+     * [n_pixels][n_samples] array to fill. No range checks are included.
+     * @param n_samples
+     * Number of samples in each waveform.
+     * @param first_cell_id
+     * Storage cell of the first sample of every waveform. Only used when
+     * there is more than one cell group. The packets of an event can start
+     * at different cells (see the event overload).
+     */
+    void Apply(const uint16_t* adc, float* mv, size_t n_samples,
+        uint16_t first_cell_id=0) const;
+
+    // Convert the [n_pixels][n_samples] pedestal-subtracted samples filled
+    // by Calibrator::FillPedestalSubtractedArray into mV. The conversion can
+    // be performed in place (samples == mv).
+    void Apply(const float* samples, float* mv, size_t n_samples,
+        uint16_t first_cell_id=0) const;
+
+    // Convert the [n_pixels][n_samples] pedestal-subtracted samples of the
+    // contiguous range of pixels [first_pixel, first_pixel + n_pixels), e.g.
+    // a module filled by Calibrator::FillPedestalSubtractedPacket.
+    void Apply(const float* samples, float* mv, size_t n_samples,
+        uint16_t first_cell_id, size_t first_pixel, size_t n_pixels) const;
+
+    /*!
+     * @brief Convert the [n_pixels][n_samples] pedestal-subtracted samples
+     * filled by Calibrator::FillPedestalSubtractedArray for an R0 event into
+     * mV. Each module is read out from its own position in the storage
+     * array, so the cells of each waveform are obtained from the first cell
+     * of its packet. Only the pixels written by the Calibrator are converted.
+     * The conversion can be performed in place (samples == mv).
+     * @param event
+     * R0 event the samples were filled from, with the same number of pixels
+     * as the TransferFunction.
+     * @param samples
+     * Samples to convert.
+     * @param mv
+     * [n_pixels][n_samples] array to fill. No range checks are included.
+     */
+    void Apply(const descriptions::WaveformEventR0& event, const float* samples,
+        float* mv) const;
+
+    // Convert the [N_PIXELS_PER_MODULE][n_samples] pedestal-subtracted
+    // samples of a module filled by Calibrator::FillPedestalSubtractedPacket
+    // into mV, for the pixels of the packet, using the first cell of the
+    // packet. The conversion can be performed in place.
+    void ApplyPacket(const descriptions::WaveformDataPacket& packet,
+        size_t module, size_t n_samples, const float* module_samples,
+        float* module_mv) const;
+
+private:
+    size_t n_pixels_;
+    int32_t adc_min_;
+    size_t n_adc_;
+    size_t n_cell_groups_;
+    uint16_t group_shift_; // log2(N_STORAGE_CELLS / n_cell_groups)
+    std::vector<float> tables_;
+    ApplyTransferFunctionFunction<uint16_t> apply_r0_;
+    ApplyTransferFunctionFunction<float> apply_float_;
+
+    template <typename T>
+    void ApplyTemplate(ApplyTransferFunctionFunction<T> apply, const T* input,
+        float* output, size_t n_samples, uint16_t first_cell_id,
+        size_t first_pixel, size_t n_pixels) const;
+};
+
+}}
+
+
+#endif //SSTCAM_CALIBRATION_TRANSFERFUNCTION_H
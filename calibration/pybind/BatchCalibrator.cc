@@ -0,0 +1,60 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/BatchCalibrator.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <optional>
+#include <stdexcept>
+
+namespace sstcam {
+namespace calibration {
+
+namespace py = pybind11;
+
+// Calibrate the events into a caller-provided [n_events, n_pixels, n_samples]
+// array, without holding the GIL
+void FillArray(const BatchCalibrator& batch, const io::TIOReader& reader,
+        py::array_t<float, py::array::c_style> array, size_t first_event_index) {
+    if (array.ndim() != 3 ||
+        static_cast<size_t>(array.shape(1)) != reader.GetNPixels() ||
+        static_cast<size_t>(array.shape(2)) != reader.GetNSamples()) {
+        throw std::runtime_error(
+            "Array must be float32 with the shape [n_events, n_pixels, n_samples]");
+    }
+    auto n_events = static_cast<size_t>(array.shape(0));
+    float* output = array.mutable_data();
+    py::gil_scoped_release release;
+    batch.FillCalibratedArray(reader, output, first_event_index, n_events);
+}
+
+void batch_calibrator(py::module &m) {
+    py::class_<BatchCalibrator> batch(m, "BatchCalibrator");
+    batch.def(py::init<const Calibrator&, const TransferFunction*, size_t>(),
+              py::arg("calibrator"), py::arg("transfer_function")=nullptr,
+              py::arg("n_threads")=0,
+              py::keep_alive<1, 2>(), py::keep_alive<1, 3>());
+    batch.def_property_readonly("n_threads", &BatchCalibrator::GetNThreads);
+    batch.def_property_readonly("n_pixels", &BatchCalibrator::GetNPixels);
+    batch.def("fill", FillArray, py::arg("reader"), py::arg("array").noconvert(),
+              py::arg("first_event_index")=0);
+    batch.def("get_array",
+        [](const BatchCalibrator& b, const io::TIOReader& reader,
+           size_t first_event_index, std::optional<size_t> n_events) {
+            size_t n_available = first_event_index < reader.GetNEvents() ?
+                reader.GetNEvents() - first_event_index : 0;
+            auto shape = std::vector<ptrdiff_t>{
+                static_cast<long>(n_events.value_or(n_available)),
+                static_cast<long>(reader.GetNPixels()),
+                static_cast<long>(reader.GetNSamples())};
+            auto array = py::array_t<float>(shape);
+            FillArray(b, reader, array, first_event_index);
+            return array;
+        },
+        py::arg("reader"), py::arg("first_event_index")=0,
+        py::arg("n_events")=py::none());
+}
+
+}  // namespace calibration
+}  // namespace sstcam
@@ -0,0 +1,52 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/Calibrator.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace sstcam {
+namespace calibration {
+
+namespace py = pybind11;
+
+void calibrator(py::module &m) {
+    py::module::import("sstcam.descriptions"); // Require the WaveformEvent wrappings
+    m.attr("N_STORAGE_CELLS") = N_STORAGE_CELLS;
+
+    py::class_<Calibrator> calibrator(m, "Calibrator");
+    calibrator.def(py::init<size_t>(), py::arg("n_pixels"));
+    calibrator.def_property_readonly("n_pixels", &Calibrator::GetNPixels);
+    calibrator.def("set_pedestals",
+        py::overload_cast<const PedestalTable&>(&Calibrator::SetPedestals));
+    calibrator.def("set_pedestals",
+        [](Calibrator& c, const py::array_t<float, py::array::c_style | py::array::forcecast>& pedestals) {
+            if (static_cast<size_t>(pedestals.size()) != c.GetNPixels() * N_STORAGE_CELLS) {
+                throw std::runtime_error("Pedestal array must have the shape [n_pixels, N_STORAGE_CELLS]");
+            }
+            c.SetPedestals(pedestals.data());
+        });
+    calibrator.def("get_pedestals",
+        [](const Calibrator& c) {
+            auto shape = std::vector<ptrdiff_t>{
+                static_cast<long>(c.GetNPixels()), N_STORAGE_CELLS};
+            auto array = py::array_t<float>(shape);
+            std::copy(c.GetPedestals().begin(), c.GetPedestals().end(), array.mutable_data());
+            return array;
+        });
+    calibrator.def("get_pedestal_subtracted_array",
+        [](const Calibrator& c, const descriptions::WaveformEventR0& event) {
+            auto shape = std::vector<ptrdiff_t>{
+                static_cast<long>(event.GetNPixels()),
+                static_cast<long>(event.GetNSamples())};
+            auto array = py::array_t<float>(shape);
+            std::fill_n(array.mutable_data(), array.size(), 0);
+            c.FillPedestalSubtractedArray(event, array.mutable_data());
+            return array;
+        });
+}
+
+}  // namespace calibration
+}  // namespace sstcam
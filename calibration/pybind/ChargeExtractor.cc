@@ -0,0 +1,85 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/ChargeExtractor.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <stdexcept>
+#include <utility>
+
+namespace sstcam {
+namespace calibration {
+
+namespace py = pybind11;
+using descriptions::SampleLayout;
+using descriptions::N_PIXELS_PER_MODULE;
+
+void charge_extractor(py::module &m) {
+    py::module::import("sstcam.descriptions"); // Require the SampleLayout wrapping
+
+    py::enum_<ChargeExtractionMethod>(m, "ChargeExtractionMethod")
+        .value("FIXED_WINDOW", ChargeExtractionMethod::FIXED_WINDOW)
+        .value("SLIDING_WINDOW", ChargeExtractionMethod::SLIDING_WINDOW)
+        .value("NEIGHBOUR_PEAK", ChargeExtractionMethod::NEIGHBOUR_PEAK);
+
+    py::class_<ChargeExtractor> extractor(m, "ChargeExtractor");
+    extractor.def(py::init<ChargeExtractionMethod, size_t, size_t,
+                           const std::vector<std::vector<uint16_t>>&>(),
+        py::arg("method"), py::arg("window_width"), py::arg("window_offset")=0,
+        py::arg("neighbours")=std::vector<std::vector<uint16_t>>{});
+    extractor.def_property_readonly("method", &ChargeExtractor::GetMethod);
+    extractor.def_property_readonly("window_width", &ChargeExtractor::GetWindowWidth);
+    extractor.def_property_readonly("window_offset", &ChargeExtractor::GetWindowOffset);
+    extractor.def("extract",
+        [](const ChargeExtractor& e,
+           const py::array_t<float, py::array::c_style | py::array::forcecast>& samples,
+           SampleLayout layout) {
+            size_t n_pixels = 0;
+            size_t n_samples = 0;
+            if (layout == SampleLayout::MODULE_TILES && samples.ndim() == 3 &&
+                    samples.shape(2) == N_PIXELS_PER_MODULE) {
+                n_pixels = static_cast<size_t>(samples.shape(0)) * N_PIXELS_PER_MODULE;
+                n_samples = static_cast<size_t>(samples.shape(1));
+            }
+            else if (layout == SampleLayout::PIXEL_MAJOR && samples.ndim() == 2) {
+                n_pixels = static_cast<size_t>(samples.shape(0));
+                n_samples = static_cast<size_t>(samples.shape(1));
+            }
+            else if (layout == SampleLayout::SAMPLE_MAJOR && samples.ndim() == 2) {
+                n_samples = static_cast<size_t>(samples.shape(0));
+                n_pixels = static_cast<size_t>(samples.shape(1));
+            }
+            else {
+                throw std::runtime_error("Samples array does not match the layout");
+            }
+            auto charge = py::array_t<float>(static_cast<long>(n_pixels));
+            auto time = py::array_t<float>(static_cast<long>(n_pixels));
+            {
+                py::gil_scoped_release release;
+                e.Extract(samples.data(), n_pixels, n_samples,
+                          charge.mutable_data(), time.mutable_data(), layout);
+            }
+            return std::make_pair(charge, time);
+        },
+        py::arg("samples"), py::arg("layout")=SampleLayout::PIXEL_MAJOR);
+    extractor.def("extract_event",
+        [](const ChargeExtractor& e, const Calibrator& calibrator,
+           const descriptions::WaveformEventR0& event,
+           const TransferFunction* transfer_function) {
+            auto n_pixels = static_cast<long>(calibrator.GetNPixels());
+            auto charge = py::array_t<float>(n_pixels);
+            auto time = py::array_t<float>(n_pixels);
+            {
+                py::gil_scoped_release release;
+                e.Extract(calibrator, event, charge.mutable_data(),
+                          time.mutable_data(), transfer_function);
+            }
+            return std::make_pair(charge, time);
+        },
+        py::arg("calibrator"), py::arg("event"),
+        py::arg("transfer_function")=nullptr);
+}
+
+}  // namespace calibration
+}  // namespace sstcam
@@ -0,0 +1,64 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/PedestalMaker.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <algorithm>
+
+namespace sstcam {
+namespace calibration {
+
+namespace py = pybind11;
+
+template<typename T>
+py::array_t<T> GetTableArray(const PedestalTable& table, const std::vector<T>& values) {
+    auto shape = std::vector<ptrdiff_t>{
+        static_cast<long>(table.GetNPixels()), N_STORAGE_CELLS};
+    auto array = py::array_t<T>(shape);
+    std::copy(values.begin(), values.end(), array.mutable_data());
+    return array;
+}
+
+void pedestal_table(py::module &m) {
+    py::class_<PedestalTable> table(m, "PedestalTable");
+    table.def(py::init<size_t>(), py::arg("n_pixels"));
+    table.def_property_readonly("n_pixels", &PedestalTable::GetNPixels);
+    table.def_property_readonly("n_events", &PedestalTable::GetNEvents);
+    table.def("add_event", &PedestalTable::AddEvent);
+    table.def("merge", py::overload_cast<const PedestalTable&>(&PedestalTable::Merge));
+    table.def("reset", &PedestalTable::Reset);
+    table.def_property_readonly("mean", [](const PedestalTable& t) {
+        return GetTableArray(t, t.GetMeanVector());
+    });
+    table.def_property_readonly("std", [](const PedestalTable& t) {
+        return GetTableArray(t, t.GetStdDevVector());
+    });
+    table.def_property_readonly("hits", [](const PedestalTable& t) {
+        return GetTableArray(t, t.GetHitsVector());
+    });
+}
+
+void pedestal_maker(py::module &m) {
+    py::module::import("sstcam.io"); // Require the TIOReader wrappings
+    m.attr("PEDESTAL_MAKER_DEFAULT_MAX_THREADS") = PEDESTAL_MAKER_DEFAULT_MAX_THREADS;
+    py::class_<PedestalMaker> maker(m, "PedestalMaker");
+    maker.def(py::init<size_t, size_t>(),
+              py::arg("n_threads")=0, py::arg("n_events_per_block")=64);
+    maker.def_property_readonly("n_threads", &PedestalMaker::GetNThreads);
+    maker.def_property_readonly("n_events_per_block", &PedestalMaker::GetNEventsPerBlock);
+    maker.def("process",
+        py::overload_cast<const io::TIOReader&>(&PedestalMaker::Process, py::const_),
+        py::call_guard<py::gil_scoped_release>());
+    maker.def("process",
+        [](const PedestalMaker& p, const io::TIOReader& reader, PedestalTable& table,
+           size_t first_event_index, size_t n_events) {
+            py::gil_scoped_release release;
+            p.Process(reader, table, first_event_index, n_events);
+        },
+        py::arg("reader"), py::arg("table"), py::arg("first_event_index")=0,
+        py::arg("n_events")=std::numeric_limits<size_t>::max());
+}
+
+}  // namespace calibration
+}  // namespace sstcam
@@ -0,0 +1,87 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/TransferFunction.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace sstcam {
+namespace calibration {
+
+namespace py = pybind11;
+
+template<typename T>
+py::array_t<float> Apply(const TransferFunction& tf,
+        const py::array_t<T, py::array::c_style | py::array::forcecast>& samples,
+        uint16_t first_cell_id) {
+    if (samples.ndim() != 2 || static_cast<size_t>(samples.shape(0)) != tf.GetNPixels()) {
+        throw std::runtime_error("Samples array must have the shape [n_pixels, n_samples]");
+    }
+    auto n_samples = static_cast<size_t>(samples.shape(1));
+    auto array = py::array_t<float>(std::vector<ptrdiff_t>{samples.shape(0), samples.shape(1)});
+    tf.Apply(samples.data(), array.mutable_data(), n_samples, first_cell_id);
+    return array;
+}
+
+void transfer_function(py::module &m) {
+    py::module::import("sstcam.descriptions"); // Require the WaveformEventR0 wrapping
+    py::class_<TransferFunction> tf(m, "TransferFunction");
+    tf.def(py::init<size_t, int32_t, size_t, size_t>(), py::arg("n_pixels"),
+           py::arg("adc_min")=0, py::arg("n_adc")=4096, py::arg("n_cell_groups")=1);
+    tf.def_property_readonly("n_pixels", &TransferFunction::GetNPixels);
+    tf.def_property_readonly("adc_min", &TransferFunction::GetADCMin);
+    tf.def_property_readonly("n_adc", &TransferFunction::GetNADC);
+    tf.def_property_readonly("n_cell_groups", &TransferFunction::GetNCellGroups);
+    tf.def("set_tables",
+        [](TransferFunction& t, const py::array_t<float, py::array::c_style | py::array::forcecast>& tables) {
+            if (static_cast<size_t>(tables.size()) != t.GetTables().size()) {
+                throw std::runtime_error("Table array must have the shape [n_pixels, n_cell_groups, n_adc]");
+            }
+            t.SetTables(tables.data());
+        });
+    tf.def("set_table_from_points",
+        [](TransferFunction& t, uint16_t pixel, uint16_t cell_group,
+           const py::array_t<float, py::array::c_style | py::array::forcecast>& adc,
+           const py::array_t<float, py::array::c_style | py::array::forcecast>& mv) {
+            if (adc.size() != mv.size()) {
+                throw std::runtime_error("adc and mv must have the same length");
+            }
+            t.SetTableFromPoints(pixel, cell_group, adc.data(), mv.data(),
+                                 static_cast<size_t>(adc.size()));
+        },
+        py::arg("pixel"), py::arg("cell_group"), py::arg("adc"), py::arg("mv"));
+    tf.def("get_tables",
+        [](const TransferFunction& t) {
+            auto shape = std::vector<ptrdiff_t>{
+                static_cast<long>(t.GetNPixels()),
+                static_cast<long>(t.GetNCellGroups()),
+                static_cast<long>(t.GetNADC())};
+            auto array = py::array_t<float>(shape);
+            std::copy(t.GetTables().begin(), t.GetTables().end(), array.mutable_data());
+            return array;
+        });
+    tf.def("lookup", &TransferFunction::Lookup,
+           py::arg("pixel"), py::arg("cell"), py::arg("sample"));
+    // uint16_t R0 samples are matched first, so that they are not cast to float
+    tf.def("apply", Apply<uint16_t>, py::arg("samples").noconvert(), py::arg("first_cell_id")=0);
+    tf.def("apply", Apply<float>, py::arg("samples"), py::arg("first_cell_id")=0);
+    // Pixels without a waveform in the event keep their samples
+    tf.def("apply_event",
+        [](const TransferFunction& t, const descriptions::WaveformEventR0& event,
+           const py::array_t<float, py::array::c_style | py::array::forcecast>& samples) {
+            if (samples.ndim() != 2 || static_cast<size_t>(samples.shape(0)) != t.GetNPixels() ||
+                static_cast<size_t>(samples.shape(1)) != event.GetNSamples()) {
+                throw std::runtime_error("Samples array must have the shape [n_pixels, n_samples]");
+            }
+            auto array = py::array_t<float>(std::vector<ptrdiff_t>{samples.shape(0), samples.shape(1)});
+            std::copy_n(samples.data(), samples.size(), array.mutable_data());
+            t.Apply(event, array.mutable_data(), array.mutable_data());
+            return array;
+        },
+        py::arg("event"), py::arg("samples"));
+}
+
+}  // namespace calibration
+}  // namespace sstcam
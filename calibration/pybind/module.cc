@@ -9,8 +9,21 @@ namespace calibration {
 
 namespace py = pybind11;
 
+void calibrator(py::module &m);
+void pedestal_table(py::module &m);
+void pedestal_maker(py::module &m);
+void transfer_function(py::module &m);
+void batch_calibrator(py::module &m);
+void charge_extractor(py::module &m);
+
 PYBIND11_MODULE(sstcam_calibration, m) {
     m.def("_get_version",&getSSTCamCommonGitVersion);
+    pedestal_table(m);
+    pedestal_maker(m);
+    calibrator(m);
+    transfer_function(m);
+    batch_calibrator(m);
+    charge_extractor(m);
 }
 
 }  // namespace calibration
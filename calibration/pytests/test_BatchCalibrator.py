@@ -0,0 +1,38 @@
+from sstcam.io import TIOReader
+from sstcam.calibration import BatchCalibrator, Calibrator, TransferFunction, \
+    N_STORAGE_CELLS
+import numpy as np
+import pytest
+
+PATH_TM_R0 = "../share/sstcam/io/targetmodule_r0.tio"
+
+
+def test_batch_calibrator():
+    reader = TIOReader(PATH_TM_R0)
+    calibrator = Calibrator(reader.n_pixels)
+    pedestals = np.random.RandomState(1).uniform(300, 500, (reader.n_pixels, N_STORAGE_CELLS))
+    calibrator.set_pedestals(pedestals)
+    batch = BatchCalibrator(calibrator, n_threads=4)
+    assert batch.n_threads == 4
+    assert batch.n_pixels == reader.n_pixels
+
+    array = batch.get_array(reader, 1)
+    assert array.shape == (reader.n_events - 1, reader.n_pixels, reader.n_samples)
+    for i in range(array.shape[0]):
+        expected = calibrator.get_pedestal_subtracted_array(reader[i + 1])
+        assert np.array_equal(array[i], expected)
+
+    # Fill a slice of a caller-provided array in place
+    buffer = np.zeros((reader.n_events, reader.n_pixels, reader.n_samples), dtype=np.float32)
+    batch.fill(reader, buffer[2:4], 1)
+    assert np.array_equal(buffer[2:4], array[:2])
+    with pytest.raises(TypeError):
+        batch.fill(reader, buffer.astype(np.float64))
+    with pytest.raises(IndexError):
+        batch.get_array(reader, 1, reader.n_events)
+
+    tf = TransferFunction(reader.n_pixels, -1000, 6000)
+    tables = np.tile(0.3 * np.arange(-1000, 5000, dtype=np.float32), (reader.n_pixels, 1))
+    tf.set_tables(tables)
+    array_mv = BatchCalibrator(calibrator, tf).get_array(reader, 1, 2)
+    assert np.allclose(array_mv, 0.3 * np.rint(array[:2]), atol=1e-3)
@@ -0,0 +1,36 @@
+import pytest
+import numpy as np
+from sstcam.descriptions import WaveformEventR0, WaveformDataPacket
+from sstcam.calibration import Calibrator, N_STORAGE_CELLS
+
+
+@pytest.fixture(scope="module")
+def packet_array():
+    path = "../share/sstcam/descriptions/waveform_data_packet_example.bin"
+    return np.fromfile(path, dtype=np.uint8)
+
+
+def test_calibrator(packet_array):
+    packet_size = 8276
+    n_pixels = 64
+    event = WaveformEventR0(1, n_pixels, 22)
+    packet = WaveformDataPacket(packet_size)
+    packet.GetDataPacket()[:] = packet_array
+    event.add_packet_shared(packet)
+
+    calibrator = Calibrator(n_pixels)
+    assert calibrator.n_pixels == n_pixels
+    pedestals = np.random.RandomState(1).uniform(0, 500, (n_pixels, N_STORAGE_CELLS))
+    calibrator.set_pedestals(pedestals)
+    assert np.allclose(calibrator.get_pedestals(), pedestals)
+    with pytest.raises(RuntimeError):
+        calibrator.set_pedestals(pedestals[:1])
+
+    waveforms = event.get_array()
+    n_samples = waveforms.shape[1]
+    cells = (packet.GetFirstCellID() + np.arange(n_samples)) % N_STORAGE_CELLS
+    expected = waveforms - pedestals.astype(np.float32)[:, cells]
+    calibrated = calibrator.get_pedestal_subtracted_array(event)
+    assert calibrated.dtype == np.float32
+    assert calibrated.shape == (n_pixels, n_samples)
+    assert np.allclose(calibrated, expected)
@@ -0,0 +1,78 @@
+import pytest
+import numpy as np
+from sstcam.descriptions import WaveformEventR0, WaveformDataPacket, SampleLayout
+from sstcam.calibration import ChargeExtractor, ChargeExtractionMethod, \
+    Calibrator, TransferFunction, N_STORAGE_CELLS
+
+
+def test_extract():
+    n_pixels = 128
+    n_samples = 48
+    peaks = (np.arange(n_pixels) * 7) % 40 + 5
+    x = np.arange(n_samples)[None, :] - peaks[:, None]
+    samples = (10 * np.exp(-0.5 * x ** 2 / 4)).astype(np.float32)
+
+    extractor = ChargeExtractor(ChargeExtractionMethod.SLIDING_WINDOW, 7)
+    assert extractor.method == ChargeExtractionMethod.SLIDING_WINDOW
+    assert extractor.window_width == 7
+    charge, time = extractor.extract(samples)
+    assert charge.shape == (n_pixels,)
+    assert np.allclose(time, peaks, atol=1e-3)
+    starts = np.clip(peaks - 3, 0, n_samples - 7)
+    windows = starts[:, None] + np.arange(7)[None, :]
+    expected = np.take_along_axis(samples, windows, 1).sum(1)
+    assert np.allclose(charge, expected, rtol=1e-5)
+
+    charge_sm, time_sm = extractor.extract(samples.T.copy(), SampleLayout.SAMPLE_MAJOR)
+    assert np.array_equal(charge_sm, charge)
+    assert np.array_equal(time_sm, time)
+    tiles = samples.reshape(2, 64, n_samples).transpose(0, 2, 1).copy()
+    charge_mt, _ = extractor.extract(tiles, SampleLayout.MODULE_TILES)
+    assert np.array_equal(charge_mt, charge)
+
+    fixed = ChargeExtractor(ChargeExtractionMethod.FIXED_WINDOW, 4, 10)
+    charge, _ = fixed.extract(samples)
+    assert np.allclose(charge, samples[:, 10:14].sum(1), rtol=1e-5)
+    with pytest.raises(RuntimeError):
+        fixed.extract(samples[:, :12])
+    with pytest.raises(RuntimeError):
+        fixed.extract(samples, SampleLayout.MODULE_TILES)
+
+    # Window positioned from the peak of the neighbours
+    neighbours = [[(i + 1) % n_pixels] for i in range(n_pixels)]
+    neighbour = ChargeExtractor(ChargeExtractionMethod.NEIGHBOUR_PEAK, 4, 1, neighbours)
+    charge, _ = neighbour.extract(samples)
+    starts = np.clip(np.roll(peaks, -1) - 1, 0, n_samples - 4)
+    windows = starts[:, None] + np.arange(4)[None, :]
+    expected = np.take_along_axis(samples, windows, 1).sum(1)
+    assert np.allclose(charge, expected, rtol=1e-5)
+    with pytest.raises(RuntimeError):
+        ChargeExtractor(ChargeExtractionMethod.NEIGHBOUR_PEAK, 4)
+
+
+def test_extract_event():
+    path = "../share/sstcam/descriptions/waveform_data_packet_example.bin"
+    packet_size = 8276
+    n_pixels = 64
+    event = WaveformEventR0(1, n_pixels, 22)
+    packet = WaveformDataPacket(packet_size)
+    packet.GetDataPacket()[:] = np.fromfile(path, dtype=np.uint8)
+    event.add_packet_shared(packet)
+
+    calibrator = Calibrator(n_pixels)
+    pedestals = np.random.RandomState(1).uniform(0, 500, (n_pixels, N_STORAGE_CELLS))
+    calibrator.set_pedestals(pedestals)
+    tf = TransferFunction(n_pixels, -1000, 6000)
+    tf.set_tables(np.tile(0.3 * np.arange(-1000, 5000, dtype=np.float32), (n_pixels, 1)))
+
+    extractor = ChargeExtractor(ChargeExtractionMethod.SLIDING_WINDOW, 6)
+    samples = calibrator.get_pedestal_subtracted_array(event)
+    expected = extractor.extract(samples)
+    charge, time = extractor.extract_event(calibrator, event)
+    assert np.array_equal(charge, expected[0])
+    assert np.array_equal(time, expected[1])
+
+    expected = extractor.extract(tf.apply_event(event, samples))
+    charge, time = extractor.extract_event(calibrator, event, tf)
+    assert np.array_equal(charge, expected[0])
+    assert np.array_equal(time, expected[1])
@@ -0,0 +1,39 @@
+from sstcam.io import TIOReader
+from sstcam.calibration import PedestalMaker, PedestalTable, Calibrator, \
+    N_STORAGE_CELLS, PEDESTAL_MAKER_DEFAULT_MAX_THREADS
+import numpy as np
+import pytest
+
+PATH_TM_R0 = "../share/sstcam/io/targetmodule_r0.tio"
+PATH_TM_R1 = "../share/sstcam/io/targetmodule_r1.tio"
+
+
+def test_pedestal_maker():
+    reader = TIOReader(PATH_TM_R0)
+    expected = PedestalTable(reader.n_pixels)
+    for i in range(reader.n_events):
+        expected.add_event(reader[i])
+
+    assert 1 <= PedestalMaker().n_threads <= PEDESTAL_MAKER_DEFAULT_MAX_THREADS
+
+    maker = PedestalMaker(n_threads=3, n_events_per_block=2)
+    assert maker.n_threads == 3
+    table = maker.process(reader)
+    assert table.n_events == reader.n_events
+    assert table.mean.shape == (reader.n_pixels, N_STORAGE_CELLS)
+    assert (table.hits == expected.hits).all()
+    assert np.allclose(table.mean, expected.mean, atol=1e-3)
+    assert np.allclose(table.std, expected.std, atol=1e-3)
+
+    partial = PedestalTable(reader.n_pixels)
+    maker.process(reader, partial, 0, 2)
+    assert partial.n_events == 2
+
+    calibrator = Calibrator(reader.n_pixels)
+    calibrator.set_pedestals(table)
+    assert np.array_equal(calibrator.get_pedestals(), table.mean)
+
+
+def test_pedestal_maker_r1():
+    with pytest.raises(RuntimeError):
+        PedestalMaker().process(TIOReader(PATH_TM_R1))
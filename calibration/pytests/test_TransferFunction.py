@@ -0,0 +1,39 @@
+from sstcam.calibration import TransferFunction, N_STORAGE_CELLS
+import numpy as np
+import pytest
+
+
+def test_transfer_function():
+    n_pixels = 4
+    n_cell_groups = 2
+    tf = TransferFunction(n_pixels, adc_min=-100, n_adc=4196, n_cell_groups=n_cell_groups)
+    assert tf.n_pixels == n_pixels
+    assert tf.adc_min == -100
+    assert tf.n_cell_groups == n_cell_groups
+
+    adc = np.arange(-100, 4096, dtype=np.float32)
+    tables = np.zeros((n_pixels, n_cell_groups, adc.size), dtype=np.float32)
+    tables[:] = 0.5 * adc + 1e-4 * adc ** 2
+    tables += np.arange(n_pixels)[:, None, None]
+    tables[:, 1] += 0.25
+    tf.set_tables(tables)
+    assert np.array_equal(tf.get_tables(), tables)
+    with pytest.raises(RuntimeError):
+        tf.set_tables(tables[:1])
+
+    n_samples = 40
+    samples = np.random.RandomState(1).randint(0, 4096, (n_pixels, n_samples))
+    first_cell_id = N_STORAGE_CELLS // 2 - 20
+    cells = (first_cell_id + np.arange(n_samples)) % N_STORAGE_CELLS
+    groups = cells // (N_STORAGE_CELLS // n_cell_groups)
+    expected = tables[np.arange(n_pixels)[:, None], groups[None, :], samples + 100]
+
+    mv_r0 = tf.apply(samples.astype(np.uint16), first_cell_id)
+    assert mv_r0.dtype == np.float32
+    assert np.array_equal(mv_r0, expected)
+    mv_r1 = tf.apply(samples.astype(np.float32), first_cell_id)
+    assert np.array_equal(mv_r1, expected)
+    assert tf.lookup(1, cells[-1], samples[1, -1]) == expected[1, -1]
+
+    tf.set_table_from_points(0, 0, [0, 1000], [0, 500])
+    assert tf.lookup(0, 0, 500) == pytest.approx(250)
@@ -0,0 +1,130 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/BatchCalibrator.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace sstcam {
+namespace calibration {
+
+using descriptions::WaveformEventR0;
+
+namespace {
+
+// Does the event contain a packet that was not empty when it was added?
+bool HasPackets(const WaveformEventR0& event) {
+    const std::vector<bool>& missing = event.GetMissingPacketMask();
+    return std::find(missing.begin(), missing.end(), false) != missing.end();
+}
+
+}
+
+BatchCalibrator::BatchCalibrator(const Calibrator& calibrator,
+        const TransferFunction* transfer_function, size_t n_threads)
+    : calibrator_(calibrator),
+      transfer_function_(transfer_function),
+      n_threads_(n_threads ? n_threads : std::max(std::thread::hardware_concurrency(), 1u))
+{
+    if (transfer_function && transfer_function->GetNPixels() != calibrator.GetNPixels()) {
+        std::ostringstream ss;
+        ss << "TransferFunction has " << transfer_function->GetNPixels()
+           << " pixels, Calibrator has " << calibrator.GetNPixels();
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void BatchCalibrator::CalibrateEvent(const WaveformEventR0& event,
+        size_t n_samples, float* output) const {
+    // An event without packets has no samples or first cell to calibrate
+    if (!HasPackets(event)) {
+        std::fill_n(output, calibrator_.GetNPixels() * n_samples, 0.f);
+        return;
+    }
+    if (event.GetNSamples() != n_samples) {
+        std::ostringstream ss;
+        ss << "Event has " << event.GetNSamples() << " samples, expected "
+           << n_samples;
+        throw std::runtime_error(ss.str());
+    }
+
+    // Only the pixels with a waveform that is not zero-suppressed are
+    // written by the Calibrator
+    std::fill_n(output, calibrator_.GetNPixels() * n_samples, 0.f);
+    calibrator_.FillPedestalSubtractedArray(event, output);
+    if (transfer_function_) {
+        transfer_function_->Apply(event, output, output);
+    }
+}
+
+void BatchCalibrator::RunTasks(size_t n_events,
+        const std::function<void(size_t)>& task) const {
+    size_t n_threads = std::max<size_t>(std::min(n_threads_, n_events), 1);
+    std::atomic<size_t> next_event(0);
+    std::exception_ptr exception;
+    std::mutex exception_mutex;
+    auto worker = [&]() {
+        try {
+            size_t i_event;
+            while ((i_event = next_event.fetch_add(1, std::memory_order_relaxed)) < n_events) {
+                task(i_event);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (!exception) exception = std::current_exception();
+            next_event = n_events; // Stop the other threads
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i_thread = 1; i_thread < n_threads; i_thread++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) thread.join();
+    if (exception) std::rethrow_exception(exception);
+}
+
+void BatchCalibrator::FillCalibratedArray(const io::TIOReader& reader,
+        float* output, size_t first_event_index, size_t n_events) const {
+    if (reader.IsR1()) {
+        throw std::runtime_error("BatchCalibrator requires R0 files");
+    }
+    if (reader.GetNPixels() != calibrator_.GetNPixels()) {
+        std::ostringstream ss;
+        ss << "File has " << reader.GetNPixels() << " pixels, Calibrator has "
+           << calibrator_.GetNPixels();
+        throw std::runtime_error(ss.str());
+    }
+    if (first_event_index + n_events > reader.GetNEvents()) {
+        std::ostringstream ss;
+        ss << "Events " << first_event_index << " to " << first_event_index + n_events
+           << " extend beyond the end of the file (" << reader.GetNEvents()
+           << " events)";
+        throw std::out_of_range(ss.str());
+    }
+    size_t n_samples = reader.GetNSamples();
+    size_t event_size = calibrator_.GetNPixels() * n_samples;
+    RunTasks(n_events, [&](size_t i_event) {
+        WaveformEventR0 event = reader.GetEventR0(first_event_index + i_event);
+        CalibrateEvent(event, n_samples, &output[i_event * event_size]);
+    });
+}
+
+void BatchCalibrator::FillCalibratedArray(const std::vector<WaveformEventR0>& events,
+        float* output) const {
+    auto first = std::find_if(events.begin(), events.end(), HasPackets);
+    if (first == events.end()) return;
+    size_t n_samples = first->GetNSamples();
+    size_t event_size = calibrator_.GetNPixels() * n_samples;
+    RunTasks(events.size(), [&](size_t i_event) {
+        CalibrateEvent(events[i_event], n_samples, &output[i_event * event_size]);
+    });
+}
+
+}}
@@ -2,8 +2,211 @@
 // This software is distributed under the terms of the BSD-3-Clause license.
 
 #include "sstcam/calibration/Calibrator.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSTCAM_CALIBRATOR_X86
+#include <immintrin.h>
+#endif
 
 namespace sstcam {
 namespace calibration {
 
+using descriptions::SampleUnpackingKernel;
+using descriptions::WaveformDataPacket;
+using descriptions::Waveform;
+using descriptions::N_PIXELS_PER_MODULE;
+
+namespace {
+
+// Scalar kernel, also used for the samples remaining after the last full
+// vector of the SIMD kernels
+void SubtractPedestalScalar(const uint8_t* data, const float* pedestal,
+        float* samples, size_t n_samples) {
+    for (size_t i = 0; i < n_samples; i++) {
+        auto sample = static_cast<uint16_t>(
+            static_cast<uint16_t>(data[2 * i] & 0xFu) << 8u | data[2 * i + 1]);
+        samples[i] = static_cast<float>(sample) - pedestal[i];
+    }
+}
+
+#ifdef SSTCAM_CALIBRATOR_X86
+
+// Byte order of each 16bit word is swapped with a single shuffle
+#define SSTCAM_BSWAP16_PATTERN 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+
+__attribute__((target("sse4.1")))
+void SubtractPedestalSSE4(const uint8_t* data, const float* pedestal,
+        float* samples, size_t n_samples) {
+    const __m128i bswap = _mm_set_epi8(SSTCAM_BSWAP16_PATTERN);
+    const __m128i mask = _mm_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[2 * i]));
+        v = _mm_and_si128(_mm_shuffle_epi8(v, bswap), mask);
+        __m128 lo = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v));
+        __m128 hi = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+        _mm_storeu_ps(&samples[i], _mm_sub_ps(lo, _mm_loadu_ps(&pedestal[i])));
+        _mm_storeu_ps(&samples[i + 4], _mm_sub_ps(hi, _mm_loadu_ps(&pedestal[i + 4])));
+    }
+    SubtractPedestalScalar(&data[2 * i], &pedestal[i], &samples[i], n_samples - i);
+}
+
+__attribute__((target("avx2")))
+void SubtractPedestalAVX2(const uint8_t* data, const float* pedestal,
+        float* samples, size_t n_samples) {
+    const __m256i bswap = _mm256_set_epi8(
+        SSTCAM_BSWAP16_PATTERN, SSTCAM_BSWAP16_PATTERN);
+    const __m256i mask = _mm256_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 16 <= n_samples; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&data[2 * i]));
+        v = _mm256_and_si256(_mm256_shuffle_epi8(v, bswap), mask);
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+        _mm256_storeu_ps(&samples[i], _mm256_sub_ps(lo, _mm256_loadu_ps(&pedestal[i])));
+        _mm256_storeu_ps(&samples[i + 8], _mm256_sub_ps(hi, _mm256_loadu_ps(&pedestal[i + 8])));
+    }
+    SubtractPedestalScalar(&data[2 * i], &pedestal[i], &samples[i], n_samples - i);
+}
+
+// The zero-masked forms (with every lane selected) are used for the AVX-512
+// intrinsics, as the unmasked forms trigger false -Wuninitialized warnings in
+// some GCC versions
+constexpr __mmask16 ALL_LANES = 0xFFFF;
+
+__attribute__((target("avx512f,avx512bw")))
+void SubtractPedestalAVX512(const uint8_t* data, const float* pedestal,
+        float* samples, size_t n_samples) {
+    const __m512i bswap = _mm512_maskz_broadcast_i32x4(
+        ALL_LANES, _mm_set_epi8(SSTCAM_BSWAP16_PATTERN));
+    const __m512i mask = _mm512_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 32 <= n_samples; i += 32) {
+        __m512i v = _mm512_loadu_si512(&data[2 * i]);
+        v = _mm512_and_si512(_mm512_shuffle_epi8(v, bswap), mask);
+        __m512 lo = _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu16_epi32(
+            ALL_LANES, _mm512_maskz_extracti64x4_epi64(0xFF, v, 0)));
+        __m512 hi = _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu16_epi32(
+            ALL_LANES, _mm512_maskz_extracti64x4_epi64(0xFF, v, 1)));
+        _mm512_storeu_ps(&samples[i], _mm512_sub_ps(lo, _mm512_loadu_ps(&pedestal[i])));
+        _mm512_storeu_ps(&samples[i + 16], _mm512_sub_ps(hi, _mm512_loadu_ps(&pedestal[i + 16])));
+    }
+    SubtractPedestalScalar(&data[2 * i], &pedestal[i], &samples[i], n_samples - i);
+}
+
+#undef SSTCAM_BSWAP16_PATTERN
+
+#endif
+
+}
+
+SubtractPedestalFunction GetSubtractPedestalFunction(SampleUnpackingKernel kernel) {
+    if (!descriptions::IsSampleUnpackingKernelSupported(kernel)) {
+        throw std::runtime_error("Pedestal subtraction kernel is not supported by this CPU");
+    }
+    switch (kernel) {
+#ifdef SSTCAM_CALIBRATOR_X86
+        case SampleUnpackingKernel::AVX512:
+            return SubtractPedestalAVX512;
+        case SampleUnpackingKernel::AVX2:
+            return SubtractPedestalAVX2;
+        case SampleUnpackingKernel::SSE4:
+            return SubtractPedestalSSE4;
+#endif
+        default:
+            return SubtractPedestalScalar;
+    }
+}
+
+Calibrator::Calibrator(size_t n_pixels)
+    : n_pixels_(n_pixels),
+      pedestals_(n_pixels * N_STORAGE_CELLS, 0),
+      subtract_pedestal_(GetSubtractPedestalFunction(
+          descriptions::GetSampleUnpackingKernel())) { }
+
+void Calibrator::SetPedestals(const float* pedestals) {
+    std::copy_n(pedestals, pedestals_.size(), pedestals_.begin());
+}
+
+void Calibrator::SetPedestals(const PedestalTable& table) {
+    if (table.GetNPixels() != n_pixels_) {
+        std::ostringstream ss;
+        ss << "PedestalTable has " << table.GetNPixels()
+           << " pixels, Calibrator has " << n_pixels_;
+        throw std::runtime_error(ss.str());
+    }
+    const auto& statistics = table.GetStatistics();
+    for (size_t i = 0; i < pedestals_.size(); i++) {
+        pedestals_[i] = statistics[i].mean;
+    }
+}
+
+void Calibrator::SetPixelPedestal(uint16_t pixel, const float* pedestal) {
+    if (pixel >= n_pixels_) {
+        std::ostringstream ss;
+        ss << "Pixel " << pixel << " is not in the Calibrator (n_pixels = "
+           << n_pixels_ << ")";
+        throw std::out_of_range(ss.str());
+    }
+    std::copy_n(pedestal, N_STORAGE_CELLS, &pedestals_[pixel * N_STORAGE_CELLS]);
+}
+
+void Calibrator::FillPedestalSubtractedArray(
+        const descriptions::WaveformEventR0& event, float* samples) const {
+    if (event.GetNPixels() != n_pixels_) {
+        std::ostringstream ss;
+        ss << "Event has " << event.GetNPixels() << " pixels, Calibrator has "
+           << n_pixels_;
+        throw std::runtime_error(ss.str());
+    }
+    size_t n_samples = event.GetNSamples();
+    size_t n_modules = n_pixels_ / N_PIXELS_PER_MODULE;
+    for (WaveformDataPacket* packet : event.GetPackets()) {
+        if (!packet) continue;
+        uint8_t module = packet->GetSlotID() - event.GetFirstActiveModuleSlot();
+        if (module >= n_modules) continue;
+        FillPedestalSubtractedPacket(*packet, module, n_samples,
+            &samples[module * N_PIXELS_PER_MODULE * n_samples]);
+    }
+}
+
+void Calibrator::FillPedestalSubtractedPacket(const WaveformDataPacket& packet,
+        size_t module, size_t n_samples, float* module_samples) const {
+    // The storage array is circular: the cells of a waveform are split
+    // into two contiguous segments of the pedestal table if it wraps
+    uint16_t first_cell = packet.GetFirstCellID() % N_STORAGE_CELLS;
+    size_t n_before_wrap = std::min<size_t>(n_samples, N_STORAGE_CELLS - first_cell);
+    size_t n_after_wrap = n_samples - n_before_wrap;
+
+    uint16_t n_waveforms = packet.GetNWaveforms();
+    const uint8_t* waveform_data = &packet.GetDataPacket()[packet.GetWaveformStart(0)];
+    uint16_t waveform_n_bytes = packet.GetWaveformNBytes();
+    Waveform waveform;
+    for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+        waveform.Associate(const_cast<uint8_t*>(waveform_data));
+        waveform_data += waveform_n_bytes;
+        if (waveform.IsZeroSuppressed()) continue;
+        uint16_t pixel_id = waveform.GetPixelID();
+        size_t i_pixel = module * N_PIXELS_PER_MODULE + pixel_id;
+        const uint8_t* data = waveform.GetSampleData();
+        const float* pedestal = &pedestals_[i_pixel * N_STORAGE_CELLS];
+        float* output = &module_samples[pixel_id * n_samples];
+        subtract_pedestal_(data, &pedestal[first_cell], output, n_before_wrap);
+        if (n_after_wrap) {
+            subtract_pedestal_(&data[2 * n_before_wrap], pedestal,
+                               &output[n_before_wrap], n_after_wrap);
+        }
+    }
+}
+
+std::vector<float> Calibrator::GetPedestalSubtractedVector(
+        const descriptions::WaveformEventR0& event) const {
+    std::vector<float> samples(n_pixels_ * event.GetNSamples(), 0);
+    FillPedestalSubtractedArray(event, samples.data());
+    return samples;
+}
+
 }}
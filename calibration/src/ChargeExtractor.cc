@@ -0,0 +1,431 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/ChargeExtractor.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SSTCAM_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define SSTCAM_KERNEL_INLINE inline
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSTCAM_CHARGEEXTRACTOR_X86
+#endif
+
+namespace sstcam {
+namespace calibration {
+
+using descriptions::SampleLayout;
+using descriptions::SampleUnpackingKernel;
+using descriptions::WaveformDataPacket;
+using descriptions::WaveformEventR0;
+using descriptions::N_PIXELS_PER_MODULE;
+
+namespace {
+
+// The kernels are written once, as templates over the type holding the
+// samples of a group of pixels: a GCC/Clang extended vector for the SIMD
+// kernels, or a single float for the scalar kernel and for the pixels
+// remaining after the last full vector. The templates are inlined into
+// functions compiled for each instruction set, where the vectors are lowered
+// to xmm/ymm/zmm registers. The vectors are passed by reference and copied
+// with memcpy, so that no vector crosses a function boundary with the
+// default ABI.
+
+template <typename V>
+SSTCAM_KERNEL_INLINE void Load(V& v, const float* p) {
+    std::memcpy(&v, p, sizeof(V));
+}
+
+template <typename V>
+SSTCAM_KERNEL_INLINE void Store(float* p, const V& v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+// Start of the window of width samples with the largest sum
+template <typename V>
+SSTCAM_KERNEL_INLINE void FindSlidingWindow(const float* samples,
+        size_t n_samples, size_t stride, size_t width, V& start) {
+    V sum{};
+    for (size_t isample = 0; isample < width; isample++) {
+        V v;
+        Load(v, &samples[isample * stride]);
+        sum += v;
+    }
+    V max_sum = sum;
+    start = V{};
+    for (size_t isample = 1; isample + width <= n_samples; isample++) {
+        V entering;
+        V leaving;
+        Load(entering, &samples[(isample + width - 1) * stride]);
+        Load(leaving, &samples[(isample - 1) * stride]);
+        sum += entering - leaving;
+        auto larger = sum > max_sum;
+        max_sum = larger ? sum : max_sum;
+        start = larger ? V{} + static_cast<float>(isample) : start;
+    }
+}
+
+// Sample index of the (first) maximum
+template <typename V>
+SSTCAM_KERNEL_INLINE void FindPeak(const float* samples, size_t n_samples,
+        size_t stride, V& peak) {
+    V max;
+    Load(max, samples);
+    peak = V{};
+    for (size_t isample = 1; isample < n_samples; isample++) {
+        V v;
+        Load(v, &samples[isample * stride]);
+        auto larger = v > max;
+        max = larger ? v : max;
+        peak = larger ? V{} + static_cast<float>(isample) : peak;
+    }
+}
+
+// Integrate the samples in [start, start + width) of each pixel. Only the
+// samples in [begin, end) are visited, which must contain every window.
+template <typename V>
+SSTCAM_KERNEL_INLINE void IntegrateWindow(const float* samples, size_t begin,
+        size_t end, size_t stride, size_t width, const V& start,
+        float* charge, float* time) {
+    V stop = start + static_cast<float>(width);
+    V sum{};
+    V time_num{};
+    V time_den{};
+    for (size_t isample = begin; isample < end; isample++) {
+        V v;
+        Load(v, &samples[isample * stride]);
+        V index = V{} + static_cast<float>(isample);
+        auto in_window = (index >= start) & (index < stop);
+        V in = in_window ? v : V{};
+        V positive = in > V{} ? in : V{};
+        sum += in;
+        time_num += positive * index;
+        time_den += positive;
+    }
+    auto has_positive = time_den > V{};
+    V den = has_positive ? time_den : V{} + 1.f;
+    V centre = start + static_cast<float>(width - 1) / 2;
+    V peak_time = has_positive ? time_num / den : centre;
+    Store(charge, sum);
+    Store(time, peak_time);
+}
+
+template <typename V>
+SSTCAM_KERNEL_INLINE void ExtractChargeLanes(const float* samples,
+        const float* reference, size_t n_samples, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    V start{};
+    size_t begin = 0;
+    size_t end = n_samples;
+    switch (method) {
+        case ChargeExtractionMethod::FIXED_WINDOW:
+            start += static_cast<float>(offset);
+            begin = offset;
+            end = offset + width;
+            break;
+        case ChargeExtractionMethod::SLIDING_WINDOW:
+            FindSlidingWindow(samples, n_samples, stride, width, start);
+            break;
+        case ChargeExtractionMethod::NEIGHBOUR_PEAK: {
+            V peak;
+            FindPeak(reference, n_samples, stride, peak);
+            V last = V{} + static_cast<float>(n_samples - width);
+            start = peak - static_cast<float>(offset);
+            start = start < V{} ? V{} : start;
+            start = start > last ? last : start;
+            break;
+        }
+    }
+    IntegrateWindow(samples, begin, end, stride, width, start, charge, time);
+}
+
+template <typename V>
+SSTCAM_KERNEL_INLINE void ExtractChargeTemplate(const float* samples,
+        const float* reference, size_t n_samples, size_t n_pixels, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    constexpr size_t n_lanes = sizeof(V) / sizeof(float);
+    size_t ipixel = 0;
+    for (; ipixel + n_lanes <= n_pixels; ipixel += n_lanes) {
+        ExtractChargeLanes<V>(&samples[ipixel],
+            reference ? &reference[ipixel] : nullptr, n_samples, stride,
+            method, width, offset, &charge[ipixel], &time[ipixel]);
+    }
+    for (; ipixel < n_pixels; ipixel++) {
+        ExtractChargeLanes<float>(&samples[ipixel],
+            reference ? &reference[ipixel] : nullptr, n_samples, stride,
+            method, width, offset, &charge[ipixel], &time[ipixel]);
+    }
+}
+
+void ExtractChargeScalar(const float* samples, const float* reference,
+        size_t n_samples, size_t n_pixels, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    ExtractChargeTemplate<float>(samples, reference, n_samples, n_pixels,
+        stride, method, width, offset, charge, time);
+}
+
+#ifdef SSTCAM_CHARGEEXTRACTOR_X86
+
+typedef float Float4 __attribute__((vector_size(16)));
+typedef float Float8 __attribute__((vector_size(32)));
+typedef float Float16 __attribute__((vector_size(64)));
+
+__attribute__((target("sse4.1")))
+void ExtractChargeSSE4(const float* samples, const float* reference,
+        size_t n_samples, size_t n_pixels, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    ExtractChargeTemplate<Float4>(samples, reference, n_samples, n_pixels,
+        stride, method, width, offset, charge, time);
+}
+
+__attribute__((target("avx2")))
+void ExtractChargeAVX2(const float* samples, const float* reference,
+        size_t n_samples, size_t n_pixels, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    ExtractChargeTemplate<Float8>(samples, reference, n_samples, n_pixels,
+        stride, method, width, offset, charge, time);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void ExtractChargeAVX512(const float* samples, const float* reference,
+        size_t n_samples, size_t n_pixels, size_t stride,
+        ChargeExtractionMethod method, size_t width, size_t offset,
+        float* charge, float* time) {
+    ExtractChargeTemplate<Float16>(samples, reference, n_samples, n_pixels,
+        stride, method, width, offset, charge, time);
+}
+
+#endif
+
+// Transpose a [n_rows][n_columns] array into [n_columns][out_stride]
+void Transpose(const float* input, size_t n_rows, size_t n_columns,
+        float* output, size_t out_stride) {
+    for (size_t irow = 0; irow < n_rows; irow++) {
+        const float* row = &input[irow * n_columns];
+        for (size_t icolumn = 0; icolumn < n_columns; icolumn++) {
+            output[icolumn * out_stride + irow] = row[icolumn];
+        }
+    }
+}
+
+}
+
+ExtractChargeFunction GetExtractChargeFunction(SampleUnpackingKernel kernel) {
+    if (!descriptions::IsSampleUnpackingKernelSupported(kernel)) {
+        throw std::runtime_error("Charge extraction kernel is not supported by this CPU");
+    }
+    switch (kernel) {
+#ifdef SSTCAM_CHARGEEXTRACTOR_X86
+        case SampleUnpackingKernel::AVX512:
+            return ExtractChargeAVX512;
+        case SampleUnpackingKernel::AVX2:
+            return ExtractChargeAVX2;
+        case SampleUnpackingKernel::SSE4:
+            return ExtractChargeSSE4;
+#endif
+        default:
+            return ExtractChargeScalar;
+    }
+}
+
+ChargeExtractor::ChargeExtractor(ChargeExtractionMethod method,
+        size_t window_width, size_t window_offset,
+        const std::vector<std::vector<uint16_t>>& neighbours)
+    : method_(method),
+      window_width_(window_width),
+      window_offset_(window_offset),
+      extract_(GetExtractChargeFunction(descriptions::GetSampleUnpackingKernel()))
+{
+    if (window_width == 0) {
+        throw std::runtime_error("ChargeExtractor window_width must be at least 1");
+    }
+    if (method == ChargeExtractionMethod::NEIGHBOUR_PEAK && neighbours.empty()) {
+        throw std::runtime_error("NEIGHBOUR_PEAK requires the neighbours of each pixel");
+    }
+    if (neighbours.empty()) return;
+
+    neighbour_offsets_.reserve(neighbours.size() + 1);
+    neighbour_offsets_.push_back(0);
+    for (size_t ipixel = 0; ipixel < neighbours.size(); ipixel++) {
+        for (uint16_t neighbour : neighbours[ipixel]) {
+            if (neighbour >= neighbours.size()) {
+                std::ostringstream ss;
+                ss << "Neighbour " << neighbour << " of pixel " << ipixel
+                   << " is not in the camera (n_pixels = " << neighbours.size() << ")";
+                throw std::out_of_range(ss.str());
+            }
+            neighbour_pixels_.push_back(neighbour);
+        }
+        neighbour_offsets_.push_back(neighbour_pixels_.size());
+    }
+}
+
+void ChargeExtractor::CheckDimensions(size_t n_pixels, size_t n_samples) const {
+    size_t window_end = window_width_;
+    if (method_ == ChargeExtractionMethod::FIXED_WINDOW) window_end += window_offset_;
+    if (window_end > n_samples) {
+        std::ostringstream ss;
+        ss << "Window (width = " << window_width_ << ", offset = "
+           << window_offset_ << ") does not fit in " << n_samples << " samples";
+        throw std::runtime_error(ss.str());
+    }
+    if (method_ == ChargeExtractionMethod::NEIGHBOUR_PEAK &&
+            n_pixels != GetNNeighbourPixels()) {
+        std::ostringstream ss;
+        ss << "Neighbours are defined for " << GetNNeighbourPixels()
+           << " pixels, samples have " << n_pixels;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void ChargeExtractor::ExtractSampleMajor(const float* samples, size_t n_pixels,
+        size_t n_samples, float* charge, float* time) const {
+    if (method_ != ChargeExtractionMethod::NEIGHBOUR_PEAK) {
+        extract_(samples, nullptr, n_samples, n_pixels, n_pixels, method_,
+                 window_width_, window_offset_, charge, time);
+        return;
+    }
+
+    // Summed waveform of the neighbours of each pixel, sample by sample so
+    // that the rows of the samples are read contiguously
+    std::vector<float> reference(n_samples * n_pixels, 0);
+    for (size_t isample = 0; isample < n_samples; isample++) {
+        const float* row = &samples[isample * n_pixels];
+        float* reference_row = &reference[isample * n_pixels];
+        for (size_t ipixel = 0; ipixel < n_pixels; ipixel++) {
+            float sum = 0;
+            for (size_t i = neighbour_offsets_[ipixel]; i < neighbour_offsets_[ipixel + 1]; i++) {
+                sum += row[neighbour_pixels_[i]];
+            }
+            reference_row[ipixel] = sum;
+        }
+    }
+    extract_(samples, reference.data(), n_samples, n_pixels, n_pixels, method_,
+             window_width_, window_offset_, charge, time);
+}
+
+void ChargeExtractor::Extract(const float* samples, size_t n_pixels,
+        size_t n_samples, float* charge, float* time, SampleLayout layout) const {
+    CheckDimensions(n_pixels, n_samples);
+    if (layout == SampleLayout::MODULE_TILES && n_pixels % N_PIXELS_PER_MODULE) {
+        std::ostringstream ss;
+        ss << "MODULE_TILES requires a multiple of " << +N_PIXELS_PER_MODULE
+           << " pixels, not " << n_pixels;
+        throw std::runtime_error(ss.str());
+    }
+    size_t n_modules = n_pixels / N_PIXELS_PER_MODULE;
+
+    if (layout == SampleLayout::SAMPLE_MAJOR) {
+        ExtractSampleMajor(samples, n_pixels, n_samples, charge, time);
+    }
+    else if (method_ == ChargeExtractionMethod::NEIGHBOUR_PEAK) {
+        std::vector<float> sample_major(n_samples * n_pixels);
+        if (layout == SampleLayout::PIXEL_MAJOR) {
+            Transpose(samples, n_pixels, n_samples, sample_major.data(), n_pixels);
+        }
+        else {
+            for (size_t imodule = 0; imodule < n_modules; imodule++) {
+                const float* tile = &samples[imodule * n_samples * N_PIXELS_PER_MODULE];
+                for (size_t isample = 0; isample < n_samples; isample++) {
+                    std::copy_n(&tile[isample * N_PIXELS_PER_MODULE], N_PIXELS_PER_MODULE,
+                        &sample_major[isample * n_pixels + imodule * N_PIXELS_PER_MODULE]);
+                }
+            }
+        }
+        ExtractSampleMajor(sample_major.data(), n_pixels, n_samples, charge, time);
+    }
+    else if (layout == SampleLayout::MODULE_TILES) {
+        for (size_t imodule = 0; imodule < n_modules; imodule++) {
+            size_t first_pixel = imodule * N_PIXELS_PER_MODULE;
+            extract_(&samples[first_pixel * n_samples], nullptr, n_samples,
+                     N_PIXELS_PER_MODULE, N_PIXELS_PER_MODULE, method_,
+                     window_width_, window_offset_,
+                     &charge[first_pixel], &time[first_pixel]);
+        }
+    }
+    else {
+        // Transpose a tile of pixels at a time, which stays in cache while
+        // it is extracted
+        std::vector<float> tile(n_samples * N_PIXELS_PER_MODULE);
+        for (size_t first_pixel = 0; first_pixel < n_pixels; first_pixel += N_PIXELS_PER_MODULE) {
+            size_t n_tile_pixels = std::min<size_t>(N_PIXELS_PER_MODULE, n_pixels - first_pixel);
+            Transpose(&samples[first_pixel * n_samples], n_tile_pixels, n_samples,
+                      tile.data(), N_PIXELS_PER_MODULE);
+            extract_(tile.data(), nullptr, n_samples, n_tile_pixels,
+                     N_PIXELS_PER_MODULE, method_, window_width_, window_offset_,
+                     &charge[first_pixel], &time[first_pixel]);
+        }
+    }
+}
+
+void ChargeExtractor::Extract(const Calibrator& calibrator,
+        const WaveformEventR0& event, float* charge, float* time,
+        const TransferFunction* transfer_function) const {
+    size_t n_pixels = calibrator.GetNPixels();
+    size_t n_samples = event.GetNSamples();
+    if (event.GetNPixels() != n_pixels) {
+        std::ostringstream ss;
+        ss << "Event has " << event.GetNPixels() << " pixels, Calibrator has "
+           << n_pixels;
+        throw std::runtime_error(ss.str());
+    }
+    if (transfer_function && transfer_function->GetNPixels() != n_pixels) {
+        std::ostringstream ss;
+        ss << "TransferFunction has " << transfer_function->GetNPixels()
+           << " pixels, Calibrator has " << n_pixels;
+        throw std::runtime_error(ss.str());
+    }
+    CheckDimensions(n_pixels, n_samples);
+
+    if (method_ == ChargeExtractionMethod::NEIGHBOUR_PEAK) {
+        std::vector<float> samples(n_pixels * n_samples, 0);
+        calibrator.FillPedestalSubtractedArray(event, samples.data());
+        if (transfer_function) {
+            transfer_function->Apply(event, samples.data(), samples.data());
+        }
+        Extract(samples.data(), n_pixels, n_samples, charge, time);
+        return;
+    }
+
+    // A module can be split between several packets
+    size_t n_modules = n_pixels / N_PIXELS_PER_MODULE;
+    std::vector<std::vector<const WaveformDataPacket*>> module_packets(n_modules);
+    for (const WaveformDataPacket* packet : event.GetPackets()) {
+        if (!packet) continue;
+        uint8_t module = packet->GetSlotID() - event.GetFirstActiveModuleSlot();
+        if (module < n_modules) module_packets[module].push_back(packet);
+    }
+
+    std::vector<float> module_samples(N_PIXELS_PER_MODULE * n_samples);
+    std::vector<float> tile(n_samples * N_PIXELS_PER_MODULE);
+    for (size_t imodule = 0; imodule < n_modules; imodule++) {
+        size_t first_pixel = imodule * N_PIXELS_PER_MODULE;
+        std::fill(module_samples.begin(), module_samples.end(), 0.f);
+        for (const WaveformDataPacket* packet : module_packets[imodule]) {
+            calibrator.FillPedestalSubtractedPacket(*packet, imodule, n_samples,
+                                                    module_samples.data());
+            if (transfer_function) {
+                transfer_function->ApplyPacket(*packet, imodule, n_samples,
+                    module_samples.data(), module_samples.data());
+            }
+        }
+        Transpose(module_samples.data(), N_PIXELS_PER_MODULE, n_samples,
+                  tile.data(), N_PIXELS_PER_MODULE);
+        extract_(tile.data(), nullptr, n_samples, N_PIXELS_PER_MODULE,
+                 N_PIXELS_PER_MODULE, method_, window_width_, window_offset_,
+                 &charge[first_pixel], &time[first_pixel]);
+    }
+}
+
+}}
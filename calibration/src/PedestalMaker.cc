@@ -0,0 +1,87 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/PedestalMaker.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sstcam {
+namespace calibration {
+
+PedestalMaker::PedestalMaker(size_t n_threads, size_t n_events_per_block)
+    : n_threads_(n_threads ? n_threads : std::clamp<size_t>(
+        std::thread::hardware_concurrency(), 1, PEDESTAL_MAKER_DEFAULT_MAX_THREADS)),
+      n_events_per_block_(std::max<size_t>(n_events_per_block, 1)) { }
+
+void PedestalMaker::Process(const io::TIOReader& reader, PedestalTable& table,
+        size_t first_event_index, size_t n_events) const {
+    if (reader.IsR1()) {
+        throw std::runtime_error("Pedestals must be generated from R0 files");
+    }
+    if (reader.GetNPixels() != table.GetNPixels()) {
+        std::ostringstream ss;
+        ss << "File has " << reader.GetNPixels() << " pixels, PedestalTable has "
+           << table.GetNPixels();
+        throw std::runtime_error(ss.str());
+    }
+    size_t n_available = first_event_index < reader.GetNEvents() ?
+        reader.GetNEvents() - first_event_index : 0;
+    size_t end = first_event_index + std::min(n_events, n_available);
+    size_t n_blocks = (end - first_event_index + n_events_per_block_ - 1) / n_events_per_block_;
+    size_t n_threads = std::max<size_t>(std::min(n_threads_, n_blocks), 1);
+
+    // The calling thread accumulates directly into the table, the others into
+    // their partial tables (allocated by the thread that fills them)
+    std::vector<PedestalTable> partials(n_threads, PedestalTable(0));
+    std::atomic<size_t> next_block(0);
+    std::exception_ptr exception;
+    std::mutex exception_mutex;
+    auto accumulate = [&](size_t i_thread) {
+        try {
+            PedestalTable* target = &table;
+            if (i_thread > 0) {
+                partials[i_thread] = PedestalTable(table.GetNPixels());
+                target = &partials[i_thread];
+            }
+            size_t i_block;
+            while ((i_block = next_block.fetch_add(1, std::memory_order_relaxed)) < n_blocks) {
+                size_t first = first_event_index + i_block * n_events_per_block_;
+                size_t n = std::min(n_events_per_block_, end - first);
+                for (const auto& event : reader.GetEventsR0(first, n)) {
+                    target->AddEvent(event);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (!exception) exception = std::current_exception();
+            next_block = n_blocks; // Stop the other threads
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i_thread = 1; i_thread < n_threads; i_thread++) {
+        threads.emplace_back(accumulate, i_thread);
+    }
+    accumulate(0);
+    for (auto& thread : threads) thread.join();
+    if (exception) std::rethrow_exception(exception);
+
+    if (n_threads > 1) {
+        partials.erase(partials.begin()); // Placeholder for the calling thread
+        table.Merge(partials, n_threads);
+    }
+}
+
+PedestalTable PedestalMaker::Process(const io::TIOReader& reader) const {
+    PedestalTable table(reader.GetNPixels());
+    Process(reader, table);
+    return table;
+}
+
+}}
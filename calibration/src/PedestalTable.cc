@@ -0,0 +1,154 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/PedestalTable.h"
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace sstcam {
+namespace calibration {
+
+using descriptions::WaveformDataPacket;
+using descriptions::Waveform;
+using descriptions::N_PIXELS_PER_MODULE;
+
+PedestalTable::PedestalTable(size_t n_pixels)
+    : n_pixels_(n_pixels),
+      n_events_(0),
+      statistics_(n_pixels * N_STORAGE_CELLS) { }
+
+void PedestalTable::AddEvent(const descriptions::WaveformEventR0& event) {
+    if (event.GetNPixels() != n_pixels_) {
+        std::ostringstream ss;
+        ss << "Event has " << event.GetNPixels() << " pixels, PedestalTable has "
+           << n_pixels_;
+        throw std::runtime_error(ss.str());
+    }
+    size_t n_modules = n_pixels_ / N_PIXELS_PER_MODULE;
+    uint16_t n_samples = 0;
+    descriptions::UnpackSamplesFunction<uint16_t> unpack_samples = nullptr;
+    Waveform waveform;
+    for (WaveformDataPacket* packet : event.GetPackets()) {
+        if (!packet) continue;
+        uint8_t module = packet->GetSlotID() - event.GetFirstActiveModuleSlot();
+        if (module >= n_modules) continue;
+        if (packet->GetWaveformNSamples() != n_samples || !unpack_samples) {
+            n_samples = packet->GetWaveformNSamples();
+            unpack_samples = descriptions::GetUnpackSamplesR0Function(n_samples);
+            buffer_.resize(n_samples);
+        }
+
+        // The storage array is circular: the cells of a waveform are split
+        // into two contiguous segments of the table if it wraps
+        uint16_t first_cell = packet->GetFirstCellID() % N_STORAGE_CELLS;
+        size_t n_before_wrap = std::min<size_t>(n_samples, N_STORAGE_CELLS - first_cell);
+
+        uint16_t n_waveforms = packet->GetNWaveforms();
+        uint8_t* waveform_data = &packet->GetDataPacket()[packet->GetWaveformStart(0)];
+        uint16_t waveform_n_bytes = packet->GetWaveformNBytes();
+        for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+            waveform.Associate(waveform_data);
+            waveform_data += waveform_n_bytes;
+            if (waveform.IsZeroSuppressed()) continue;
+            unpack_samples(waveform.GetSampleData(), buffer_.data(), n_samples, 1, 0);
+            size_t i_pixel = module * N_PIXELS_PER_MODULE + waveform.GetPixelID();
+            PedestalCellStatistics* pixel_statistics = &statistics_[i_pixel * N_STORAGE_CELLS];
+            PedestalCellStatistics* cell = &pixel_statistics[first_cell];
+            for (size_t isample = 0; isample < n_before_wrap; isample++) {
+                cell[isample].Add(buffer_[isample]);
+            }
+            for (size_t isample = n_before_wrap; isample < n_samples; isample++) {
+                pixel_statistics[isample - n_before_wrap].Add(buffer_[isample]);
+            }
+        }
+    }
+    n_events_++;
+}
+
+void PedestalTable::CheckCompatible(const PedestalTable& other) const {
+    if (other.n_pixels_ != n_pixels_) {
+        std::ostringstream ss;
+        ss << "Cannot merge a PedestalTable of " << other.n_pixels_
+           << " pixels into one of " << n_pixels_;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void PedestalTable::Merge(const PedestalTable& other) {
+    CheckCompatible(other);
+    for (size_t i = 0; i < statistics_.size(); i++) {
+        statistics_[i].Merge(other.statistics_[i]);
+    }
+    n_events_ += other.n_events_;
+}
+
+void PedestalTable::Merge(const std::vector<PedestalTable>& others, size_t n_threads) {
+    std::vector<const PedestalTable*> tables;
+    for (const PedestalTable& other : others) {
+        if (&other == this) continue;
+        CheckCompatible(other);
+        tables.push_back(&other);
+    }
+
+    // Each thread reduces a contiguous range of entries. The range is
+    // traversed in chunks, so that the chunk of this table stays in cache
+    // while the same chunk of each of the other tables is merged into it.
+    constexpr size_t chunk_size = 4096;
+    auto merge_range = [this, &tables](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk += chunk_size) {
+            size_t chunk_end = std::min(chunk + chunk_size, end);
+            for (const PedestalTable* table : tables) {
+                for (size_t i = chunk; i < chunk_end; i++) {
+                    statistics_[i].Merge(table->statistics_[i]);
+                }
+            }
+        }
+    };
+
+    n_threads = std::max<size_t>(std::min(n_threads, statistics_.size() / chunk_size), 1);
+    size_t n_per_thread = (statistics_.size() + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (size_t i_thread = 1; i_thread < n_threads; i_thread++) {
+        size_t begin = std::min(i_thread * n_per_thread, statistics_.size());
+        size_t end = std::min(begin + n_per_thread, statistics_.size());
+        threads.emplace_back(merge_range, begin, end);
+    }
+    merge_range(0, std::min(n_per_thread, statistics_.size()));
+    for (auto& thread : threads) thread.join();
+
+    for (const PedestalTable* table : tables) n_events_ += table->n_events_;
+}
+
+void PedestalTable::Reset() {
+    std::fill(statistics_.begin(), statistics_.end(), PedestalCellStatistics());
+    n_events_ = 0;
+}
+
+std::vector<float> PedestalTable::GetMeanVector() const {
+    std::vector<float> mean(statistics_.size());
+    for (size_t i = 0; i < statistics_.size(); i++) {
+        mean[i] = statistics_[i].mean;
+    }
+    return mean;
+}
+
+std::vector<float> PedestalTable::GetStdDevVector() const {
+    std::vector<float> std_dev(statistics_.size());
+    for (size_t i = 0; i < statistics_.size(); i++) {
+        std_dev[i] = statistics_[i].GetStdDev();
+    }
+    return std_dev;
+}
+
+std::vector<uint32_t> PedestalTable::GetHitsVector() const {
+    std::vector<uint32_t> hits(statistics_.size());
+    for (size_t i = 0; i < statistics_.size(); i++) {
+        hits[i] = statistics_[i].n_hits;
+    }
+    return hits;
+}
+
+}}
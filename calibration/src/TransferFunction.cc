@@ -0,0 +1,315 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/calibration/TransferFunction.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSTCAM_TRANSFERFUNCTION_X86
+#include <immintrin.h>
+#endif
+
+namespace sstcam {
+namespace calibration {
+
+using descriptions::SampleUnpackingKernel;
+using descriptions::N_PIXELS_PER_MODULE;
+using descriptions::Waveform;
+using descriptions::WaveformDataPacket;
+
+namespace {
+
+// Clamp a sample to the range of the table. NaN samples are clamped to
+// adc_min, matching the SIMD max instructions.
+inline float Clamp(float sample, float adc_min, float adc_max) {
+    sample = sample > adc_min ? sample : adc_min;
+    return sample < adc_max ? sample : adc_max;
+}
+
+// Scalar kernel, also used for the samples remaining after the last full
+// vector of the SIMD kernels
+template <typename T>
+void ApplyTransferFunctionScalar(const T* input, const float* table,
+        float* output, size_t n_samples, float adc_min, float adc_max) {
+    for (size_t i = 0; i < n_samples; i++) {
+        float sample = Clamp(static_cast<float>(input[i]), adc_min, adc_max);
+        output[i] = table[static_cast<int32_t>(std::nearbyint(sample - adc_min))];
+    }
+}
+
+#ifdef SSTCAM_TRANSFERFUNCTION_X86
+
+__attribute__((target("avx2")))
+inline __m256 Load8(const float* input) {
+    return _mm256_loadu_ps(input);
+}
+
+__attribute__((target("avx2")))
+inline __m256 Load8(const uint16_t* input) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v));
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+void ApplyTransferFunctionAVX2(const T* input, const float* table,
+        float* output, size_t n_samples, float adc_min, float adc_max) {
+    const __m256 min = _mm256_set1_ps(adc_min);
+    const __m256 max = _mm256_set1_ps(adc_max);
+    size_t i = 0;
+    for (; i + 8 <= n_samples; i += 8) {
+        __m256 sample = _mm256_min_ps(_mm256_max_ps(Load8(&input[i]), min), max);
+        __m256i index = _mm256_cvtps_epi32(_mm256_sub_ps(sample, min));
+        _mm256_storeu_ps(&output[i], _mm256_i32gather_ps(table, index, 4));
+    }
+    ApplyTransferFunctionScalar(&input[i], table, &output[i], n_samples - i,
+                                adc_min, adc_max);
+}
+
+// The zero-masked forms (with every lane selected) are used for the AVX-512
+// intrinsics, as the unmasked forms trigger false -Wuninitialized warnings in
+// some GCC versions
+constexpr __mmask16 ALL_LANES = 0xFFFF;
+
+__attribute__((target("avx512f,avx512bw")))
+inline __m512 Load16(const float* input) {
+    return _mm512_maskz_loadu_ps(ALL_LANES, input);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline __m512 Load16(const uint16_t* input) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+    return _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu16_epi32(ALL_LANES, v));
+}
+
+template <typename T>
+__attribute__((target("avx512f,avx512bw")))
+void ApplyTransferFunctionAVX512(const T* input, const float* table,
+        float* output, size_t n_samples, float adc_min, float adc_max) {
+    const __m512 min = _mm512_set1_ps(adc_min);
+    const __m512 max = _mm512_set1_ps(adc_max);
+    size_t i = 0;
+    for (; i + 16 <= n_samples; i += 16) {
+        __m512 sample = _mm512_maskz_min_ps(ALL_LANES,
+            _mm512_maskz_max_ps(ALL_LANES, Load16(&input[i]), min), max);
+        __m512i index = _mm512_maskz_cvtps_epi32(ALL_LANES,
+            _mm512_maskz_sub_ps(ALL_LANES, sample, min));
+        __m512 mv = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), ALL_LANES,
+            index, table, 4);
+        _mm512_storeu_ps(&output[i], mv);
+    }
+    ApplyTransferFunctionScalar(&input[i], table, &output[i], n_samples - i,
+                                adc_min, adc_max);
+}
+
+#endif
+
+}
+
+template <typename T>
+ApplyTransferFunctionFunction<T> GetApplyTransferFunctionFunction(
+        SampleUnpackingKernel kernel) {
+    if (!descriptions::IsSampleUnpackingKernelSupported(kernel)) {
+        throw std::runtime_error("Transfer function kernel is not supported by this CPU");
+    }
+    switch (kernel) {
+#ifdef SSTCAM_TRANSFERFUNCTION_X86
+        case SampleUnpackingKernel::AVX512:
+            return ApplyTransferFunctionAVX512<T>;
+        case SampleUnpackingKernel::AVX2:
+            return ApplyTransferFunctionAVX2<T>;
+#endif
+        default:
+            return ApplyTransferFunctionScalar<T>;
+    }
+}
+
+template ApplyTransferFunctionFunction<uint16_t>
+GetApplyTransferFunctionFunction<uint16_t>(SampleUnpackingKernel kernel);
+template ApplyTransferFunctionFunction<float>
+GetApplyTransferFunctionFunction<float>(SampleUnpackingKernel kernel);
+
+TransferFunction::TransferFunction(size_t n_pixels, int32_t adc_min,
+        size_t n_adc, size_t n_cell_groups)
+    : n_pixels_(n_pixels),
+      adc_min_(adc_min),
+      n_adc_(n_adc),
+      n_cell_groups_(n_cell_groups),
+      group_shift_(0)
+{
+    if (n_adc == 0) {
+        throw std::runtime_error("TransferFunction requires at least one ADC entry");
+    }
+    if (n_cell_groups == 0 || n_cell_groups > N_STORAGE_CELLS ||
+        (n_cell_groups & (n_cell_groups - 1)) != 0) {
+        std::ostringstream ss;
+        ss << "Number of cell groups (" << n_cell_groups << ") must be a power "
+           << "of two no larger than " << N_STORAGE_CELLS;
+        throw std::runtime_error(ss.str());
+    }
+    while (static_cast<size_t>(N_STORAGE_CELLS >> group_shift_) > n_cell_groups) group_shift_++;
+    tables_.resize(n_pixels * n_cell_groups * n_adc, 0);
+
+    SampleUnpackingKernel kernel = descriptions::GetSampleUnpackingKernel();
+    apply_r0_ = GetApplyTransferFunctionFunction<uint16_t>(kernel);
+    apply_float_ = GetApplyTransferFunctionFunction<float>(kernel);
+}
+
+void TransferFunction::SetTables(const float* tables) {
+    std::copy_n(tables, tables_.size(), tables_.begin());
+}
+
+void TransferFunction::SetTable(uint16_t pixel, uint16_t cell_group,
+        const float* table) {
+    if (pixel >= n_pixels_ || cell_group >= n_cell_groups_) {
+        std::ostringstream ss;
+        ss << "Table (pixel " << pixel << ", cell group " << cell_group
+           << ") is not in the TransferFunction";
+        throw std::out_of_range(ss.str());
+    }
+    std::copy_n(table, n_adc_, &tables_[(pixel * n_cell_groups_ + cell_group) * n_adc_]);
+}
+
+void TransferFunction::SetTableFromPoints(uint16_t pixel, uint16_t cell_group,
+        const float* adc, const float* mv, size_t n_points) {
+    if (n_points == 0) {
+        throw std::runtime_error("At least one transfer function point is required");
+    }
+    for (size_t i = 1; i < n_points; i++) {
+        if (adc[i] <= adc[i - 1]) {
+            throw std::runtime_error("Transfer function points must be in increasing ADC order");
+        }
+    }
+    std::vector<float> table(n_adc_);
+    size_t i_point = 0;
+    for (size_t i = 0; i < n_adc_; i++) {
+        auto value = static_cast<float>(adc_min_ + static_cast<int64_t>(i));
+        while (i_point + 1 < n_points && adc[i_point + 1] <= value) i_point++;
+        if (value <= adc[0]) {
+            table[i] = mv[0];
+        } else if (i_point + 1 == n_points) {
+            table[i] = mv[n_points - 1];
+        } else {
+            float fraction = (value - adc[i_point]) / (adc[i_point + 1] - adc[i_point]);
+            table[i] = mv[i_point] + fraction * (mv[i_point + 1] - mv[i_point]);
+        }
+    }
+    SetTable(pixel, cell_group, table.data());
+}
+
+float TransferFunction::Lookup(uint16_t pixel, uint16_t cell, float sample) const {
+    auto adc_min = static_cast<float>(adc_min_);
+    auto adc_max = static_cast<float>(adc_min_ + static_cast<int64_t>(n_adc_) - 1);
+    float value;
+    ApplyTransferFunctionScalar(&sample, GetTable(pixel, GetCellGroup(cell)),
+                                &value, 1, adc_min, adc_max);
+    return value;
+}
+
+template <typename T>
+void TransferFunction::ApplyTemplate(ApplyTransferFunctionFunction<T> apply,
+        const T* input, float* output, size_t n_samples, uint16_t first_cell_id,
+        size_t first_pixel, size_t n_pixels) const {
+    auto adc_min = static_cast<float>(adc_min_);
+    auto adc_max = static_cast<float>(adc_min_ + static_cast<int64_t>(n_adc_) - 1);
+    if (n_cell_groups_ == 1) {
+        for (size_t i = 0; i < n_pixels; i++) {
+            size_t offset = i * n_samples;
+            apply(&input[offset], &tables_[(first_pixel + i) * n_adc_],
+                  &output[offset], n_samples, adc_min, adc_max);
+        }
+        return;
+    }
+
+    // The waveforms are split into contiguous segments of samples that share
+    // a cell group (the storage array is circular)
+    for (size_t i = 0; i < n_pixels; i++) {
+        size_t offset = i * n_samples;
+        size_t i_pixel = first_pixel + i;
+        size_t isample = 0;
+        while (isample < n_samples) {
+            size_t cell = (first_cell_id + isample) % N_STORAGE_CELLS;
+            size_t group = cell >> group_shift_;
+            size_t group_end = (group + 1) << group_shift_;
+            size_t n_segment = std::min(n_samples - isample, group_end - cell);
+            apply(&input[offset + isample],
+                  &tables_[(i_pixel * n_cell_groups_ + group) * n_adc_],
+                  &output[offset + isample], n_segment, adc_min, adc_max);
+            isample += n_segment;
+        }
+    }
+}
+
+void TransferFunction::Apply(const uint16_t* adc, float* mv, size_t n_samples,
+        uint16_t first_cell_id) const {
+    ApplyTemplate(apply_r0_, adc, mv, n_samples, first_cell_id, 0, n_pixels_);
+}
+
+void TransferFunction::Apply(const float* samples, float* mv, size_t n_samples,
+        uint16_t first_cell_id) const {
+    ApplyTemplate(apply_float_, samples, mv, n_samples, first_cell_id, 0, n_pixels_);
+}
+
+void TransferFunction::Apply(const float* samples, float* mv, size_t n_samples,
+        uint16_t first_cell_id, size_t first_pixel, size_t n_pixels) const {
+    if (first_pixel + n_pixels > n_pixels_) {
+        std::ostringstream ss;
+        ss << "Pixels [" << first_pixel << ", " << first_pixel + n_pixels
+           << ") are not in the TransferFunction (n_pixels = " << n_pixels_ << ")";
+        throw std::out_of_range(ss.str());
+    }
+    ApplyTemplate(apply_float_, samples, mv, n_samples, first_cell_id,
+                  first_pixel, n_pixels);
+}
+
+void TransferFunction::Apply(const descriptions::WaveformEventR0& event,
+        const float* samples, float* mv) const {
+    if (event.GetNPixels() != n_pixels_) {
+        std::ostringstream ss;
+        ss << "Event has " << event.GetNPixels() << " pixels, TransferFunction has "
+           << n_pixels_;
+        throw std::runtime_error(ss.str());
+    }
+    size_t n_modules = n_pixels_ / N_PIXELS_PER_MODULE;
+    const std::vector<WaveformDataPacket*>& packets = event.GetPackets();
+    const std::vector<bool>& missing = event.GetMissingPacketMask();
+    for (size_t ipack = 0; ipack < packets.size(); ipack++) {
+        if (missing[ipack]) continue;
+        const WaveformDataPacket* packet = packets[ipack];
+        uint8_t module = packet->GetSlotID() - event.GetFirstActiveModuleSlot();
+        if (module >= n_modules) continue;
+        size_t n_samples = event.GetNSamples();
+        size_t offset = module * N_PIXELS_PER_MODULE * n_samples;
+        ApplyPacket(*packet, module, n_samples, &samples[offset], &mv[offset]);
+    }
+}
+
+void TransferFunction::ApplyPacket(const WaveformDataPacket& packet,
+        size_t module, size_t n_samples, const float* module_samples,
+        float* module_mv) const {
+    if ((module + 1) * N_PIXELS_PER_MODULE > n_pixels_) {
+        std::ostringstream ss;
+        ss << "Module " << module << " is not in the TransferFunction (n_pixels = "
+           << n_pixels_ << ")";
+        throw std::out_of_range(ss.str());
+    }
+    uint16_t first_cell = packet.GetFirstCellID();
+    uint16_t n_waveforms = packet.GetNWaveforms();
+    const uint8_t* waveform_data = &packet.GetDataPacket()[packet.GetWaveformStart(0)];
+    uint16_t waveform_n_bytes = packet.GetWaveformNBytes();
+    Waveform waveform;
+    for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+        waveform.Associate(const_cast<uint8_t*>(waveform_data));
+        waveform_data += waveform_n_bytes;
+        if (waveform.IsZeroSuppressed()) continue; // Not written by the Calibrator
+        uint16_t pixel_id = waveform.GetPixelID();
+        size_t offset = pixel_id * n_samples;
+        ApplyTemplate(apply_float_, &module_samples[offset], &module_mv[offset],
+                      n_samples, first_cell, module * N_PIXELS_PER_MODULE + pixel_id, 1);
+    }
+}
+
+}}
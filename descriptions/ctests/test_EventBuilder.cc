@@ -0,0 +1,189 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/descriptions/EventBuilder.h"
+#include "sstcam/descriptions/WaveformDataPacketPool.h"
+#include "doctest.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+TEST_CASE("EventBuilder") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    std::vector<uint8_t> example(packet_size);
+    file.read(reinterpret_cast<char*>(example.data()), packet_size);
+
+    WaveformDataPacketPool pool(packet_size, 64);
+    size_t n_packets_per_event = 4; // One packet from each of the first 4 modules
+    size_t n_pixels = 2048;
+
+    // Copy of the example packet, moved to another module slot and TACK
+    auto make_packet = [&](uint8_t slot, uint8_t event) {
+        auto packet = pool.Acquire();
+        std::copy(example.begin(), example.end(), packet->GetDataPacket());
+        packet->GetDataPacket()[4] = slot;
+        packet->GetDataPacket()[3] = event;
+        return packet;
+    };
+
+    SUBCASE("Complete events") {
+        EventBuilderR1 builder(n_packets_per_event, n_pixels, 0, 8);
+        CHECK(builder.GetNEventsInRing() == 8);
+        std::vector<std::shared_ptr<WaveformDataPacket>> packets;
+        for (uint8_t event = 0; event < 3; event++) {
+            for (uint8_t slot = 0; slot < n_packets_per_event; slot++) {
+                packets.push_back(make_packet(slot, event));
+            }
+        }
+        std::shuffle(packets.begin(), packets.end(), std::mt19937(1));
+        for (auto& packet : packets) builder.AddPacket(packet);
+        packets.clear();
+
+        std::set<uint64_t> tacks;
+        for (size_t i = 0; i < 3; i++) {
+            WaveformEventR1* event = builder.PopEvent();
+            REQUIRE(event);
+            CHECK(event->IsFilled());
+            CHECK(!event->IsMissingPackets());
+            CHECK(event->GetCPUTimeSecond() > 0);
+            std::set<uint8_t> slots;
+            for (auto* packet : event->GetPackets()) {
+                slots.insert(packet->GetSlotID());
+                CHECK(packet->GetTACK() == event->GetTACK());
+            }
+            CHECK(slots == std::set<uint8_t>{0, 1, 2, 3});
+            tacks.insert(event->GetTACK());
+            builder.ReleaseEvent(event);
+        }
+        CHECK(tacks.size() == 3);
+        CHECK(builder.PopEvent() == nullptr);
+        CHECK(pool.GetNPacketsInUse() == 0);
+
+        EventBuilderStats stats = builder.GetStats();
+        CHECK(stats.n_packets == 12);
+        CHECK(stats.n_complete_events == 3);
+        CHECK(stats.n_incomplete_events == 0);
+        CHECK(stats.n_missing_packets == 0);
+
+        WaveformEventR1 other(n_packets_per_event, n_pixels);
+        CHECK_THROWS_AS(builder.ReleaseEvent(&other), std::runtime_error);
+    }
+
+    SUBCASE("Duplicate, late, invalid and stale packets") {
+        EventBuilderR0 builder(n_packets_per_event, n_pixels, 0, 8);
+        auto stale = make_packet(0, 0);
+        stale->GetDataPacket()[14] |= 0x40u;
+        builder.AddPacket(stale);
+        builder.AddPacket(make_packet(0, 0)); // Duplicate
+        builder.AddPacket(make_packet(40, 0)); // Outside of the camera
+        builder.AddPacket(nullptr);
+        for (uint8_t slot = 1; slot < n_packets_per_event; slot++) {
+            builder.AddPacket(make_packet(slot, 0));
+        }
+        WaveformEventR0* event = builder.PopEvent();
+        REQUIRE(event);
+        CHECK(event->IsStale());
+        builder.AddPacket(make_packet(2, 0)); // Late
+        builder.ReleaseEvent(event);
+        builder.AddPacket(make_packet(3, 0)); // Late
+        CHECK(builder.PopEvent() == nullptr);
+
+        EventBuilderStats stats = builder.GetStats();
+        CHECK(stats.n_packets == 9);
+        CHECK(stats.n_stale_packets == 1);
+        CHECK(stats.n_duplicate_packets == 1);
+        CHECK(stats.n_invalid_packets == 2);
+        CHECK(stats.n_late_packets == 2);
+        CHECK(stats.n_complete_events == 1);
+    }
+
+    SUBCASE("Timeout") {
+        EventBuilderR1 builder(n_packets_per_event, n_pixels, 0, 8,
+                               std::chrono::milliseconds(10));
+        builder.AddPacket(make_packet(0, 0));
+        builder.AddPacket(make_packet(2, 0));
+        CHECK(builder.PopEvent() == nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        WaveformEventR1* event = builder.PopEvent();
+        REQUIRE(event);
+        CHECK(event->GetNPacketsAdded() == 2);
+        CHECK(event->IsMissingPackets());
+        builder.ReleaseEvent(event);
+
+        builder.AddPacket(make_packet(1, 1));
+        CHECK(builder.CloseAllEvents() == 1);
+        event = builder.PopEvent();
+        REQUIRE(event);
+        builder.ReleaseEvent(event);
+
+        EventBuilderStats stats = builder.GetStats();
+        CHECK(stats.n_incomplete_events == 2);
+        CHECK(stats.n_missing_packets == 5);
+    }
+
+    SUBCASE("Ring full") {
+        EventBuilderR1 builder(n_packets_per_event, n_pixels, 0, 2);
+        for (uint8_t event = 0; event < 3; event++) {
+            builder.AddPacket(make_packet(0, event));
+        }
+        CHECK(builder.GetStats().n_dropped_packets == 1);
+
+        // Space is made once an event is emitted and released
+        CHECK(builder.CloseAllEvents() == 2);
+        builder.ReleaseEvent(builder.PopEvent());
+        builder.AddPacket(make_packet(0, 2));
+        CHECK(builder.GetStats().n_dropped_packets == 1);
+    }
+
+    SUBCASE("Threads") {
+        EventBuilderR1 builder(n_packets_per_event, n_pixels, 0, 16);
+        size_t n_events = 200;
+        std::atomic<size_t> n_released(0);
+
+        // One receiver thread per module, each progressing at its own pace
+        std::vector<std::thread> receivers;
+        for (uint8_t slot = 0; slot < n_packets_per_event; slot++) {
+            receivers.emplace_back([&, slot]() {
+                for (size_t event = 0; event < n_events; event++) {
+                    auto packet = make_packet(slot, static_cast<uint8_t>(event));
+                    while (n_released + 8 <= event) {
+                        std::this_thread::yield(); // Do not exhaust the ring
+                    }
+                    builder.AddPacket(packet);
+                }
+            });
+        }
+
+        while (n_released < n_events) {
+            WaveformEventR1* event = builder.PopEvent();
+            if (!event) {
+                std::this_thread::yield();
+                continue;
+            }
+            CHECK(!event->IsMissingPackets());
+            builder.ReleaseEvent(event);
+            n_released++;
+        }
+        for (auto& thread : receivers) thread.join();
+
+        EventBuilderStats stats = builder.GetStats();
+        CHECK(stats.n_complete_events == n_events);
+        CHECK(stats.n_incomplete_events == 0);
+        CHECK(stats.n_duplicate_packets == 0);
+        CHECK(stats.n_late_packets == 0);
+        CHECK(stats.n_dropped_packets == 0);
+        CHECK(pool.GetNPacketsInUse() == 0);
+    }
+}
+
+}
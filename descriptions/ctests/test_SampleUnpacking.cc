@@ -0,0 +1,66 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include "doctest.h"
+#include <random>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+TEST_CASE("SampleUnpacking") {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    size_t n_samples_max = 200;
+    std::vector<uint8_t> data(2 + 2 * n_samples_max);
+    for (uint8_t& byte : data) byte = static_cast<uint8_t>(dist(rng));
+
+    Waveform waveform;
+    waveform.Associate(data.data());
+    float scale = 23.4f;
+    float offset = 11.f;
+
+    CHECK(IsSampleUnpackingKernelSupported(SampleUnpackingKernel::SCALAR));
+    CHECK(IsSampleUnpackingKernelSupported(GetSampleUnpackingKernel()));
+
+    // Specialized kernels are used for the common waveform lengths
+    CHECK(GetUnpackSamplesR0Function(128) != GetUnpackSamplesR0Function(200));
+    CHECK(GetUnpackSamplesR0Function(200) == GetUnpackSamplesR0Function(16));
+    CHECK(GetUnpackSamplesR1Function(96) == GetUnpackSamplesR1Function(96));
+    CHECK(GetUnpackSamplesR1Function(SampleUnpackingKernel::SCALAR, 64) !=
+          GetUnpackSamplesR1Function(SampleUnpackingKernel::SCALAR, 96));
+
+    for (auto kernel : {SampleUnpackingKernel::SCALAR, SampleUnpackingKernel::SSE4,
+                        SampleUnpackingKernel::AVX2, SampleUnpackingKernel::AVX512}) {
+        if (!IsSampleUnpackingKernelSupported(kernel)) {
+            std::vector<uint16_t> r0(1);
+            CHECK_THROWS_AS(UnpackSamplesR0(kernel, waveform.GetSampleData(), r0.data(), 1),
+                            std::runtime_error);
+            continue;
+        }
+
+        // Include lengths that are not a multiple of the vector width
+        for (size_t n_samples : {0, 1, 7, 8, 15, 16, 31, 32, 33, 64, 96, 128, 200}) {
+            std::vector<uint16_t> r0(n_samples + 1, 0xFFFF);
+            std::vector<float> r1(n_samples + 1, -1.f);
+            UnpackSamplesR0(kernel, waveform.GetSampleData(), r0.data(), n_samples);
+            UnpackSamplesR1(kernel, waveform.GetSampleData(), r1.data(), n_samples, scale, offset);
+
+            size_t n_mismatch_r0 = 0;
+            size_t n_mismatch_r1 = 0;
+            for (uint16_t i = 0; i < n_samples; i++) {
+                if (r0[i] != GetSampleR0(waveform, i)) n_mismatch_r0++;
+                if (r1[i] != GetSampleR1(waveform, i, scale, offset)) n_mismatch_r1++;
+            }
+            CHECK(n_mismatch_r0 == 0);
+            CHECK(n_mismatch_r1 == 0);
+            CHECK(r0[n_samples] == 0xFFFF); // Nothing written past the end
+            CHECK(r1[n_samples] == -1.f);
+        }
+    }
+}
+
+}
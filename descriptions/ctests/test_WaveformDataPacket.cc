@@ -3,7 +3,9 @@
 
 #include "sstcam/descriptions/WaveformDataPacket.h"
 #include "doctest.h"
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 namespace sstcam::descriptions {
 
@@ -30,6 +32,37 @@ TEST_CASE("WaveformDataPacket") {
         CHECK(!packet.IsEmpty());
     }
 
+    SUBCASE("View") {
+        std::vector<uint8_t> buffer(2 * packet_size);
+        file.read(reinterpret_cast<char*>(buffer.data()), packet_size);
+        WaveformDataPacket packet(buffer.data(), packet_size);
+        CHECK(!packet.OwnsMemory());
+        CHECK(packet.GetDataPacket() == buffer.data());
+        CHECK(packet.GetPacketSize() == packet_size);
+        CHECK(packet.GetTACK() == 2165717354592);
+        CHECK(packet.IsValid());
+
+        // Changes to the buffer are seen by the view
+        buffer[4] = 3;
+        CHECK(packet.GetSlotID() == 3);
+
+        // Wrap a different part of the buffer
+        packet.Wrap(&buffer[packet_size]);
+        CHECK(packet.GetDataPacket() == &buffer[packet_size]);
+        CHECK(packet.IsEmpty());
+
+        // Moving keeps the view
+        WaveformDataPacket moved(std::move(packet));
+        CHECK(!moved.OwnsMemory());
+        CHECK(moved.GetDataPacket() == &buffer[packet_size]);
+
+        WaveformDataPacket owner(packet_size);
+        CHECK(owner.OwnsMemory());
+        owner.Wrap(buffer.data());
+        CHECK(!owner.OwnsMemory());
+        CHECK(owner.GetSlotID() == 3);
+    }
+
     SUBCASE("Getters") {
         WaveformDataPacket packet(packet_size);
         file.read(reinterpret_cast<char*>(packet.GetDataPacket()), packet_size);
@@ -92,6 +125,37 @@ TEST_CASE("WaveformDataPacket") {
 
         file.read(reinterpret_cast<char*>(packet.GetDataPacket()), packet_size);
         CHECK(packet.IsValid());
+        CHECK(packet.IsValid(true));
+        CHECK(packet.IsCRCValid());
+        CHECK(packet.GetCRC() == 0x94BE);
+
+        // Corrupt a sample
+        packet.GetDataPacket()[100] ^= 0x4u;
+        CHECK(packet.IsValid());
+        CHECK(!packet.IsValid(true));
+        CHECK(!packet.IsCRCValid());
+        packet.GetDataPacket()[100] ^= 0x4u;
+
+        // Slab of packets, with a gap between them
+        size_t stride = packet_size + 10;
+        std::vector<uint8_t> slab(3 * stride, 0);
+        for (size_t i = 0; i < 3; i++) {
+            std::copy_n(packet.GetDataPacket(), packet_size, &slab[i * stride]);
+        }
+        slab[stride + 500] ^= 0x1u;
+        std::vector<bool> valid = ValidatePacketSlab(slab.data(), 3, packet_size, stride);
+        CHECK(valid == std::vector<bool>{true, false, true});
+        valid = ValidatePacketSlab(slab.data(), 3, packet_size, stride, false);
+        CHECK(valid == std::vector<bool>{true, true, true});
+    }
+
+    SUBCASE("CRC") {
+        // CRC-16/CCITT-FALSE check value
+        const std::string check = "123456789";
+        auto* data = reinterpret_cast<const uint8_t*>(check.data());
+        CHECK(WaveformDataPacket::CalculateCRC(data, check.size()) == 0x29B1);
+        CHECK(WaveformDataPacket::CalculateCRC(data, 0) == 0xFFFF);
+        CHECK(WaveformDataPacket::CalculateCRC(data, 1) == 0xC782);
     }
 
     SUBCASE("Waveform Start") {
@@ -0,0 +1,116 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/descriptions/WaveformDataPacketPool.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include "doctest.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+TEST_CASE("WaveformDataPacketPool") {
+    size_t packet_size = 8276;
+    size_t n_packets_per_slab = 4;
+
+    SUBCASE("Acquire and release") {
+        WaveformDataPacketPool pool(packet_size, n_packets_per_slab);
+        CHECK(pool.GetPacketSize() == packet_size);
+        CHECK(pool.GetNPacketsPerSlab() == n_packets_per_slab);
+        CHECK(pool.GetNSlabs() == 0);
+
+        std::vector<std::shared_ptr<WaveformDataPacket>> packets;
+        for (size_t i = 0; i < 6; i++) packets.push_back(pool.Acquire());
+        CHECK(pool.GetNSlabs() == 2);
+        CHECK(pool.GetNPacketsInUse() == 6);
+        CHECK(pool.GetNPacketsFree() == 2);
+
+        for (const auto& packet : packets) {
+            CHECK(packet->GetPacketSize() == packet_size);
+            CHECK(!packet->OwnsMemory());
+            CHECK(packet->IsEmpty());
+            CHECK(reinterpret_cast<uintptr_t>(packet->GetDataPacket()) % 64 == 0);
+        }
+        CHECK(packets[0]->GetDataPacket() != packets[1]->GetDataPacket());
+
+        // Released packets are recycled, and zeroed when reacquired
+        uint8_t* buffer = packets[5]->GetDataPacket();
+        buffer[0] = 0xFF;
+        packets.pop_back();
+        CHECK(pool.GetNPacketsInUse() == 5);
+        auto packet = pool.Acquire();
+        CHECK(packet->GetDataPacket() == buffer);
+        CHECK(packet->IsEmpty());
+        CHECK(pool.GetNSlabs() == 2);
+
+        packets.clear();
+        packet = nullptr;
+        CHECK(pool.GetNPacketsInUse() == 0);
+
+        pool.Reserve(10);
+        CHECK(pool.GetNSlabs() == 3);
+        CHECK(pool.GetNPacketsFree() == 12);
+
+        CHECK_THROWS_AS(WaveformDataPacketPool(0), std::runtime_error);
+    }
+
+    SUBCASE("Huge pages") {
+        WaveformDataPacketPool pool(packet_size, n_packets_per_slab, true);
+        // The slab is extended to fill a whole huge page
+        CHECK(pool.GetNPacketsPerSlab() == (2 * 1024 * 1024) / 8320);
+        auto packet = pool.Acquire();
+        CHECK(packet->IsEmpty());
+    }
+
+    SUBCASE("WaveformEvent") {
+        std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+        std::ifstream file (path, std::ios::in | std::ios::binary);
+        CHECK(file.is_open());
+        WaveformDataPacketPool pool(packet_size, n_packets_per_slab);
+
+        auto packet = pool.Acquire();
+        file.read(reinterpret_cast<char*>(packet->GetDataPacket()), packet_size);
+        CHECK(packet->IsValid(true));
+
+        WaveformEventR1 event(1, 2048, 0, 0, 0, 10, 3);
+        event.AddPacketShared(packet);
+        packet = nullptr;
+        CHECK(pool.GetNPacketsInUse() == 1);
+        CHECK(event.GetPackets()[0]->IsValid(true));
+
+        // The packet is returned to the pool when the event is reset
+        event.Reset();
+        CHECK(pool.GetNPacketsInUse() == 0);
+    }
+
+    SUBCASE("Packets outlive the pool") {
+        std::shared_ptr<WaveformDataPacket> packet;
+        {
+            WaveformDataPacketPool pool(packet_size, n_packets_per_slab);
+            packet = pool.Acquire();
+        }
+        packet->GetDataPacket()[packet_size - 1] = 1;
+        CHECK(!packet->IsEmpty());
+    }
+
+    SUBCASE("Threads") {
+        WaveformDataPacketPool pool(packet_size, n_packets_per_slab);
+        std::vector<std::thread> threads;
+        for (size_t ithread = 0; ithread < 4; ithread++) {
+            threads.emplace_back([&pool]() {
+                for (size_t i = 0; i < 1000; i++) {
+                    auto packet = pool.Acquire();
+                    packet->GetDataPacket()[0] = 1;
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        CHECK(pool.GetNPacketsInUse() == 0);
+        CHECK(pool.GetNSlabs() <= 4);
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#define DOCTEST_CONFIG_VOID_CAST_EXPRESSIONS
+
+#include "sstcam/descriptions/WaveformDecodePlan.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include "doctest.h"
+#include <fstream>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+TEST_CASE("WaveformDecodePlan") {
+    std::string path = "../../share/sstcam/descriptions/waveform_data_packet_example.bin";
+    size_t packet_size = 8276;
+    std::ifstream file (path, std::ios::in | std::ios::binary);
+    CHECK(file.is_open());
+    auto packet = std::make_shared<WaveformDataPacket>(packet_size);
+    file.read(reinterpret_cast<char*>(packet->GetDataPacket()), packet_size);
+
+    size_t n_pixels = 2048;
+    WaveformEventR1 event(1, n_pixels, 0, 0, 0, 10, 3);
+    event.AddPacket(packet.get());
+    std::vector<float> expected = event.GetWaveformSamplesVector();
+
+    SUBCASE("Entries") {
+        WaveformDecodePlan plan(event.GetPackets(), 0);
+        CHECK(plan.GetNSamples() == packet->GetWaveformNSamples());
+        REQUIRE(plan.GetEntries().size() == packet->GetNWaveforms());
+        Waveform waveform;
+        for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++) {
+            waveform.Associate(packet.get(), iwav);
+            const WaveformDecodePlan::Entry& entry = plan.GetEntries()[iwav];
+            CHECK(entry.packet_index == 0);
+            CHECK(&packet->GetDataPacket()[entry.byte_offset] == waveform.GetSampleData());
+            CHECK(entry.pixel == packet->GetSlotID() * N_PIXELS_PER_MODULE + waveform.GetPixelID());
+        }
+        CHECK(plan.Matches(event.GetPackets()));
+    }
+
+    SUBCASE("Missing packets") {
+        WaveformEventR1 empty_event(1, n_pixels, 0);
+        CHECK_THROWS_AS(empty_event.CreateDecodePlan(), std::runtime_error);
+    }
+
+    SUBCASE("Fill with plan") {
+        auto plan = event.CreateDecodePlan();
+
+        // Another event with a copy of the packet
+        auto packet_copy = std::make_shared<WaveformDataPacket>(packet_size);
+        std::copy_n(packet->GetDataPacket(), packet_size, packet_copy->GetDataPacket());
+        WaveformEventR1 event_copy(1, n_pixels, 0, 0, 0, 10, 3);
+        event_copy.AddPacket(packet_copy.get());
+        event_copy.SetDecodePlan(plan);
+        CHECK(event_copy.GetDecodePlan() == plan);
+        CHECK(event_copy.GetWaveformSamplesVector() == expected);
+        CHECK(event_copy.GetWaveformSamplesVector(SampleLayout::SAMPLE_MAJOR) ==
+              event.GetWaveformSamplesVector(SampleLayout::SAMPLE_MAJOR));
+
+        // Packet geometry differs: the plan is not used
+        packet_copy->GetDataPacket()[4]++; // Slot ID
+        CHECK(!plan->Matches(event_copy.GetPackets()));
+        WaveformEventR1 event_moved(1, n_pixels, 0, 0, 0, 10, 3);
+        event_moved.AddPacket(packet_copy.get());
+        CHECK(event_copy.GetWaveformSamplesVector() ==
+              event_moved.GetWaveformSamplesVector());
+        CHECK(event_copy.GetWaveformSamplesVector() != expected);
+
+        // Same geometry, but different channels read out: the plan is not used
+        packet_copy->GetDataPacket()[4]--;
+        REQUIRE(plan->Matches(event_copy.GetPackets()));
+        uint8_t* first = &packet_copy->GetDataPacket()[packet_copy->GetWaveformStart(0)];
+        uint8_t* second = &packet_copy->GetDataPacket()[packet_copy->GetWaveformStart(1)];
+        std::swap(first[0], second[0]); // Swap the channels of two waveforms
+        CHECK(!plan->Matches(event_copy.GetPackets()));
+        WaveformEventR1 event_swapped(1, n_pixels, 0, 0, 0, 10, 3);
+        event_swapped.AddPacket(packet_copy.get());
+        CHECK(event_copy.GetWaveformSamplesVector() ==
+              event_swapped.GetWaveformSamplesVector());
+        CHECK(event_copy.GetWaveformSamplesVector() != expected);
+        first[0] = static_cast<uint8_t>(first[0] + 0x40u); // Channel of an absent pixel
+        CHECK(!plan->Matches(event_copy.GetPackets()));
+
+        WaveformEventR1 event_missing(2, n_pixels, 0);
+        event_missing.AddPacket(packet.get());
+        event_missing.SetDecodePlan(plan);
+        CHECK(!plan->Matches(event_missing.GetPackets()));
+    }
+}
+
+}
@@ -5,7 +5,9 @@
 
 #include "sstcam/descriptions/WaveformEvent.h"
 #include "doctest.h"
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 namespace sstcam::descriptions {
 
@@ -115,6 +117,31 @@ TEST_CASE("WaveformEvent") {
         CHECK(event.IsFilled());
         CHECK(event.GetNPacketsAdded() == 1);
         CHECK(event.GetPackets()[0] == packet_ptr2.get());
+        CHECK(event.IsMissingPackets()); // packet_ptr2 is empty
+        CHECK(event.GetMissingPacketMask() == std::vector<bool>{true});
+        CHECK_THROWS_AS(event.GetTACK(), std::runtime_error);
+    }
+
+    SUBCASE("Packet Summary") {
+        auto empty_packet = std::make_shared<WaveformDataPacket>(packet_size);
+        WaveformEventR0 event(3);
+        CHECK(event.GetMissingPacketMask() == std::vector<bool>{true, true, true});
+        event.AddPacket(empty_packet.get());
+        event.AddPacket(packet.get());
+        CHECK(event.GetMissingPacketMask() == std::vector<bool>{true, false, true});
+        CHECK(event.GetTACK() == packet->GetTACK());
+        CHECK(event.GetFirstCellID() == packet->GetFirstCellID());
+        CHECK(event.IsStale() == (packet->GetStaleBit() == 1));
+        CHECK(event.GetNSamples() == packet->GetWaveformNSamples());
+        event.AddPacket(packet.get());
+        CHECK(event.IsFilled());
+        CHECK(event.IsMissingPackets());
+
+        event.Reset();
+        CHECK(event.GetMissingPacketMask() == std::vector<bool>{true, true, true});
+        CHECK_THROWS_AS(event.GetTACK(), std::runtime_error);
+        for (int i = 0; i < 3; i++) event.AddPacket(packet.get());
+        CHECK(!event.IsMissingPackets());
     }
 
     SUBCASE("WaveformEventR0 Adding Packets (shared)") {
@@ -150,6 +177,18 @@ TEST_CASE("WaveformEvent") {
         CHECK(event.GetPackets()[0] == packet_ptr2.get());
     }
 
+    SUBCASE("WaveformEventR0 Packet Views") {
+        std::vector<uint8_t> buffer(packet->GetDataPacket(),
+                                    packet->GetDataPacket() + packet_size);
+        WaveformDataPacket view(buffer.data(), packet_size);
+        WaveformEventR0 event_view(n_packets_per_event, n_pixels, first_active_module_slot);
+        event_view.AddPacket(&view);
+        WaveformEventR0 event(n_packets_per_event, n_pixels, first_active_module_slot);
+        event.AddPacket(packet.get());
+        CHECK(event_view.GetTACK() == event.GetTACK());
+        CHECK(event_view.GetWaveformSamplesVector() == event.GetWaveformSamplesVector());
+    }
+
     SUBCASE("WaveformEventR0 Owning Packets") {
         WaveformEventR0 event(n_packets_per_event);
         auto packet_ptr = std::make_shared<WaveformDataPacket>(packet_size);
@@ -237,6 +276,132 @@ TEST_CASE("WaveformEvent") {
         CHECK(all_zero);
     }
 
+    SUBCASE("Waveform Samples Layouts") {
+        // Full camera event, with the packet's module at its slot
+        WaveformEventR1 event_camera(n_packets_per_event, 2048, 0, 0, 0, 10, 3);
+        event_camera.AddPacket(packet.get());
+        for (const WaveformEventR1& event : {event_r1_so, event_camera}) {
+            size_t n_pix = event.GetNPixels();
+            std::vector<float> pixel_major = event.GetWaveformSamplesVector();
+            std::vector<float> sample_major = event.GetWaveformSamplesVector(
+                SampleLayout::SAMPLE_MAJOR);
+            std::vector<float> module_tiles = event.GetWaveformSamplesVector(
+                SampleLayout::MODULE_TILES);
+
+            size_t n_mismatch = 0;
+            for (size_t ipix = 0; ipix < n_pix; ipix++) {
+                size_t imod = ipix / N_PIXELS_PER_MODULE;
+                size_t ipix_mod = ipix % N_PIXELS_PER_MODULE;
+                for (size_t isam = 0; isam < n_samples; isam++) {
+                    float value = pixel_major[ipix * n_samples + isam];
+                    if (sample_major[isam * n_pix + ipix] != value) n_mismatch++;
+                    size_t i_tile = (imod * n_samples + isam) * N_PIXELS_PER_MODULE + ipix_mod;
+                    if (module_tiles[i_tile] != value) n_mismatch++;
+                }
+            }
+            CHECK(n_mismatch == 0);
+        }
+
+        std::vector<uint16_t> pixel_major = event_r0.GetWaveformSamplesVector();
+        std::vector<uint16_t> sample_major = event_r0.GetWaveformSamplesVector(
+            SampleLayout::SAMPLE_MAJOR);
+        CHECK(sample_major[5 * n_pixels + 7] == pixel_major[7 * n_samples + 5]);
+    }
+
+    SUBCASE("Waveform Samples Subsets") {
+        WaveformEventR0 event_camera(n_packets_per_event, 2048, 0);
+        event_camera.AddPacket(packet.get());
+        std::vector<uint16_t> all = event_camera.GetWaveformSamplesVector();
+        uint8_t slot = packet->GetSlotID();
+
+        std::vector<uint16_t> pixels = {
+            static_cast<uint16_t>(slot * N_PIXELS_PER_MODULE + 3), 5,
+            static_cast<uint16_t>(slot * N_PIXELS_PER_MODULE)
+        };
+        std::vector<uint16_t> pixel_subset = event_camera.GetPixelSubsetVector(pixels);
+        REQUIRE(pixel_subset.size() == 3 * n_samples);
+        size_t n_mismatch = 0;
+        for (size_t i = 0; i < pixels.size(); i++) {
+            for (size_t isam = 0; isam < n_samples; isam++) {
+                if (pixel_subset[i * n_samples + isam] != all[pixels[i] * n_samples + isam])
+                    n_mismatch++;
+            }
+        }
+        CHECK(n_mismatch == 0);
+        CHECK(pixel_subset[n_samples] == 0); // Pixel 5 has no packet
+
+        std::vector<uint16_t> module_subset = event_camera.GetModuleSubsetVector({2, slot});
+        REQUIRE(module_subset.size() == 2 * N_PIXELS_PER_MODULE * n_samples);
+        size_t module_size = N_PIXELS_PER_MODULE * n_samples;
+        CHECK(std::all_of(module_subset.begin(), module_subset.begin() + module_size,
+                          [](uint16_t sample) { return sample == 0; }));
+        CHECK(std::equal(module_subset.begin() + module_size, module_subset.end(),
+                         all.begin() + slot * module_size));
+
+        CHECK(event_camera.GetModuleSubsetVector({}).empty());
+        CHECK_THROWS_AS(event_camera.GetPixelSubsetVector({2048}), std::out_of_range);
+        CHECK_THROWS_AS(event_camera.GetPixelSubsetVector({3, 7, 3}), std::invalid_argument);
+        CHECK_THROWS_AS(event_camera.GetModuleSubsetVector({32}), std::out_of_range);
+        CHECK_THROWS_AS(event_r1.GetModuleSubsetVector({0}), std::out_of_range);
+        CHECK(event_r1.GetModuleSubsetVector({slot}) == event_r1.GetWaveformSamplesVector());
+    }
+
+    SUBCASE("Sparse Waveform Samples") {
+        // Zero-suppress every other waveform of a copy of the packet
+        auto packet_zs = std::make_shared<WaveformDataPacket>(packet_size);
+        std::copy_n(packet->GetDataPacket(), packet_size, packet_zs->GetDataPacket());
+        for (uint16_t iwav = 0; iwav < packet_zs->GetNWaveforms(); iwav += 2) {
+            packet_zs->GetDataPacket()[packet_zs->GetWaveformStart(iwav) + 1] |= 0x80u;
+        }
+        WaveformEventR1 event_camera(n_packets_per_event, 2048, 0);
+        event_camera.AddPacket(packet_zs.get());
+        std::vector<float> dense = event_camera.GetWaveformSamplesVector();
+
+        uint8_t slot = packet->GetSlotID();
+        std::vector<uint16_t> present = event_camera.GetPresentPixels();
+        CHECK(event_camera.GetNPixelsPresent() == present.size());
+        CHECK(present.size() == packet->GetNWaveforms() / 2);
+        CHECK(std::is_sorted(present.begin(), present.end()));
+        Waveform waveform;
+        for (uint16_t iwav = 0; iwav < packet_zs->GetNWaveforms(); iwav++) {
+            waveform.Associate(packet_zs.get(), iwav);
+            auto pixel = static_cast<uint16_t>(slot * N_PIXELS_PER_MODULE + waveform.GetPixelID());
+            bool is_present = std::binary_search(present.begin(), present.end(), pixel);
+            CHECK(is_present == !waveform.IsZeroSuppressed());
+        }
+
+        SparseWaveformSamples<float> sparse = event_camera.GetSparseWaveformSamples();
+        CHECK(sparse.pixels == present);
+        CHECK(sparse.n_samples == n_samples);
+        REQUIRE(sparse.samples.size() == present.size() * n_samples);
+        for (size_t row = 0; row < present.size(); row++) {
+            CHECK(sparse.GetRow(present[row]) == static_cast<int32_t>(row));
+            CHECK(std::equal(&sparse.samples[row * n_samples], &sparse.samples[(row + 1) * n_samples],
+                             &dense[present[row] * n_samples]));
+        }
+        CHECK(sparse.GetRow(5) == -1); // No packet
+        CHECK(sparse.GetRow(2047) == -1);
+
+        std::vector<uint16_t> pixels(present.size());
+        std::vector<float> samples(present.size() * n_samples);
+        event_camera.FillSparseArrays(pixels.data(), samples.data());
+        CHECK(pixels == sparse.pixels);
+        CHECK(samples == sparse.samples);
+
+        // Without zero suppression, every waveform of the packet is present
+        CHECK(event_r0.GetNPixelsPresent() == packet->GetNWaveforms());
+        SparseWaveformSamples<uint16_t> sparse_r0 = event_r0.GetSparseWaveformSamples();
+        std::vector<uint16_t> dense_r0 = event_r0.GetWaveformSamplesVector();
+        size_t n_mismatch = 0;
+        for (size_t row = 0; row < sparse_r0.pixels.size(); row++) {
+            for (size_t isam = 0; isam < n_samples; isam++) {
+                if (sparse_r0.samples[row * n_samples + isam] !=
+                    dense_r0[sparse_r0.pixels[row] * n_samples + isam]) n_mismatch++;
+            }
+        }
+        CHECK(n_mismatch == 0);
+    }
+
     SUBCASE("WaveformEventR1 Waveform Samples") {
         std::vector<float> waveforms = event_r1.GetWaveformSamplesVector();
         bool none_zero = true;
@@ -0,0 +1,134 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_DESCRIPTIONS_EVENTBUILDER_H
+#define SSTCAM_DESCRIPTIONS_EVENTBUILDER_H
+
+#include "sstcam/descriptions/WaveformDataPacket.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+/*!
+ * @brief Packet and event counters of an EventBuilder.
+ */
+struct EventBuilderStats {
+    uint64_t n_packets = 0; // Packets passed to AddPacket
+    uint64_t n_stale_packets = 0; // Packets with the stale bit set (still built)
+    uint64_t n_duplicate_packets = 0; // Packets already received for their event (dropped)
+    uint64_t n_late_packets = 0; // Packets received after their event was emitted (dropped)
+    uint64_t n_invalid_packets = 0; // Packets outside of the event geometry (dropped)
+    uint64_t n_dropped_packets = 0; // Packets dropped as every event in the ring was in use
+    uint64_t n_missing_packets = 0; // Packets absent from the emitted incomplete events
+    uint64_t n_complete_events = 0;
+    uint64_t n_incomplete_events = 0; // Events emitted by timeout or flush
+};
+
+/*!
+ * @class EventBuilder
+ * @brief Builds events from the WaveformDataPackets received by any number
+ * of receiver threads, in any order. Packets are grouped by TACK into a ring
+ * of preallocated events. An event is emitted to the consumer queue once all
+ * of its packets are received, or once it times out. Events are therefore
+ * not necessarily emitted in TACK order.
+ *
+ * AddPacket does not take any locks: the ring slot of an event is claimed
+ * with a CAS on the slot state, and packets are stored into the event with
+ * atomic counters. A packet is only ever copied as a shared_ptr, so the
+ * packets are best acquired from a WaveformDataPacketPool, which they are
+ * returned to when the event is released.
+ *
+ * The consumer calls PopEvent to obtain the next emitted event, and must
+ * return it to the ring with ReleaseEvent once it has been processed.
+ */
+template <typename TEvent>
+class EventBuilder {
+public:
+    /*!
+     * @param n_packets_per_event
+     * Number of packets contained in an event.
+     * @param n_pixels
+     * Number of pixels in the events (see GetHardcodedModuleSituation).
+     * @param first_active_module_slot
+     * Module slot of the first active module (see GetHardcodedModuleSituation).
+     * @param n_events_in_ring
+     * Number of events preallocated in the ring (rounded up to a power of
+     * two). Limits the number of events that can be building or waiting for
+     * the consumer at once. Packets of new events are dropped when it is
+     * exhausted.
+     * @param timeout
+     * Time after the first packet of an event is received at which the event
+     * is emitted, even if it is missing packets.
+     * @param scale
+     * R1 compression scale of the events.
+     * @param offset
+     * R1 compression offset of the events.
+     */
+    EventBuilder(size_t n_packets_per_event, size_t n_pixels,
+        uint8_t first_active_module_slot, size_t n_events_in_ring=64,
+        std::chrono::nanoseconds timeout=std::chrono::milliseconds(100),
+        float scale=1., float offset=0.);
+
+    ~EventBuilder();
+    EventBuilder(const EventBuilder&) = delete;
+    EventBuilder& operator=(const EventBuilder&) = delete;
+
+    // Add a received packet to its event. Thread-safe and lock-free. The
+    // thread that adds the last packet of an event emits it.
+    void AddPacket(const std::shared_ptr<WaveformDataPacket>& packet);
+
+    // Obtain the next emitted event, or nullptr if there are none. Events
+    // that have timed out are emitted first.
+    TEvent* PopEvent();
+
+    // Return an event obtained from PopEvent to the ring, releasing its
+    // packets. The event must not be used afterwards.
+    void ReleaseEvent(TEvent* event);
+
+    // Emit the events that have timed out, returning the number emitted.
+    size_t CloseTimedOutEvents();
+
+    // Emit all events that are still building (e.g. at the end of a run),
+    // returning the number emitted.
+    size_t CloseAllEvents();
+
+    // Snapshot of the packet and event counters.
+    [[nodiscard]] EventBuilderStats GetStats() const;
+
+    // Number of events in the ring.
+    [[nodiscard]] size_t GetNEventsInRing() const { return slots_.size(); }
+
+    struct Slot;
+    class ReadyQueue;
+    struct Counters;
+
+private:
+    size_t n_packets_per_event_;
+    size_t n_pixels_;
+    uint8_t first_active_module_slot_;
+    std::chrono::nanoseconds timeout_;
+    size_t mask_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::unique_ptr<ReadyQueue> ready_;
+    std::unique_ptr<Counters> counters_;
+    alignas(64) std::atomic<uint64_t> cursor_; // Position of the next event
+
+    Slot* FindOrClaimSlot(uint64_t tack);
+    bool CloseSlot(Slot& slot, uint64_t state);
+    size_t CloseSlots(bool timed_out_only);
+};
+
+using EventBuilderR0 = EventBuilder<WaveformEventR0>;
+using EventBuilderR1 = EventBuilder<WaveformEventR1>;
+
+extern template class EventBuilder<WaveformEventR0>;
+extern template class EventBuilder<WaveformEventR1>;
+
+}
+
+#endif //SSTCAM_DESCRIPTIONS_EVENTBUILDER_H
@@ -0,0 +1,113 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_DESCRIPTIONS_SAMPLEUNPACKING_H
+#define SSTCAM_DESCRIPTIONS_SAMPLEUNPACKING_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sstcam::descriptions {
+
+/*!
+ * @brief Instruction sets of the kernels used to unpack the waveform samples
+ * of a WaveformDataPacket. The best kernel supported by the CPU is chosen at
+ * runtime, falling back to the scalar kernel on other architectures.
+ */
+enum class SampleUnpackingKernel {
+    SCALAR,
+    SSE4,
+    AVX2,
+    AVX512
+};
+
+/*!
+ * @brief Signature of a kernel that unpacks the samples of a waveform into an
+ * array of T. The scale and offset are only used by the R1 kernels.
+ */
+template <typename T>
+using UnpackSamplesFunction = void (*)(const uint8_t* data, T* samples,
+    size_t n_samples, float scale, float offset);
+
+// Kernel used by UnpackSamplesR0 and UnpackSamplesR1 on this CPU.
+SampleUnpackingKernel GetSampleUnpackingKernel();
+
+// Can the kernel be used on this CPU?
+bool IsSampleUnpackingKernelSupported(SampleUnpackingKernel kernel);
+
+/*!
+ * @brief Obtain the kernel that unpacks R0 waveforms of n_samples. Kernels
+ * specialized at compile time are returned for the common waveform lengths
+ * (64, 96 and 128 samples), otherwise the generic kernel is returned. The
+ * kernel should be obtained once for a run or event, and then called for
+ * every waveform of n_samples.
+ * @param kernel
+ * Instruction set of the kernel. Must be supported by the CPU.
+ * @param n_samples
+ * Number of samples in the waveforms.
+ */
+UnpackSamplesFunction<uint16_t> GetUnpackSamplesR0Function(
+    SampleUnpackingKernel kernel, size_t n_samples);
+
+// Obtain the kernel that unpacks R1 waveforms of n_samples (see
+// GetUnpackSamplesR0Function).
+UnpackSamplesFunction<float> GetUnpackSamplesR1Function(
+    SampleUnpackingKernel kernel, size_t n_samples);
+
+// Obtain the best kernel for this CPU that unpacks R0 waveforms of n_samples.
+UnpackSamplesFunction<uint16_t> GetUnpackSamplesR0Function(size_t n_samples);
+
+// Obtain the best kernel for this CPU that unpacks R1 waveforms of n_samples.
+UnpackSamplesFunction<float> GetUnpackSamplesR1Function(size_t n_samples);
+
+/*!
+ * @brief Unpack the 12bit R0 samples of a waveform, stored as big-endian
+ * 16bit words.
+ * @param kernel
+ * Kernel to use. Must be supported by the CPU.
+ * @param data
+ * Start of the waveform samples (i.e. after the waveform header).
+ * @param samples
+ * Array to fill with n_samples samples.
+ * @param n_samples
+ * Number of samples in the waveform.
+ */
+void UnpackSamplesR0(SampleUnpackingKernel kernel, const uint8_t* data,
+    uint16_t* samples, size_t n_samples);
+
+/*!
+ * @brief Unpack the 16bit R1 samples of a waveform, stored as big-endian
+ * 16bit words, and convert them back to floating point.
+ * @param kernel
+ * Kernel to use. Must be supported by the CPU.
+ * @param data
+ * Start of the waveform samples (i.e. after the waveform header).
+ * @param samples
+ * Array to fill with n_samples samples.
+ * @param n_samples
+ * Number of samples in the waveform.
+ * @param scale
+ * The scaling that was used to convert the original floating point R1 sample
+ * into uint16_t.
+ * @param offset
+ * The offset that was used to convert the original floating point R1 sample
+ * into uint16_t.
+ */
+void UnpackSamplesR1(SampleUnpackingKernel kernel, const uint8_t* data,
+    float* samples, size_t n_samples, float scale, float offset);
+
+/*!
+ * @brief Unpack the R0 samples of a waveform with the best kernel for this
+ * CPU. The last two parameters do not have any effect, they only exist to
+ * ensure a common API for the UnpackSamples methods.
+ */
+void UnpackSamplesR0(const uint8_t* data, uint16_t* samples, size_t n_samples,
+    float=1., float=0.);
+
+// Unpack the R1 samples of a waveform with the best kernel for this CPU.
+void UnpackSamplesR1(const uint8_t* data, float* samples, size_t n_samples,
+    float scale=1., float offset=0.);
+
+}
+
+#endif //SSTCAM_DESCRIPTIONS_SAMPLEUNPACKING_H
@@ -34,6 +34,12 @@ public:
         Associate(&packet, waveform_index);
     }
 
+    // Associate this Waveform with the start of a waveform (its header)
+    // within the memory of a WaveformDataPacket.
+    void Associate(uint8_t* waveform) {
+        waveform_ = waveform;
+    }
+
     // Is this Waveform associated with a WaveformDataPacket?
     [[nodiscard]] inline bool IsAssociated() const { return waveform_; }
 
@@ -77,6 +83,11 @@ public:
         return first_part | second_part;
     };
 
+    // Start of the waveform samples (big-endian 16bit words).
+    [[nodiscard]] inline const uint8_t* GetSampleData() const {
+        return &waveform_[2];
+    }
+
     // Set the value of a sample (12bit - R0 file).
     inline void SetSample12bit(uint16_t sample_index, uint16_t value) {
         waveform_[2 + 2 * sample_index] = static_cast<uint8_t>(value >> 8u) & 0xFu;
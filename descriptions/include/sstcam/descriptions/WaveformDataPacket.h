@@ -1,8 +1,6 @@
 // Copyright 2020 Cherenkov Telescope Array Observatory
 // This software is distributed under the terms of the BSD-3-Clause license.
 
-//  #define PERFORM_CRC_CHECK
-
 #ifndef SSTCAM_DESCRIPTIONS_WAVEFORMDATAPACKET_H
 #define SSTCAM_DESCRIPTIONS_WAVEFORMDATAPACKET_H
 
@@ -10,6 +8,7 @@
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 namespace sstcam::descriptions {
 
@@ -25,16 +24,25 @@ constexpr uint8_t WAVEFORM_HEADER_WORDS = 1;
 class WaveformDataPacket {
 public:
     explicit WaveformDataPacket(size_t packet_size)
-            : packet_(std::make_unique<uint8_t[]>(packet_size)),
+            : packet_owned_(std::make_unique<uint8_t[]>(packet_size)),
+              packet_(packet_owned_.get()),
+              packet_size_(packet_size) {}
+
+    // Create a view of an existing packet buffer (e.g. a slab of packets read
+    // from file, a network receive buffer, a memory mapping or shared memory).
+    // The memory is not owned by the class, and must outlive the packet.
+    WaveformDataPacket(uint8_t* packet, size_t packet_size)
+            : packet_(packet),
               packet_size_(packet_size) {}
 
     ~WaveformDataPacket() = default;
 
     // Move constructor
     WaveformDataPacket(WaveformDataPacket&& a) noexcept
-        : packet_size_(a.packet_size_)
+        : packet_owned_(std::move(a.packet_owned_)),
+          packet_(a.packet_),
+          packet_size_(a.packet_size_)
     {
-        packet_ = std::move(a.packet_);
         a.packet_ = nullptr;
     }
 
@@ -46,18 +54,31 @@ public:
             return *this;
 
         // Transfer ownership
-        packet_ = std::move(a.packet_);
+        packet_owned_ = std::move(a.packet_owned_);
+        packet_ = a.packet_;
+        packet_size_ = a.packet_size_;
         a.packet_ = nullptr;
 
         return *this;
     }
 
     // Get a reference to the packet_ pointer for filling.
-    [[nodiscard]] inline uint8_t* GetDataPacket() const { return packet_.get(); }
+    [[nodiscard]] inline uint8_t* GetDataPacket() const { return packet_; }
 
     // Size of the packet.
     [[nodiscard]] inline size_t GetPacketSize() const { return packet_size_; }
 
+    // Does the packet own its memory (false if it is a view)?
+    [[nodiscard]] inline bool OwnsMemory() const { return packet_owned_ != nullptr; }
+
+    // Point the packet to a different buffer of the same size, turning it into
+    // a view (any memory owned by the packet is released). Allows a single
+    // WaveformDataPacket to be reused while iterating over a receive buffer.
+    inline void Wrap(uint8_t* packet) {
+        packet_owned_ = nullptr;
+        packet_ = packet;
+    }
+
     // Bit-shifting to extract values from packet_______________________________
 
     // Number of waveforms contained in the data packet.
@@ -189,8 +210,16 @@ public:
     static void CalculateRowColumnBlockPhase(uint16_t cell_id,
             uint16_t& row, uint16_t& column, uint16_t& blockphase);
 
-    // Check if the packet is valid / consistent.
-    [[nodiscard]] bool IsValid() const;
+    // Calculate the CRC-16 used by the TARGET firmware (CCITT polynomial
+    // 0x1021, initial value 0xFFFF) of a block of bytes.
+    static uint16_t CalculateCRC(const uint8_t* data, size_t n_bytes);
+
+    // Does the CRC attached to this packet match the packet contents?
+    [[nodiscard]] bool IsCRCValid() const;
+
+    // Check if the packet is valid / consistent. The CRC is also verified if
+    // check_crc is true.
+    [[nodiscard]] bool IsValid(bool check_crc=false) const;
 
     // Check if the packet is empty by checking if its contents are all zero.
     [[nodiscard]] bool IsEmpty() const {
@@ -203,10 +232,31 @@ public:
     }
 
 private:
-    std::unique_ptr<uint8_t[]> packet_; // Memory owned by class
+    std::unique_ptr<uint8_t[]> packet_owned_; // Memory owned by class (if any)
+    uint8_t* packet_;
     size_t packet_size_;
 
 };
+
+/*!
+ * @brief Check the validity of packets laid out at a fixed stride in memory
+ * (e.g. a slab of event rows read from file).
+ * @param data
+ * Start of the first packet.
+ * @param n_packets
+ * Number of packets to check.
+ * @param packet_size
+ * Size (bytes) of each packet.
+ * @param stride
+ * Distance (bytes) between the starts of consecutive packets.
+ * @param check_crc
+ * Also verify the CRC of each packet.
+ * @return
+ * Validity of each packet.
+ */
+std::vector<bool> ValidatePacketSlab(uint8_t* data, size_t n_packets,
+    size_t packet_size, size_t stride, bool check_crc=true);
+
 }
 
 
@@ -0,0 +1,74 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_DESCRIPTIONS_WAVEFORMDATAPACKETPOOL_H
+#define SSTCAM_DESCRIPTIONS_WAVEFORMDATAPACKETPOOL_H
+
+#include "sstcam/descriptions/WaveformDataPacket.h"
+#include <cstddef>
+#include <memory>
+
+namespace sstcam::descriptions {
+
+/*!
+ * @class WaveformDataPacketPool
+ * @brief Hands out WaveformDataPacket buffers of a fixed size from large
+ * slabs, which are allocated on demand and optionally backed by huge pages.
+ * Acquiring a packet does not touch the heap once the pool has grown to its
+ * working size: the packet buffers live in the slab, while the
+ * WaveformDataPacket and the control block of its shared_ptr live in a slot
+ * that is allocated alongside the slab (on the heap) and reused with it.
+ * The slot is returned to the pool when the last shared_ptr to the packet
+ * is released (e.g. when the WaveformEvent it was added to with
+ * AddPacketShared is reset or destroyed). Packets may outlive the pool, and may be acquired and
+ * released from any thread.
+ */
+class WaveformDataPacketPool {
+public:
+    /*!
+     * @param packet_size
+     * Size of the packets in bytes.
+     * @param n_packets_per_slab
+     * Number of packets in each slab. A new slab is allocated whenever the
+     * pool runs out of free packets.
+     * @param huge_pages
+     * Request huge pages for the slabs, to reduce the number of page faults
+     * and TLB misses. Falls back to transparent huge pages (or normal pages)
+     * if no huge pages are reserved on the system.
+     */
+    explicit WaveformDataPacketPool(size_t packet_size,
+        size_t n_packets_per_slab=1024, bool huge_pages=false);
+
+    ~WaveformDataPacketPool() = default;
+    WaveformDataPacketPool(const WaveformDataPacketPool&) = delete;
+    WaveformDataPacketPool& operator=(const WaveformDataPacketPool&) = delete;
+
+    /*!
+     * @brief Obtain a zero-initialised packet from the pool. The packet is
+     * a view into the slab, and must not be Wrap-ed to another buffer.
+     */
+    std::shared_ptr<WaveformDataPacket> Acquire();
+
+    // Allocate slabs until at least n_packets are free, so that the page
+    // faults are taken before data taking starts.
+    void Reserve(size_t n_packets);
+
+    [[nodiscard]] size_t GetPacketSize() const;
+    [[nodiscard]] size_t GetNPacketsPerSlab() const;
+    [[nodiscard]] size_t GetNSlabs() const;
+    [[nodiscard]] size_t GetNPacketsFree() const;
+    [[nodiscard]] size_t GetNPacketsInUse() const;
+
+    // Are all slabs backed by huge pages (either reserved huge pages, or
+    // transparent huge pages that were successfully requested)?
+    [[nodiscard]] bool IsUsingHugePages() const;
+
+    class Storage;
+
+private:
+    std::shared_ptr<Storage> storage_;
+};
+
+}
+
+#endif //SSTCAM_DESCRIPTIONS_WAVEFORMDATAPACKETPOOL_H
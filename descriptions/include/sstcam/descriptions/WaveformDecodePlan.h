@@ -0,0 +1,70 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_DESCRIPTIONS_WAVEFORMDECODEPLAN_H
+#define SSTCAM_DESCRIPTIONS_WAVEFORMDECODEPLAN_H
+
+#include "sstcam/descriptions/WaveformDataPacket.h"
+#include <cstdint>
+#include <vector>
+
+namespace sstcam::descriptions {
+
+/*!
+ * @class WaveformDecodePlan
+ * @brief Precomputed location of every waveform of an event, for events that
+ * share the same packet geometry (e.g. all events of a run). Built once from
+ * the packets of one event, and then used to fill the waveform sample arrays
+ * of later events without parsing the packet and waveform headers.
+ *
+ * The geometry of the packets of later events (slot, number of waveforms and
+ * number of samples) and the pixel of each waveform are validated with
+ * Matches before the plan is used.
+ */
+class WaveformDecodePlan {
+public:
+    // Location of a waveform within the packets of an event.
+    struct Entry {
+        uint16_t packet_index; // Index of the packet within the event
+        uint16_t byte_offset; // Start of the waveform samples within the packet
+        uint16_t pixel; // Pixel of the waveform in the event's waveform array
+    };
+
+    /*!
+     * @param packets
+     * The packets of the event to build the plan from. All packets must exist,
+     * and contain waveforms of the same number of samples.
+     * @param first_active_module_slot
+     * Module slot of the first active module (see GetHardcodedModuleSituation).
+     */
+    WaveformDecodePlan(const std::vector<WaveformDataPacket*>& packets,
+        uint8_t first_active_module_slot);
+
+    // Do the packets of an event share the geometry and waveform pixels the
+    // plan was built from?
+    [[nodiscard]] bool Matches(const std::vector<WaveformDataPacket*>& packets) const;
+
+    // Location of every waveform of the event, in order of packet.
+    [[nodiscard]] inline const std::vector<Entry>& GetEntries() const {
+        return entries_;
+    }
+
+    // Number of samples in every waveform of the event.
+    [[nodiscard]] inline uint16_t GetNSamples() const { return n_samples_; }
+
+private:
+    // Header fields that define the geometry of a packet
+    struct PacketGeometry {
+        uint8_t slot;
+        uint16_t n_waveforms;
+        uint16_t n_buffers;
+    };
+
+    std::vector<PacketGeometry> packets_;
+    std::vector<Entry> entries_;
+    uint16_t n_samples_;
+};
+
+}
+
+#endif //SSTCAM_DESCRIPTIONS_WAVEFORMDECODEPLAN_H
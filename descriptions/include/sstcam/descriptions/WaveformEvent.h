@@ -6,10 +6,14 @@
 
 #include "sstcam/descriptions/WaveformDataPacket.h"
 #include "sstcam/descriptions/Waveform.h"
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include "sstcam/descriptions/WaveformDecodePlan.h"
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <set>
+#include <stdexcept>
 
 
 namespace sstcam::descriptions {
@@ -37,6 +41,34 @@ constexpr uint8_t DEFAULT_N_MODULES = 32;
 void GetHardcodedModuleSituation(std::set<uint8_t>& active_modules,
     size_t& n_pixels, uint8_t& first_active_module_slot);
 
+/*!
+ * @brief Memory layout of the waveform sample arrays filled by a
+ * WaveformEvent.
+ */
+enum class SampleLayout {
+    PIXEL_MAJOR, // [n_pixels][n_samples]
+    SAMPLE_MAJOR, // [n_samples][n_pixels]
+    MODULE_TILES // [n_modules][n_samples][N_PIXELS_PER_MODULE]
+};
+
+/*!
+ * @brief Waveform samples of only the pixels present in an event (i.e.
+ * excluding zero-suppressed waveforms and the pixels of missing packets).
+ */
+template <typename T>
+struct SparseWaveformSamples {
+    std::vector<uint16_t> pixels; // Pixel ID of each row, in ascending order
+    std::vector<T> samples; // [pixels.size()][n_samples]
+    size_t n_samples = 0;
+
+    // Row of the pixel in samples, or -1 if the pixel is absent.
+    [[nodiscard]] inline int32_t GetRow(uint16_t pixel) const {
+        auto it = std::lower_bound(pixels.begin(), pixels.end(), pixel);
+        if (it == pixels.end() || *it != pixel) return -1;
+        return static_cast<int32_t>(it - pixels.begin());
+    }
+};
+
 /*!
  * @brief Obtain an R0 sample from the waveform. The last two parameters do
  * not have any effect, they only exist to ensure a common API for the GetSample methods.
@@ -130,21 +162,26 @@ public:
     [[nodiscard]] inline uint16_t GetNPacketsAdded() const { return packet_index_; }
 
     // Add a WaveformDataPacket raw pointer to the event. The event does not
-    // have ownership of the memory in this packet.
+    // have ownership of the memory in this packet. The packet should be
+    // filled before it is added, as the event information is summarised
+    // from the packets as they are added.
     void AddPacket(WaveformDataPacket* packet);
 
     // Add a WaveformDataPacket shared pointer to the event. The event shares
     // ownership of the memory in this packet. The packets pointed to by this
-    // event are then guaranteed to remain alive during the event's lifetime.
-    // This method is normally only called when reading packets from file.
+    // event are then guaranteed to remain alive until the event is reset or
+    // destroyed. This method is normally called when reading packets from
+    // file, or with packets acquired from a WaveformDataPacketPool.
     void AddPacketShared(const std::shared_ptr<WaveformDataPacket>& packet);
 
     // Declare the event empty and ready to be filled with new packets. Does
-    // not delete the packets.
+    // not delete the packets added with AddPacket, but releases the event's
+    // share of the packets added with AddPacketShared (returning pooled
+    // packets to their pool). Clears the packet summary.
     void Reset();
 
     // Obtain the vector containing the pointers to the packets.
-    [[nodiscard]] inline std::vector<WaveformDataPacket*> GetPackets() const {
+    [[nodiscard]] inline const std::vector<WaveformDataPacket*>& GetPackets() const {
         return packets_;
     }
 
@@ -183,27 +220,75 @@ public:
     // Event index (defined by the reader or event builder).
     [[nodiscard]] inline size_t GetIndex() const { return index_; }
 
+    // Set the CPU time of the event, for events that are reused (e.g. by the
+    // EventBuilder ring).
+    inline void SetCPUTime(int64_t cpu_time_second, int64_t cpu_time_nanosecond) {
+        cpu_time_second_ = cpu_time_second;
+        cpu_time_nanosecond_ = cpu_time_nanosecond;
+    }
+
+    // Set the event index, for events that are reused.
+    inline void SetIndex(size_t index) { index_ = index; }
+
+    // Use a WaveformDecodePlan to fill the waveform sample arrays, when the
+    // packets of the event match its geometry. The plan can be shared by
+    // all events of a run.
+    inline void SetDecodePlan(std::shared_ptr<const WaveformDecodePlan> plan) {
+        decode_plan_ = std::move(plan);
+    }
+
+    // WaveformDecodePlan used to fill the waveform sample arrays (if any).
+    [[nodiscard]] inline const std::shared_ptr<const WaveformDecodePlan>&
+    GetDecodePlan() const {
+        return decode_plan_;
+    }
+
+    // Build a WaveformDecodePlan from the packets of this event.
+    [[nodiscard]] inline std::shared_ptr<const WaveformDecodePlan>
+    CreateDecodePlan() const {
+        return std::make_shared<const WaveformDecodePlan>(
+            packets_, first_active_module_slot_);
+    }
+
     // Convenience methods for event information from packets___________________
 
-    // Check if the event is fully filled, and that all packets still exist
-    // and are not empty.
-    [[nodiscard]] bool IsMissingPackets() const;
+    // Check if the event is fully filled, and that none of the packets were
+    // empty when they were added.
+    [[nodiscard]] inline bool IsMissingPackets() const {
+        return summary_.n_missing > 0;
+    }
+
+    // Which packets are missing (not added, or empty when they were added)?
+    [[nodiscard]] inline const std::vector<bool>& GetMissingPacketMask() const {
+        return summary_.missing;
+    }
+
+    // Check the validity of each packet in the event (false if the packet is
+    // missing). The CRC of each packet is also verified if check_crc is true.
+    [[nodiscard]] std::vector<bool> ValidatePackets(bool check_crc=true) const;
+
+    // Pixels with a waveform in the event, in ascending order. The pixels of
+    // zero-suppressed waveforms and of missing packets are absent.
+    [[nodiscard]] std::vector<uint16_t> GetPresentPixels() const;
+
+    // Number of pixels with a waveform in the event (see GetPresentPixels).
+    [[nodiscard]] size_t GetNPixelsPresent() const;
 
     // Assume the first_cell_id for the event from the first filled WaveformDataPacket.
     // Consequently assumes that all packets in the event share the same
     // first_cell_id (which should be true).
     [[nodiscard]] inline uint16_t GetFirstCellID() const {
-        return GetFirstPacket()->GetFirstCellID();
+        return GetFilledSummary().first_cell_id;
     }
 
     // Get the TACK timestamp from the first filled packet.
     [[nodiscard]] inline uint64_t GetTACK() const {
-        return GetFirstPacket()->GetTACK();
+        return GetFilledSummary().tack;
     }
 
     // Check if the event is stale from the first filled packet.
     [[nodiscard]] inline bool IsStale() const {
-        return GetFirstPacket()->GetStaleBit() == 1;
+        return GetFilledSummary().stale;
     }
 
 protected:
@@ -218,32 +303,201 @@ protected:
     float scale_;
     float offset_;
     size_t index_;
+    std::shared_ptr<const WaveformDecodePlan> decode_plan_;
 
     // Template to define how a waveform sample array is built by an event.
-    // The template is specialized by the R0 and R1 subclasses.
-    template<typename T, T TGetSample(Waveform&, uint16_t, float, float)>
-    inline void FillWaveformSamplesArrayTemplate(T* samples) const {
-        Waveform waveform;
+    // The template is specialized by the R0 and R1 subclasses. The samples of
+    // each waveform are unpacked in a single call to the SIMD kernel, which is
+    // obtained once for the number of samples of the event. For the layouts
+    // other than PIXEL_MAJOR, the waveforms of a packet are unpacked into a
+    // buffer, and then transposed into the array one sample row at a time.
+    template<typename T, UnpackSamplesFunction<T> TGetUnpackSamples(size_t)>
+    inline void FillWaveformSamplesArrayTemplate(T* samples, SampleLayout layout) const {
+        if (layout == SampleLayout::PIXEL_MAJOR && decode_plan_ &&
+                decode_plan_->Matches(packets_)) {
+            FillWaveformSamplesArrayPlanTemplate<T, TGetUnpackSamples>(samples);
+            return;
+        }
 
+        uint16_t n_samples = 0;
+        UnpackSamplesFunction<T> unpack_samples = nullptr;
+        std::vector<T> buffer;
+        std::vector<uint16_t> pixels;
         for (WaveformDataPacket* packet : packets_) {
             if (!packet) continue;
+            if (packet->GetWaveformNSamples() != n_samples || !unpack_samples) {
+                n_samples = packet->GetWaveformNSamples();
+                unpack_samples = TGetUnpackSamples(n_samples);
+            }
             uint16_t n_waveforms = packet->GetNWaveforms();
             uint8_t module = packet->GetSlotID() - first_active_module_slot_;
+            uint8_t* waveform_data = &packet->GetDataPacket()[packet->GetWaveformStart(0)];
+            uint16_t waveform_n_bytes = packet->GetWaveformNBytes();
+            Waveform waveform;
+
+            if (layout == SampleLayout::PIXEL_MAJOR) {
+                for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+                    waveform.Associate(waveform_data);
+                    uint16_t i_pixel = module * N_PIXELS_PER_MODULE + waveform.GetPixelID();
+                    unpack_samples(waveform.GetSampleData(), &samples[i_pixel * n_samples],
+                                   n_samples, scale_, offset_);
+                    waveform_data += waveform_n_bytes;
+                }
+                continue;
+            }
+
+            buffer.resize(static_cast<size_t>(n_waveforms) * n_samples);
+            pixels.resize(n_waveforms);
             for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
-                waveform.Associate(packet, i_waveform);
-                uint16_t n_samples = waveform.GetNSamples();
-                uint16_t i_pixel = module * N_PIXELS_PER_MODULE + waveform.GetPixelID();
-                for (unsigned short i_sample = 0; i_sample < n_samples; i_sample++) {
-                    samples[i_pixel * n_samples + i_sample] = TGetSample(
-                        waveform, i_sample, scale_, offset_);
+                waveform.Associate(waveform_data);
+                pixels[i_waveform] = waveform.GetPixelID();
+                unpack_samples(waveform.GetSampleData(), &buffer[i_waveform * n_samples],
+                               n_samples, scale_, offset_);
+                waveform_data += waveform_n_bytes;
+            }
+
+            // Start of the module's pixels, and the distance between its sample rows
+            T* tile;
+            size_t row_stride;
+            if (layout == SampleLayout::SAMPLE_MAJOR) {
+                tile = &samples[module * N_PIXELS_PER_MODULE];
+                row_stride = n_pixels_;
+            } else {
+                tile = &samples[module * N_PIXELS_PER_MODULE * n_samples];
+                row_stride = N_PIXELS_PER_MODULE;
+            }
+            for (uint16_t i_sample = 0; i_sample < n_samples; i_sample++) {
+                T* row = &tile[i_sample * row_stride];
+                const T* column = &buffer[i_sample];
+                for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+                    row[pixels[i_waveform]] = column[i_waveform * n_samples];
                 }
             }
         }
     }
 
+    // Template to define how a pixel-major waveform sample array is built
+    // from the decode plan, without reading the packet or waveform headers.
+    template<typename T, UnpackSamplesFunction<T> TGetUnpackSamples(size_t)>
+    inline void FillWaveformSamplesArrayPlanTemplate(T* samples) const {
+        uint16_t n_samples = decode_plan_->GetNSamples();
+        UnpackSamplesFunction<T> unpack_samples = TGetUnpackSamples(n_samples);
+        for (const WaveformDecodePlan::Entry& entry : decode_plan_->GetEntries()) {
+            unpack_samples(&packets_[entry.packet_index]->GetDataPacket()[entry.byte_offset],
+                           &samples[entry.pixel * n_samples], n_samples, scale_, offset_);
+        }
+    }
+
+    // Template to define how the waveform samples of a subset of the pixels
+    // are extracted into a compact [n_selected][n_samples] array. Packets of
+    // modules without a selected pixel are skipped without reading their
+    // waveforms.
+    template<typename T, UnpackSamplesFunction<T> TGetUnpackSamples(size_t)>
+    inline void FillWaveformSamplesSubsetTemplate(
+            T* samples, const std::vector<int32_t>& output_rows) const {
+        uint16_t n_samples = 0;
+        UnpackSamplesFunction<T> unpack_samples = nullptr;
+        size_t n_modules = output_rows.size() / N_PIXELS_PER_MODULE;
+        for (WaveformDataPacket* packet : packets_) {
+            if (!packet) continue;
+            uint8_t module = packet->GetSlotID() - first_active_module_slot_;
+            if (module >= n_modules) continue;
+            const int32_t* module_rows = &output_rows[module * N_PIXELS_PER_MODULE];
+            if (std::all_of(module_rows, module_rows + N_PIXELS_PER_MODULE,
+                            [](int32_t row) { return row < 0; })) continue;
+
+            if (packet->GetWaveformNSamples() != n_samples || !unpack_samples) {
+                n_samples = packet->GetWaveformNSamples();
+                unpack_samples = TGetUnpackSamples(n_samples);
+            }
+            uint16_t n_waveforms = packet->GetNWaveforms();
+            uint8_t* waveform_data = &packet->GetDataPacket()[packet->GetWaveformStart(0)];
+            uint16_t waveform_n_bytes = packet->GetWaveformNBytes();
+            Waveform waveform;
+            for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+                waveform.Associate(waveform_data);
+                waveform_data += waveform_n_bytes;
+                int32_t row = module_rows[waveform.GetPixelID()];
+                if (row < 0) continue;
+                unpack_samples(waveform.GetSampleData(), &samples[row * n_samples],
+                               n_samples, scale_, offset_);
+            }
+        }
+    }
+
+    // Template to define how the waveform samples of the pixels present in
+    // the event are extracted into a compact [n_present][n_samples] array,
+    // alongside the pixel ID of each row.
+    template<typename T, UnpackSamplesFunction<T> TGetUnpackSamples(size_t)>
+    inline void FillSparseSamplesTemplate(const std::vector<const uint8_t*>& waveforms,
+            uint16_t* pixels, T* samples) const {
+        uint16_t n_samples = GetNSamples();
+        UnpackSamplesFunction<T> unpack_samples = TGetUnpackSamples(n_samples);
+        size_t row = 0;
+        for (size_t i_pixel = 0; i_pixel < waveforms.size(); i_pixel++) {
+            if (!waveforms[i_pixel]) continue;
+            pixels[row] = static_cast<uint16_t>(i_pixel);
+            unpack_samples(waveforms[i_pixel], &samples[row * n_samples],
+                           n_samples, scale_, offset_);
+            row++;
+        }
+    }
+
+    // Template to define how the SparseWaveformSamples of an event are built.
+    template<typename T, UnpackSamplesFunction<T> TGetUnpackSamples(size_t)>
+    [[nodiscard]] inline SparseWaveformSamples<T> GetSparseWaveformSamplesTemplate() const {
+        std::vector<const uint8_t*> waveforms = GetPresentWaveforms();
+        size_t n_present = waveforms.size() - std::count(
+            waveforms.begin(), waveforms.end(), nullptr);
+        SparseWaveformSamples<T> sparse;
+        sparse.n_samples = GetNSamples();
+        sparse.pixels.resize(n_present);
+        sparse.samples.resize(n_present * sparse.n_samples);
+        FillSparseSamplesTemplate<T, TGetUnpackSamples>(
+            waveforms, sparse.pixels.data(), sparse.samples.data());
+        return sparse;
+    }
+
+    // Start of the samples of the waveform of each pixel present in the event
+    // (nullptr if absent), indexed by pixel.
+    [[nodiscard]] std::vector<const uint8_t*> GetPresentWaveforms() const;
+
+    // Output row of each pixel of the event (-1 if not selected) when
+    // extracting the pixels in order. Each pixel can only be selected once.
+    [[nodiscard]] std::vector<int32_t> GetPixelSubsetRows(
+        const std::vector<uint16_t>& pixels) const;
+
+    // Output row of each pixel of the event (-1 if not selected) when
+    // extracting all pixels of the modules, in order of module slot.
+    [[nodiscard]] std::vector<int32_t> GetModuleSubsetRows(
+        const std::set<uint8_t>& module_slots) const;
+
 private:
+    // Summary of the packets, updated as each packet is added, so that the
+    // event information is obtained without searching the packets.
+    struct PacketSummary {
+        WaveformDataPacket* first_packet = nullptr; // First non-empty packet
+        std::vector<bool> missing; // Packets not added, or added empty
+        size_t n_missing = 0;
+        uint64_t tack = 0;
+        uint16_t first_cell_id = 0;
+        bool stale = false;
+    };
+    PacketSummary summary_;
+
+    // Update the summary with the packet added at packet_index.
+    void SummarisePacket(size_t packet_index);
+
+    // Get the packet summary, checking that a non-empty packet was added.
+    [[nodiscard]] inline const PacketSummary& GetFilledSummary() const {
+        if (!summary_.first_packet) throw std::runtime_error("WaveformEvent is empty");
+        return summary_;
+    }
+
     // Get the first packet that is not empty.
-    [[nodiscard]] WaveformDataPacket* GetFirstPacket() const;
+    [[nodiscard]] inline WaveformDataPacket* GetFirstPacket() const {
+        return GetFilledSummary().first_packet;
+    }
 };
 
 /*!
@@ -255,19 +509,70 @@ class WaveformEventR0 : public WaveformEvent{
 public:
     using WaveformEvent::WaveformEvent;
 
-    // Fill a supplied array with the waveform samples.
-    // No range checks are included.
-    inline void FillWaveformSamplesArray(uint16_t* samples) const {
-        FillWaveformSamplesArrayTemplate<uint16_t, GetSampleR0>(samples);
+    // Fill a supplied array with the waveform samples, in the requested
+    // layout. No range checks are included.
+    inline void FillWaveformSamplesArray(uint16_t* samples,
+            SampleLayout layout=SampleLayout::PIXEL_MAJOR) const {
+        FillWaveformSamplesArrayTemplate<uint16_t, GetUnpackSamplesR0Function>(samples, layout);
     }
 
     // Get the waveforms of the event as a contiguous 1D vector
-    [[nodiscard]] inline std::vector<uint16_t> GetWaveformSamplesVector() const {
+    [[nodiscard]] inline std::vector<uint16_t> GetWaveformSamplesVector(
+            SampleLayout layout=SampleLayout::PIXEL_MAJOR) const {
         size_t size = n_pixels_ * GetNSamples();
         std::vector<uint16_t > samples(size, 0);
-        FillWaveformSamplesArray(samples.data());
+        FillWaveformSamplesArray(samples.data(), layout);
+        return samples;
+    }
+
+    // Fill a supplied [n_pixels_selected][n_samples] array with the waveform
+    // samples of the selected pixels, in the order they are given. Only the
+    // waveforms of the selected pixels are decoded. Each pixel can only be
+    // selected once.
+    inline void FillPixelSubsetArray(uint16_t* samples,
+            const std::vector<uint16_t>& pixels) const {
+        FillWaveformSamplesSubsetTemplate<uint16_t, GetUnpackSamplesR0Function>(
+            samples, GetPixelSubsetRows(pixels));
+    }
+
+    // Fill a supplied [n_modules_selected * N_PIXELS_PER_MODULE][n_samples]
+    // array with the waveform samples of the selected module slots, in order
+    // of slot. Packets from other modules are skipped.
+    inline void FillModuleSubsetArray(uint16_t* samples,
+            const std::set<uint8_t>& module_slots) const {
+        FillWaveformSamplesSubsetTemplate<uint16_t, GetUnpackSamplesR0Function>(
+            samples, GetModuleSubsetRows(module_slots));
+    }
+
+    // Get the waveforms of the selected pixels as a contiguous 1D vector.
+    [[nodiscard]] inline std::vector<uint16_t> GetPixelSubsetVector(
+            const std::vector<uint16_t>& pixels) const {
+        std::vector<uint16_t> samples(pixels.size() * GetNSamples(), 0);
+        FillPixelSubsetArray(samples.data(), pixels);
+        return samples;
+    }
+
+    // Get the waveforms of the selected module slots as a contiguous 1D vector.
+    [[nodiscard]] inline std::vector<uint16_t> GetModuleSubsetVector(
+            const std::set<uint8_t>& module_slots) const {
+        size_t size = module_slots.size() * N_PIXELS_PER_MODULE * GetNSamples();
+        std::vector<uint16_t> samples(size, 0);
+        FillModuleSubsetArray(samples.data(), module_slots);
         return samples;
     }
+
+    // Fill a supplied [n_pixels_present] array with the ID of the pixels
+    // present in the event, and a [n_pixels_present][n_samples] array with
+    // their waveform samples (see GetNPixelsPresent). Zero-suppressed
+    // waveforms are not decoded. No range checks are included.
+    inline void FillSparseArrays(uint16_t* pixels, uint16_t* samples) const {
+        FillSparseSamplesTemplate<uint16_t, GetUnpackSamplesR0Function>(GetPresentWaveforms(), pixels, samples);
+    }
+
+    // Get the waveforms of the pixels present in the event.
+    [[nodiscard]] inline SparseWaveformSamples<uint16_t> GetSparseWaveformSamples() const {
+        return GetSparseWaveformSamplesTemplate<uint16_t, GetUnpackSamplesR0Function>();
+    }
 };
 
 /*!
@@ -278,19 +583,70 @@ class WaveformEventR1 : public WaveformEvent {
 public:
     using WaveformEvent::WaveformEvent;
 
-    // Fill a supplied array with the waveform samples.
-    // No range checks are included.
-    inline void FillWaveformSamplesArray(float* samples) const {
-        FillWaveformSamplesArrayTemplate<float, GetSampleR1>(samples);
+    // Fill a supplied array with the waveform samples, in the requested
+    // layout. No range checks are included.
+    inline void FillWaveformSamplesArray(float* samples,
+            SampleLayout layout=SampleLayout::PIXEL_MAJOR) const {
+        FillWaveformSamplesArrayTemplate<float, GetUnpackSamplesR1Function>(samples, layout);
     }
 
     // Get the waveforms of the event as a contiguous 1D vector.
-    [[nodiscard]] inline std::vector<float> GetWaveformSamplesVector() const {
+    [[nodiscard]] inline std::vector<float> GetWaveformSamplesVector(
+            SampleLayout layout=SampleLayout::PIXEL_MAJOR) const {
         size_t size = n_pixels_ * GetNSamples();
         std::vector<float> samples(size, 0);
-        FillWaveformSamplesArray(samples.data());
+        FillWaveformSamplesArray(samples.data(), layout);
         return samples;
     }
+
+    // Fill a supplied [n_pixels_selected][n_samples] array with the waveform
+    // samples of the selected pixels, in the order they are given. Only the
+    // waveforms of the selected pixels are decoded. Each pixel can only be
+    // selected once.
+    inline void FillPixelSubsetArray(float* samples,
+            const std::vector<uint16_t>& pixels) const {
+        FillWaveformSamplesSubsetTemplate<float, GetUnpackSamplesR1Function>(
+            samples, GetPixelSubsetRows(pixels));
+    }
+
+    // Fill a supplied [n_modules_selected * N_PIXELS_PER_MODULE][n_samples]
+    // array with the waveform samples of the selected module slots, in order
+    // of slot. Packets from other modules are skipped.
+    inline void FillModuleSubsetArray(float* samples,
+            const std::set<uint8_t>& module_slots) const {
+        FillWaveformSamplesSubsetTemplate<float, GetUnpackSamplesR1Function>(
+            samples, GetModuleSubsetRows(module_slots));
+    }
+
+    // Get the waveforms of the selected pixels as a contiguous 1D vector.
+    [[nodiscard]] inline std::vector<float> GetPixelSubsetVector(
+            const std::vector<uint16_t>& pixels) const {
+        std::vector<float> samples(pixels.size() * GetNSamples(), 0);
+        FillPixelSubsetArray(samples.data(), pixels);
+        return samples;
+    }
+
+    // Get the waveforms of the selected module slots as a contiguous 1D vector.
+    [[nodiscard]] inline std::vector<float> GetModuleSubsetVector(
+            const std::set<uint8_t>& module_slots) const {
+        size_t size = module_slots.size() * N_PIXELS_PER_MODULE * GetNSamples();
+        std::vector<float> samples(size, 0);
+        FillModuleSubsetArray(samples.data(), module_slots);
+        return samples;
+    }
+
+    // Fill a supplied [n_pixels_present] array with the ID of the pixels
+    // present in the event, and a [n_pixels_present][n_samples] array with
+    // their waveform samples (see GetNPixelsPresent). Zero-suppressed
+    // waveforms are not decoded. No range checks are included.
+    inline void FillSparseArrays(uint16_t* pixels, float* samples) const {
+        FillSparseSamplesTemplate<float, GetUnpackSamplesR1Function>(GetPresentWaveforms(), pixels, samples);
+    }
+
+    // Get the waveforms of the pixels present in the event.
+    [[nodiscard]] inline SparseWaveformSamples<float> GetSparseWaveformSamples() const {
+        return GetSparseWaveformSamplesTemplate<float, GetUnpackSamplesR1Function>();
+    }
 };
 
 }
@@ -19,6 +19,13 @@ void waveform_data_packet(py::module &m) {
     py::class_<WaveformDataPacket, std::shared_ptr<WaveformDataPacket>> datapacket(
         m, "WaveformDataPacket");
     datapacket.def(py::init<size_t>());
+    datapacket.def(py::init([](py::array_t<uint8_t, py::array::c_style> buffer) {
+        // View of the buffer's memory (no copy), which is kept alive by the packet
+        return std::make_shared<WaveformDataPacket>(
+            buffer.mutable_data(), static_cast<size_t>(buffer.size()));
+    }), py::arg("buffer").noconvert(), py::keep_alive<1, 2>());
+    datapacket.def("OwnsMemory",
+        &WaveformDataPacket::OwnsMemory);
     datapacket.def("GetDataPacket",
         &GetDataPacket, py::return_value_policy::reference_internal);
     datapacket.def("GetPacketSize",
@@ -83,8 +90,10 @@ void waveform_data_packet(py::module &m) {
         &WaveformDataPacket::CalculateCellID);
     datapacket.def("CalculateRowColumnBlockPhase",
         &WaveformDataPacket::CalculateRowColumnBlockPhase);
+    datapacket.def("IsCRCValid",
+        &WaveformDataPacket::IsCRCValid);
     datapacket.def("IsValid",
-        &WaveformDataPacket::IsValid);
+        &WaveformDataPacket::IsValid, py::arg("check_crc")=false);
 }
 
 }
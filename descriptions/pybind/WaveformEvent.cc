@@ -21,17 +21,72 @@ void get_hardcoded_module_situation(py::module &m) {
 }
 
 template<typename T, typename TEvent>
-py::array_t<T> GetWaveformSamplesArray(const TEvent& waveform_event) {
+py::array_t<T> GetWaveformSamplesArray(const TEvent& waveform_event,
+        SampleLayout layout) {
     auto n_pixels = static_cast<long>(waveform_event.GetNPixels());
     auto n_samples = static_cast<long>(waveform_event.GetNSamples());
-    auto shape = std::vector<ptrdiff_t>{n_pixels, n_samples};
+    std::vector<ptrdiff_t> shape;
+    switch (layout) {
+        case SampleLayout::PIXEL_MAJOR:
+            shape = {n_pixels, n_samples};
+            break;
+        case SampleLayout::SAMPLE_MAJOR:
+            shape = {n_samples, n_pixels};
+            break;
+        case SampleLayout::MODULE_TILES:
+            shape = {n_pixels / N_PIXELS_PER_MODULE, n_samples, N_PIXELS_PER_MODULE};
+            break;
+    }
     auto array = py::array_t<T>(shape);
-    auto buf = array.request();
-    auto* ptr = (T*) buf.ptr;
-    waveform_event.FillWaveformSamplesArray(ptr);
+    std::fill_n(array.mutable_data(), array.size(), 0); // Missing modules are zeros
+    waveform_event.FillWaveformSamplesArray(array.mutable_data(), layout);
     return array;
 }
 
+template<typename T, typename TEvent>
+py::array_t<T> GetPixelSubsetArray(const TEvent& waveform_event,
+        const std::vector<uint16_t>& pixels) {
+    auto n_samples = static_cast<long>(waveform_event.GetNSamples());
+    auto shape = std::vector<ptrdiff_t>{static_cast<long>(pixels.size()), n_samples};
+    auto array = py::array_t<T>(shape);
+    std::fill_n(array.mutable_data(), array.size(), 0);
+    waveform_event.FillPixelSubsetArray(array.mutable_data(), pixels);
+    return array;
+}
+
+template<typename T, typename TEvent>
+py::array_t<T> GetModuleSubsetArray(const TEvent& waveform_event,
+        const std::set<uint8_t>& module_slots) {
+    auto n_samples = static_cast<long>(waveform_event.GetNSamples());
+    auto n_modules = static_cast<long>(module_slots.size());
+    auto shape = std::vector<ptrdiff_t>{n_modules, N_PIXELS_PER_MODULE, n_samples};
+    auto array = py::array_t<T>(shape);
+    std::fill_n(array.mutable_data(), array.size(), 0);
+    waveform_event.FillModuleSubsetArray(array.mutable_data(), module_slots);
+    return array;
+}
+
+template<typename T, typename TEvent>
+std::tuple<py::array_t<uint16_t>, py::array_t<T>> GetSparseArrays(
+        const TEvent& waveform_event) {
+    // Single pass over the packets (the arrays copy the vectors)
+    auto sparse = waveform_event.GetSparseWaveformSamples();
+    auto n_present = static_cast<long>(sparse.pixels.size());
+    auto n_samples = static_cast<long>(sparse.n_samples);
+    auto pixels = py::array_t<uint16_t>(
+        std::vector<ptrdiff_t>{n_present}, sparse.pixels.data());
+    auto samples = py::array_t<T>(
+        std::vector<ptrdiff_t>{n_present, n_samples}, sparse.samples.data());
+    return std::make_tuple(pixels, samples);
+}
+
+void sample_layout(py::module &m) {
+    py::enum_<SampleLayout>(m, "SampleLayout")
+        .value("PIXEL_MAJOR", SampleLayout::PIXEL_MAJOR)
+        .value("SAMPLE_MAJOR", SampleLayout::SAMPLE_MAJOR)
+        .value("MODULE_TILES", SampleLayout::MODULE_TILES);
+}
+
 void waveform_event(py::module &m) {
     py::class_<WaveformEvent> waveform_event(m, "WaveformEvent");
     waveform_event.def(
@@ -62,6 +117,12 @@ void waveform_event(py::module &m) {
         &WaveformEvent::GetIndex);
     waveform_event.def_property_readonly("missing_packets",
         &WaveformEvent::IsMissingPackets);
+    waveform_event.def("validate_packets",
+        &WaveformEvent::ValidatePackets, py::arg("check_crc")=true);
+    waveform_event.def_property_readonly("present_pixels",
+        &WaveformEvent::GetPresentPixels);
+    waveform_event.def_property_readonly("n_pixels_present",
+        &WaveformEvent::GetNPixelsPresent);
     waveform_event.def_property_readonly("first_cell_id",
         &WaveformEvent::GetFirstCellID);
     waveform_event.def_property_readonly("tack",
@@ -81,7 +142,14 @@ void waveform_event_r0(py::module &m) {
     waveform_event.def(
         py::init<size_t, size_t, uint8_t, int64_t, int64_t, float, float>());
     waveform_event.def("get_array",
-        &GetWaveformSamplesArray<uint16_t, WaveformEventR0>);
+        &GetWaveformSamplesArray<uint16_t, WaveformEventR0>,
+        py::arg("layout")=SampleLayout::PIXEL_MAJOR);
+    waveform_event.def("get_pixel_subset_array",
+        &GetPixelSubsetArray<uint16_t, WaveformEventR0>);
+    waveform_event.def("get_module_subset_array",
+        &GetModuleSubsetArray<uint16_t, WaveformEventR0>);
+    waveform_event.def("get_sparse_arrays",
+        &GetSparseArrays<uint16_t, WaveformEventR0>);
 }
 
 void waveform_event_r1(py::module &m) {
@@ -95,7 +163,14 @@ void waveform_event_r1(py::module &m) {
     waveform_event.def(
         py::init<size_t, size_t, uint8_t, int64_t, int64_t, float, float>());
     waveform_event.def("get_array",
-        &GetWaveformSamplesArray<float , WaveformEventR1>);
+        &GetWaveformSamplesArray<float , WaveformEventR1>,
+        py::arg("layout")=SampleLayout::PIXEL_MAJOR);
+    waveform_event.def("get_pixel_subset_array",
+        &GetPixelSubsetArray<float, WaveformEventR1>);
+    waveform_event.def("get_module_subset_array",
+        &GetModuleSubsetArray<float, WaveformEventR1>);
+    waveform_event.def("get_sparse_arrays",
+        &GetSparseArrays<float, WaveformEventR1>);
 }
 
 }
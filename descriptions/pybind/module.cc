@@ -10,6 +10,7 @@ namespace py = pybind11;
 
 void waveform_data_packet(py::module &m);
 void waveform(py::module &m);
+void sample_layout(py::module &m);
 void waveform_event(py::module &m);
 void waveform_event_r0(py::module &m);
 void waveform_event_r1(py::module &m);
@@ -19,6 +20,7 @@ PYBIND11_MODULE(sstcam_descriptions, m) {
     m.def("_get_version",&getSSTCamCommonGitVersion);
     waveform_data_packet(m);
     waveform(m);
+    sample_layout(m);
     waveform_event(m);
     waveform_event_r0(m);
     waveform_event_r1(m);
@@ -21,6 +21,23 @@ def test_constructor(packet):
     np.testing.assert_equal(packet, data_packet.GetDataPacket())
 
 
+def test_view(packet):
+    buffer = packet.copy()
+    data_packet = WaveformDataPacket(buffer)
+    assert not data_packet.OwnsMemory()
+    assert data_packet.GetPacketSize() == packet.size
+    assert data_packet.GetTACK() == 2165717354592
+
+    buffer[4] = 3
+    assert data_packet.GetSlotID() == 3
+    assert data_packet.GetDataPacket()[4] == 3
+
+    del buffer
+    assert data_packet.GetSlotID() == 3
+
+    assert WaveformDataPacket(packet.size).OwnsMemory()
+
+
 def test_getters(packet):
     data_packet = WaveformDataPacket(packet.size)
     data_packet.GetDataPacket()[:] = packet
@@ -1,7 +1,8 @@
 import pytest
 import numpy as np
 from os.path import join, dirname, abspath
-from sstcam.descriptions import WaveformEventR0, WaveformEventR1, WaveformDataPacket
+from sstcam.descriptions import WaveformEventR0, WaveformEventR1, WaveformDataPacket, \
+    SampleLayout
 
 
 @pytest.fixture(scope="module")
@@ -75,6 +76,64 @@ def test_scale_offset(packet_array):
     np.testing.assert_equal((waveforms_1[:32] / scale) - offset, waveforms_2[:32])
 
 
+def test_sample_layout(packet_array):
+    packet = WaveformDataPacket(8276)
+    packet.GetDataPacket()[:] = packet_array
+    event = WaveformEventR1(1, 2048, 0)
+    event.add_packet_shared(packet)
+
+    pixel_major = event.get_array()
+    sample_major = event.get_array(SampleLayout.SAMPLE_MAJOR)
+    module_tiles = event.get_array(SampleLayout.MODULE_TILES)
+    assert sample_major.shape == (pixel_major.shape[1], 2048)
+    assert module_tiles.shape == (32, pixel_major.shape[1], 64)
+    slot = packet.GetSlotID()
+    assert (pixel_major[:slot * 64] == 0).all()  # Missing modules
+    np.testing.assert_equal(sample_major, pixel_major.T)
+    np.testing.assert_equal(
+        module_tiles, pixel_major.reshape(32, 64, -1).transpose(0, 2, 1)
+    )
+
+
+def test_subsets(packet_array):
+    packet = WaveformDataPacket(8276)
+    packet.GetDataPacket()[:] = packet_array
+    event = WaveformEventR0(1, 2048, 0)
+    event.add_packet_shared(packet)
+    slot = packet.GetSlotID()
+
+    waveforms = event.get_array()
+    pixels = [slot * 64 + 3, 5, slot * 64]
+    subset = event.get_pixel_subset_array(pixels)
+    np.testing.assert_equal(subset, waveforms[pixels])
+    assert (subset[0] > 0).all()
+    assert (subset[1] == 0).all()  # Pixel without a packet
+    module_subset = event.get_module_subset_array({slot})
+    assert module_subset.shape == (1, 64, waveforms.shape[1])
+    np.testing.assert_equal(module_subset[0], waveforms[slot * 64:(slot + 1) * 64])
+    with pytest.raises(IndexError):
+        event.get_pixel_subset_array([2048])
+    with pytest.raises(ValueError):
+        event.get_pixel_subset_array([slot * 64 + 3, 5, slot * 64 + 3])
+
+
+def test_sparse(packet_array):
+    packet = WaveformDataPacket(8276)
+    packet.GetDataPacket()[:] = packet_array
+    n_waveforms = packet.GetNWaveforms()
+    for iwav in range(0, n_waveforms, 2):  # Zero-suppress every other waveform
+        packet.GetDataPacket()[packet.GetWaveformStart(iwav) + 1] |= 0x80
+    event = WaveformEventR1(1, 2048, 0)
+    event.add_packet_shared(packet)
+
+    pixels, samples = event.get_sparse_arrays()
+    assert event.n_pixels_present == n_waveforms // 2
+    np.testing.assert_equal(pixels, event.present_pixels)
+    assert np.all(np.diff(pixels) > 0)
+    assert samples.shape == (n_waveforms // 2, event.n_samples)
+    np.testing.assert_equal(samples, event.get_array()[pixels])
+
+
 def test_get_event_metadata(packet_array):
     n_packets_per_event = 1
     packet_size = 8276
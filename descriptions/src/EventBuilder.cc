@@ -0,0 +1,436 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/descriptions/EventBuilder.h"
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace sstcam::descriptions {
+
+namespace {
+
+// The state of a ring slot packs the position of its (latest) event in the
+// sequence of events together with its phase, so that a CAS on the state
+// cannot succeed on a slot that has since been reused for another event
+enum Phase : uint64_t {
+    FREE = 0,     // Not in use. The tack of the last event is retained
+    CLAIMING = 1, // Being claimed for a new event by a receiver thread
+    BUILDING = 2, // Receiving packets
+    CLOSING = 3,  // Waiting for the receiver threads to finish, then emitted
+    READY = 4     // Emitted to the consumer
+};
+
+constexpr uint64_t PHASE_BITS = 3;
+constexpr uint64_t NEVER_USED = UINT64_MAX >> PHASE_BITS;
+
+constexpr uint64_t MakeState(uint64_t sequence, Phase phase) {
+    return (sequence << PHASE_BITS) | phase;
+}
+
+constexpr Phase GetPhase(uint64_t state) {
+    return static_cast<Phase>(state & ((1u << PHASE_BITS) - 1));
+}
+
+constexpr uint64_t GetSequence(uint64_t state) {
+    return state >> PHASE_BITS;
+}
+
+size_t RoundUpPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) power <<= 1u;
+    return power;
+}
+
+int64_t SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+template <typename TEvent>
+struct alignas(64) EventBuilder<TEvent>::Slot {
+    std::atomic<uint64_t> state;
+    std::atomic<uint64_t> tack;
+    std::atomic<uint32_t> n_writers; // Receiver threads storing a packet
+    std::atomic<uint32_t> n_claimed; // Packet positions handed out
+    std::atomic<uint32_t> n_stored;  // Packets stored
+    std::atomic<int64_t> first_arrival; // Steady clock (ns)
+    std::vector<std::atomic<uint64_t>> received; // Bit per packet (pixel of its first waveform)
+    std::vector<std::shared_ptr<WaveformDataPacket>> packets;
+    int64_t cpu_time_second;
+    int64_t cpu_time_nanosecond;
+    TEvent event;
+
+    Slot(size_t n_packets_per_event, size_t n_pixels,
+         uint8_t first_active_module_slot, float scale, float offset)
+        : state(MakeState(NEVER_USED, FREE)),
+          tack(0),
+          n_writers(0),
+          n_claimed(0),
+          n_stored(0),
+          first_arrival(0),
+          received((n_pixels + 63) / 64),
+          packets(n_packets_per_event),
+          cpu_time_second(0),
+          cpu_time_nanosecond(0),
+          event(n_packets_per_event, n_pixels, first_active_module_slot,
+                0, 0, scale, offset) { }
+
+    // Read the state and tack of the slot consistently (i.e. not while it
+    // is being claimed)
+    uint64_t LoadState(uint64_t& tack_) const {
+        for (;;) {
+            uint64_t state_ = state.load(std::memory_order_acquire);
+            tack_ = tack.load(std::memory_order_acquire);
+            if (GetPhase(state_) != CLAIMING &&
+                    state.load(std::memory_order_acquire) == state_) {
+                return state_;
+            }
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Bounded multi-producer multi-consumer queue of the emitted events
+// (D. Vyukov). The capacity equals the number of slots in the ring, so it
+// can never be full.
+template <typename TEvent>
+class EventBuilder<TEvent>::ReadyQueue {
+public:
+    explicit ReadyQueue(size_t capacity)
+        : mask_(capacity - 1),
+          cells_(capacity),
+          head_(0),
+          tail_(0)
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            cells_[i].turn.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    void Push(Slot* slot) {
+        uint64_t position = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[position & mask_];
+            uint64_t turn = cell->turn.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(turn - position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                std::this_thread::yield(); // Full (cannot happen)
+                position = tail_.load(std::memory_order_relaxed);
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->slot = slot;
+        cell->turn.store(position + 1, std::memory_order_release);
+    }
+
+    Slot* Pop() {
+        uint64_t position = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[position & mask_];
+            uint64_t turn = cell->turn.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(turn - (position + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return nullptr; // Empty
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+        Slot* slot = cell->slot;
+        cell->turn.store(position + mask_ + 1, std::memory_order_release);
+        return slot;
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> turn;
+        Slot* slot = nullptr;
+    };
+
+    uint64_t mask_;
+    std::vector<Cell> cells_;
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+};
+
+template <typename TEvent>
+struct EventBuilder<TEvent>::Counters {
+    std::atomic<uint64_t> n_packets{0};
+    std::atomic<uint64_t> n_stale_packets{0};
+    std::atomic<uint64_t> n_duplicate_packets{0};
+    std::atomic<uint64_t> n_late_packets{0};
+    std::atomic<uint64_t> n_invalid_packets{0};
+    std::atomic<uint64_t> n_dropped_packets{0};
+    std::atomic<uint64_t> n_missing_packets{0};
+    std::atomic<uint64_t> n_complete_events{0};
+    std::atomic<uint64_t> n_incomplete_events{0};
+
+    static void Increment(std::atomic<uint64_t>& counter, uint64_t n=1) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+template <typename TEvent>
+EventBuilder<TEvent>::EventBuilder(size_t n_packets_per_event, size_t n_pixels,
+        uint8_t first_active_module_slot, size_t n_events_in_ring,
+        std::chrono::nanoseconds timeout, float scale, float offset)
+    : n_packets_per_event_(n_packets_per_event),
+      n_pixels_(n_pixels),
+      first_active_module_slot_(first_active_module_slot),
+      timeout_(timeout),
+      mask_(RoundUpPowerOfTwo(n_events_in_ring) - 1),
+      ready_(std::make_unique<ReadyQueue>(mask_ + 1)),
+      counters_(std::make_unique<Counters>()),
+      cursor_(0)
+{
+    if (n_packets_per_event == 0 || n_events_in_ring == 0) {
+        throw std::runtime_error(
+            "EventBuilder requires a non-zero number of packets and events");
+    }
+    slots_.reserve(mask_ + 1);
+    for (size_t islot = 0; islot <= mask_; islot++) {
+        slots_.push_back(std::make_unique<Slot>(n_packets_per_event, n_pixels,
+            first_active_module_slot, scale, offset));
+    }
+}
+
+template <typename TEvent>
+EventBuilder<TEvent>::~EventBuilder() = default;
+
+template <typename TEvent>
+void EventBuilder<TEvent>::AddPacket(const std::shared_ptr<WaveformDataPacket>& packet) {
+    Counters::Increment(counters_->n_packets);
+
+    // Each packet of an event is identified by the pixel of its first waveform
+    if (!packet || packet->IsEmpty() || packet->GetNWaveforms() == 0 ||
+            packet->GetSlotID() < first_active_module_slot_) {
+        Counters::Increment(counters_->n_invalid_packets);
+        return;
+    }
+    Waveform waveform;
+    waveform.Associate(packet.get(), 0);
+    size_t key = (packet->GetSlotID() - first_active_module_slot_) *
+        N_PIXELS_PER_MODULE + waveform.GetPixelID();
+    if (key >= n_pixels_) {
+        Counters::Increment(counters_->n_invalid_packets);
+        return;
+    }
+    if (packet->GetStaleBit()) Counters::Increment(counters_->n_stale_packets);
+
+    // Register as a writer of the event, so it is not emitted until the
+    // packet has been stored
+    uint64_t tack = packet->GetTACK();
+    Slot* slot;
+    for (;;) {
+        slot = FindOrClaimSlot(tack);
+        if (!slot) return;
+        uint64_t state = slot->state.load(std::memory_order_seq_cst);
+        slot->n_writers.fetch_add(1, std::memory_order_seq_cst);
+        if (slot->state.load(std::memory_order_seq_cst) == state &&
+                GetPhase(state) == BUILDING &&
+                slot->tack.load(std::memory_order_acquire) == tack) break;
+        slot->n_writers.fetch_sub(1, std::memory_order_release);
+    }
+
+    uint64_t bit = uint64_t{1} << (key % 64);
+    if (slot->received[key / 64].fetch_or(bit, std::memory_order_relaxed) & bit) {
+        Counters::Increment(counters_->n_duplicate_packets);
+        slot->n_writers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    uint32_t index = slot->n_claimed.fetch_add(1, std::memory_order_relaxed);
+    if (index >= n_packets_per_event_) { // More packets than the event holds
+        Counters::Increment(counters_->n_invalid_packets);
+        slot->n_writers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    slot->packets[index] = packet;
+    bool complete = slot->n_stored.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        n_packets_per_event_;
+    uint64_t state = slot->state.load(std::memory_order_relaxed);
+    slot->n_writers.fetch_sub(1, std::memory_order_release);
+    if (complete) CloseSlot(*slot, state);
+}
+
+template <typename TEvent>
+typename EventBuilder<TEvent>::Slot* EventBuilder<TEvent>::FindOrClaimSlot(uint64_t tack) {
+    // Search the ring for the event, starting from the newest
+    uint64_t start = cursor_.load(std::memory_order_acquire);
+    for (size_t i = 1; i <= slots_.size(); i++) {
+        Slot& slot = *slots_[(start - i) & mask_];
+        uint64_t slot_tack;
+        uint64_t state = slot.LoadState(slot_tack);
+        if (slot_tack != tack || GetSequence(state) == NEVER_USED) continue;
+        if (GetPhase(state) == BUILDING) return &slot;
+        Counters::Increment(counters_->n_late_packets);
+        return nullptr;
+    }
+
+    // Claim the slot at the cursor for a new event. Every position from the
+    // start of the search is inspected, in case another receiver thread has
+    // claimed a slot for the same event in the meantime.
+    uint64_t position = start;
+    size_t n_skipped = 0;
+    for (;;) {
+        Slot& slot = *slots_[position & mask_];
+        uint64_t cursor = cursor_.load(std::memory_order_acquire);
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+
+        if (cursor == position && GetPhase(state) == FREE) {
+            if (!slot.state.compare_exchange_strong(state,
+                    MakeState(position, CLAIMING), std::memory_order_acq_rel)) {
+                continue;
+            }
+            if (cursor_.load(std::memory_order_acquire) != position) {
+                // Stale position: release the slot untouched
+                slot.state.store(state, std::memory_order_release);
+                continue;
+            }
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now);
+            slot.cpu_time_second = seconds.count();
+            slot.cpu_time_nanosecond = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(now - seconds).count();
+            slot.first_arrival.store(SteadyNow(), std::memory_order_relaxed);
+            slot.n_claimed.store(0, std::memory_order_relaxed);
+            slot.n_stored.store(0, std::memory_order_relaxed);
+            for (auto& word : slot.received) word.store(0, std::memory_order_relaxed);
+            slot.tack.store(tack, std::memory_order_release);
+            slot.state.store(MakeState(position, BUILDING), std::memory_order_release);
+            cursor_.compare_exchange_strong(position, position + 1,
+                std::memory_order_acq_rel);
+            return &slot;
+        }
+        if (cursor == position && GetPhase(state) == CLAIMING) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t slot_tack;
+        state = slot.LoadState(slot_tack);
+        if (GetSequence(state) == position && slot_tack == tack) {
+            if (GetPhase(state) == BUILDING) return &slot;
+            Counters::Increment(counters_->n_late_packets);
+            return nullptr;
+        }
+        if (cursor == position) {
+            // The slot is claimed by another event, or is still in use by an
+            // older event (which is skipped over)
+            if (GetSequence(state) != position && ++n_skipped > slots_.size()) {
+                Counters::Increment(counters_->n_dropped_packets);
+                return nullptr;
+            }
+            cursor_.compare_exchange_strong(cursor, position + 1,
+                std::memory_order_acq_rel);
+        }
+        position++;
+    }
+}
+
+template <typename TEvent>
+bool EventBuilder<TEvent>::CloseSlot(Slot& slot, uint64_t state) {
+    if (GetPhase(state) != BUILDING) return false;
+    uint64_t sequence = GetSequence(state);
+    if (!slot.state.compare_exchange_strong(state, MakeState(sequence, CLOSING),
+            std::memory_order_seq_cst)) {
+        return false; // Closed by another thread
+    }
+    while (slot.n_writers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    size_t n_stored = slot.n_stored.load(std::memory_order_relaxed);
+    TEvent& event = slot.event;
+    event.Reset();
+    event.SetCPUTime(slot.cpu_time_second, slot.cpu_time_nanosecond);
+    event.SetIndex(sequence);
+    for (size_t ipack = 0; ipack < n_stored; ipack++) {
+        event.AddPacketShared(slot.packets[ipack]);
+        slot.packets[ipack] = nullptr;
+    }
+    if (n_stored == n_packets_per_event_) {
+        Counters::Increment(counters_->n_complete_events);
+    } else {
+        Counters::Increment(counters_->n_incomplete_events);
+        Counters::Increment(counters_->n_missing_packets, n_packets_per_event_ - n_stored);
+    }
+
+    slot.state.store(MakeState(sequence, READY), std::memory_order_release);
+    ready_->Push(&slot);
+    return true;
+}
+
+template <typename TEvent>
+size_t EventBuilder<TEvent>::CloseSlots(bool timed_out_only) {
+    size_t n_closed = 0;
+    int64_t now = SteadyNow();
+    for (auto& slot : slots_) {
+        uint64_t state = slot->state.load(std::memory_order_acquire);
+        if (GetPhase(state) != BUILDING) continue;
+        int64_t first_arrival = slot->first_arrival.load(std::memory_order_relaxed);
+        if (timed_out_only && now - first_arrival < timeout_.count()) continue;
+        if (CloseSlot(*slot, state)) n_closed++;
+    }
+    return n_closed;
+}
+
+template <typename TEvent>
+size_t EventBuilder<TEvent>::CloseTimedOutEvents() {
+    return CloseSlots(true);
+}
+
+template <typename TEvent>
+size_t EventBuilder<TEvent>::CloseAllEvents() {
+    return CloseSlots(false);
+}
+
+template <typename TEvent>
+TEvent* EventBuilder<TEvent>::PopEvent() {
+    CloseTimedOutEvents();
+    Slot* slot = ready_->Pop();
+    return slot ? &slot->event : nullptr;
+}
+
+template <typename TEvent>
+void EventBuilder<TEvent>::ReleaseEvent(TEvent* event) {
+    Slot& slot = *slots_[event->GetIndex() & mask_];
+    uint64_t state = slot.state.load(std::memory_order_acquire);
+    if (&slot.event != event || GetPhase(state) != READY) {
+        std::ostringstream ss;
+        ss << "Event " << event->GetIndex() << " was not obtained from this EventBuilder";
+        throw std::runtime_error(ss.str());
+    }
+    event->Reset(); // Return the packets to their pool
+    slot.state.store(MakeState(GetSequence(state), FREE), std::memory_order_release);
+}
+
+template <typename TEvent>
+EventBuilderStats EventBuilder<TEvent>::GetStats() const {
+    EventBuilderStats stats;
+    stats.n_packets = counters_->n_packets.load(std::memory_order_relaxed);
+    stats.n_stale_packets = counters_->n_stale_packets.load(std::memory_order_relaxed);
+    stats.n_duplicate_packets = counters_->n_duplicate_packets.load(std::memory_order_relaxed);
+    stats.n_late_packets = counters_->n_late_packets.load(std::memory_order_relaxed);
+    stats.n_invalid_packets = counters_->n_invalid_packets.load(std::memory_order_relaxed);
+    stats.n_dropped_packets = counters_->n_dropped_packets.load(std::memory_order_relaxed);
+    stats.n_missing_packets = counters_->n_missing_packets.load(std::memory_order_relaxed);
+    stats.n_complete_events = counters_->n_complete_events.load(std::memory_order_relaxed);
+    stats.n_incomplete_events = counters_->n_incomplete_events.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template class EventBuilder<WaveformEventR0>;
+template class EventBuilder<WaveformEventR1>;
+
+}
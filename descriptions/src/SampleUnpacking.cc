@@ -0,0 +1,285 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/descriptions/SampleUnpacking.h"
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSTCAM_SAMPLE_UNPACKING_X86
+#include <immintrin.h>
+#endif
+
+namespace sstcam::descriptions {
+
+namespace {
+
+// The kernels are templated on the number of samples in the waveform. N = 0
+// is the generic kernel, which uses the n_samples argument. For N > 0 the
+// loop bounds are known at compile time, and the loops are fully unrolled.
+
+// Scalar kernels, also used for the samples remaining after the last full
+// vector of the SIMD kernels
+
+template <size_t N>
+void UnpackR0Scalar(const uint8_t* data, uint16_t* samples, size_t n_samples,
+        float, float) {
+    const size_t n = N ? N : n_samples;
+    for (size_t i = 0; i < n; i++) {
+        samples[i] = static_cast<uint16_t>(
+            static_cast<uint16_t>(data[2 * i] & 0xFu) << 8u | data[2 * i + 1]);
+    }
+}
+
+template <size_t N>
+void UnpackR1Scalar(const uint8_t* data, float* samples, size_t n_samples,
+        float scale, float offset) {
+    const size_t n = N ? N : n_samples;
+    for (size_t i = 0; i < n; i++) {
+        auto sample = static_cast<float>(
+            static_cast<uint16_t>(data[2 * i] << 8u) | data[2 * i + 1]);
+        samples[i] = (sample / scale) - offset;
+    }
+}
+
+#ifdef SSTCAM_SAMPLE_UNPACKING_X86
+
+// Byte order of each 16bit word is swapped with a single shuffle. The same
+// 128bit pattern is used by every lane of the wider registers.
+#define SSTCAM_BSWAP16_PATTERN 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+
+template <size_t N>
+__attribute__((target("sse4.1")))
+void UnpackR0SSE4(const uint8_t* data, uint16_t* samples, size_t n_samples,
+        float, float) {
+    const size_t n = N ? N : n_samples;
+    const __m128i bswap = _mm_set_epi8(SSTCAM_BSWAP16_PATTERN);
+    const __m128i mask = _mm_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[2 * i]));
+        v = _mm_and_si128(_mm_shuffle_epi8(v, bswap), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&samples[i]), v);
+    }
+    UnpackR0Scalar<0>(&data[2 * i], &samples[i], n - i, 1, 0);
+}
+
+template <size_t N>
+__attribute__((target("sse4.1")))
+void UnpackR1SSE4(const uint8_t* data, float* samples, size_t n_samples,
+        float scale, float offset) {
+    const size_t n = N ? N : n_samples;
+    const __m128i bswap = _mm_set_epi8(SSTCAM_BSWAP16_PATTERN);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 voffset = _mm_set1_ps(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[2 * i]));
+        v = _mm_shuffle_epi8(v, bswap);
+        __m128 lo = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v));
+        __m128 hi = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+        _mm_storeu_ps(&samples[i], _mm_sub_ps(_mm_div_ps(lo, vscale), voffset));
+        _mm_storeu_ps(&samples[i + 4], _mm_sub_ps(_mm_div_ps(hi, vscale), voffset));
+    }
+    UnpackR1Scalar<0>(&data[2 * i], &samples[i], n - i, scale, offset);
+}
+
+template <size_t N>
+__attribute__((target("avx2")))
+void UnpackR0AVX2(const uint8_t* data, uint16_t* samples, size_t n_samples,
+        float, float) {
+    const size_t n = N ? N : n_samples;
+    const __m256i bswap = _mm256_set_epi8(
+        SSTCAM_BSWAP16_PATTERN, SSTCAM_BSWAP16_PATTERN);
+    const __m256i mask = _mm256_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&data[2 * i]));
+        v = _mm256_and_si256(_mm256_shuffle_epi8(v, bswap), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&samples[i]), v);
+    }
+    UnpackR0Scalar<0>(&data[2 * i], &samples[i], n - i, 1, 0);
+}
+
+template <size_t N>
+__attribute__((target("avx2")))
+void UnpackR1AVX2(const uint8_t* data, float* samples, size_t n_samples,
+        float scale, float offset) {
+    const size_t n = N ? N : n_samples;
+    const __m256i bswap = _mm256_set_epi8(
+        SSTCAM_BSWAP16_PATTERN, SSTCAM_BSWAP16_PATTERN);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 voffset = _mm256_set1_ps(offset);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&data[2 * i]));
+        v = _mm256_shuffle_epi8(v, bswap);
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+        _mm256_storeu_ps(&samples[i], _mm256_sub_ps(_mm256_div_ps(lo, vscale), voffset));
+        _mm256_storeu_ps(&samples[i + 8], _mm256_sub_ps(_mm256_div_ps(hi, vscale), voffset));
+    }
+    UnpackR1Scalar<0>(&data[2 * i], &samples[i], n - i, scale, offset);
+}
+
+// The zero-masked forms (with every lane selected) are used for the AVX-512
+// intrinsics, as the unmasked forms trigger false -Wuninitialized warnings in
+// some GCC versions
+constexpr __mmask16 ALL_LANES = 0xFFFF;
+
+template <size_t N>
+__attribute__((target("avx512f,avx512bw")))
+void UnpackR0AVX512(const uint8_t* data, uint16_t* samples, size_t n_samples,
+        float, float) {
+    const size_t n = N ? N : n_samples;
+    const __m512i bswap = _mm512_maskz_broadcast_i32x4(
+        ALL_LANES, _mm_set_epi8(SSTCAM_BSWAP16_PATTERN));
+    const __m512i mask = _mm512_set1_epi16(0x0FFF);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i v = _mm512_loadu_si512(&data[2 * i]);
+        v = _mm512_and_si512(_mm512_shuffle_epi8(v, bswap), mask);
+        _mm512_storeu_si512(&samples[i], v);
+    }
+    UnpackR0Scalar<0>(&data[2 * i], &samples[i], n - i, 1, 0);
+}
+
+template <size_t N>
+__attribute__((target("avx512f,avx512bw")))
+void UnpackR1AVX512(const uint8_t* data, float* samples, size_t n_samples,
+        float scale, float offset) {
+    const size_t n = N ? N : n_samples;
+    const __m512i bswap = _mm512_maskz_broadcast_i32x4(
+        ALL_LANES, _mm_set_epi8(SSTCAM_BSWAP16_PATTERN));
+    const __m512 vscale = _mm512_set1_ps(scale);
+    const __m512 voffset = _mm512_set1_ps(offset);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i v = _mm512_loadu_si512(&data[2 * i]);
+        v = _mm512_shuffle_epi8(v, bswap);
+        __m512 lo = _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu16_epi32(
+            ALL_LANES, _mm512_maskz_extracti64x4_epi64(0xFF, v, 0)));
+        __m512 hi = _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu16_epi32(
+            ALL_LANES, _mm512_maskz_extracti64x4_epi64(0xFF, v, 1)));
+        _mm512_storeu_ps(&samples[i], _mm512_sub_ps(_mm512_div_ps(lo, vscale), voffset));
+        _mm512_storeu_ps(&samples[i + 16], _mm512_sub_ps(_mm512_div_ps(hi, vscale), voffset));
+    }
+    UnpackR1Scalar<0>(&data[2 * i], &samples[i], n - i, scale, offset);
+}
+
+#undef SSTCAM_BSWAP16_PATTERN
+
+#endif
+
+struct Kernels {
+    UnpackSamplesFunction<uint16_t> r0;
+    UnpackSamplesFunction<float> r1;
+};
+
+template <size_t N>
+Kernels GetKernelsForNSamples(SampleUnpackingKernel kernel) {
+    switch (kernel) {
+#ifdef SSTCAM_SAMPLE_UNPACKING_X86
+        case SampleUnpackingKernel::AVX512:
+            return {UnpackR0AVX512<N>, UnpackR1AVX512<N>};
+        case SampleUnpackingKernel::AVX2:
+            return {UnpackR0AVX2<N>, UnpackR1AVX2<N>};
+        case SampleUnpackingKernel::SSE4:
+            return {UnpackR0SSE4<N>, UnpackR1SSE4<N>};
+#endif
+        default:
+            return {UnpackR0Scalar<N>, UnpackR1Scalar<N>};
+    }
+}
+
+// Kernels for waveforms of n_samples, using the specialization for the
+// common waveform lengths
+Kernels GetKernels(SampleUnpackingKernel kernel, size_t n_samples) {
+    switch (n_samples) {
+        case 64:
+            return GetKernelsForNSamples<64>(kernel);
+        case 96:
+            return GetKernelsForNSamples<96>(kernel);
+        case 128:
+            return GetKernelsForNSamples<128>(kernel);
+        default:
+            return GetKernelsForNSamples<0>(kernel);
+    }
+}
+
+void CheckKernelSupported(SampleUnpackingKernel kernel) {
+    if (!IsSampleUnpackingKernelSupported(kernel)) {
+        throw std::runtime_error("Sample unpacking kernel is not supported by this CPU");
+    }
+}
+
+}
+
+SampleUnpackingKernel GetSampleUnpackingKernel() {
+    static const SampleUnpackingKernel kernel = [] {
+        for (auto k : {SampleUnpackingKernel::AVX512, SampleUnpackingKernel::AVX2,
+                       SampleUnpackingKernel::SSE4}) {
+            if (IsSampleUnpackingKernelSupported(k)) return k;
+        }
+        return SampleUnpackingKernel::SCALAR;
+    }();
+    return kernel;
+}
+
+bool IsSampleUnpackingKernelSupported(SampleUnpackingKernel kernel) {
+    switch (kernel) {
+        case SampleUnpackingKernel::SCALAR:
+            return true;
+#ifdef SSTCAM_SAMPLE_UNPACKING_X86
+        case SampleUnpackingKernel::SSE4:
+            return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+        case SampleUnpackingKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SampleUnpackingKernel::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:
+            return false;
+    }
+}
+
+UnpackSamplesFunction<uint16_t> GetUnpackSamplesR0Function(
+        SampleUnpackingKernel kernel, size_t n_samples) {
+    CheckKernelSupported(kernel);
+    return GetKernels(kernel, n_samples).r0;
+}
+
+UnpackSamplesFunction<float> GetUnpackSamplesR1Function(
+        SampleUnpackingKernel kernel, size_t n_samples) {
+    CheckKernelSupported(kernel);
+    return GetKernels(kernel, n_samples).r1;
+}
+
+UnpackSamplesFunction<uint16_t> GetUnpackSamplesR0Function(size_t n_samples) {
+    return GetKernels(GetSampleUnpackingKernel(), n_samples).r0;
+}
+
+UnpackSamplesFunction<float> GetUnpackSamplesR1Function(size_t n_samples) {
+    return GetKernels(GetSampleUnpackingKernel(), n_samples).r1;
+}
+
+void UnpackSamplesR0(SampleUnpackingKernel kernel, const uint8_t* data,
+        uint16_t* samples, size_t n_samples) {
+    GetUnpackSamplesR0Function(kernel, n_samples)(data, samples, n_samples, 1, 0);
+}
+
+void UnpackSamplesR1(SampleUnpackingKernel kernel, const uint8_t* data,
+        float* samples, size_t n_samples, float scale, float offset) {
+    GetUnpackSamplesR1Function(kernel, n_samples)(data, samples, n_samples, scale, offset);
+}
+
+void UnpackSamplesR0(const uint8_t* data, uint16_t* samples, size_t n_samples,
+        float, float) {
+    GetUnpackSamplesR0Function(n_samples)(data, samples, n_samples, 1, 0);
+}
+
+void UnpackSamplesR1(const uint8_t* data, float* samples, size_t n_samples,
+        float scale, float offset) {
+    GetUnpackSamplesR1Function(n_samples)(data, samples, n_samples, scale, offset);
+}
+
+}
@@ -2,9 +2,43 @@
 // This software is distributed under the terms of the BSD-3-Clause license.
 
 #include "sstcam/descriptions/WaveformDataPacket.h"
+#include <array>
 
 namespace sstcam::descriptions {
 
+namespace {
+
+constexpr uint16_t CRC_POLYNOMIAL = 0x1021;
+constexpr uint16_t CRC_INITIAL = 0xFFFF;
+constexpr size_t CRC_SLICES = 8;
+using CRCTables = std::array<std::array<uint16_t, 256>, CRC_SLICES>;
+
+// Lookup tables for the slice-by-8 CRC. tables[0] advances the CRC by a
+// single byte, and tables[k] by a byte followed by k zero bytes.
+constexpr CRCTables GenerateCRCTables() {
+    CRCTables tables{};
+    for (uint16_t byte = 0; byte < 256; byte++) {
+        auto crc = static_cast<uint16_t>(byte << 8u);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000u) ? static_cast<uint16_t>((crc << 1u) ^ CRC_POLYNOMIAL)
+                                  : static_cast<uint16_t>(crc << 1u);
+        }
+        tables[0][byte] = crc;
+    }
+    for (size_t k = 1; k < CRC_SLICES; k++) {
+        for (uint16_t byte = 0; byte < 256; byte++) {
+            uint16_t previous = tables[k - 1][byte];
+            tables[k][byte] = static_cast<uint16_t>(
+                (previous << 8u) ^ tables[0][previous >> 8u]);
+        }
+    }
+    return tables;
+}
+
+constexpr CRCTables CRC_TABLES = GenerateCRCTables();
+
+}
+
 uint16_t WaveformDataPacket::CalculatePacketSizeBytes(
         uint16_t n_samples_per_waveform, uint16_t n_waveforms_per_packet) {
     uint16_t n_buffers = 2 * (n_samples_per_waveform / n_waveforms_per_packet);
@@ -25,21 +59,53 @@ void WaveformDataPacket::CalculateRowColumnBlockPhase(const uint16_t cell_id,
     column = (cell_id / SAMPLES_PER_WAVEFORM_BLOCK) / 8u;
 }
 
-bool WaveformDataPacket::IsValid() const {
+uint16_t WaveformDataPacket::CalculateCRC(const uint8_t* data, size_t n_bytes) {
+    uint16_t crc = CRC_INITIAL;
+
+    // Process 8 bytes per iteration
+    size_t i = 0;
+    for (; i + CRC_SLICES <= n_bytes; i += CRC_SLICES) {
+        const uint8_t* d = &data[i];
+        crc = CRC_TABLES[7][d[0] ^ (crc >> 8u)] ^
+              CRC_TABLES[6][d[1] ^ (crc & 0xFFu)] ^
+              CRC_TABLES[5][d[2]] ^ CRC_TABLES[4][d[3]] ^
+              CRC_TABLES[3][d[4]] ^ CRC_TABLES[2][d[5]] ^
+              CRC_TABLES[1][d[6]] ^ CRC_TABLES[0][d[7]];
+    }
+    for (; i < n_bytes; i++) {
+        crc = static_cast<uint16_t>(
+            (crc << 8u) ^ CRC_TABLES[0][(crc >> 8u) ^ data[i]]);
+    }
+    return crc;
+}
+
+bool WaveformDataPacket::IsCRCValid() const {
+    // The CRC covers the packet up to the footer (CRC and MBZ words)
+    if (packet_size_ < 2 * PACKET_FOOTER_WORDS) return false;
+    return GetCRC() == CalculateCRC(packet_, packet_size_ - 2 * PACKET_FOOTER_WORDS);
+}
+
+bool WaveformDataPacket::IsValid(bool check_crc) const {
     if (packet_size_ == 0) return false;
     if (packet_size_ != GetPacketNBytes()) return false;
 
-#ifdef PERFORM_CRC_CHECK
-    uint16_t crc = GetCRC();
-    if (crc != Util::CRC(fPacketSize - 4, fData)) return False;  // TODO: CRC calculation
-#endif
-
     if (GetMBZ() != 0) return false;
     if (IsTimeout()) return false;
     if (IsError()) return false;
+    if (check_crc && !IsCRCValid()) return false;
 
     return true;
 }
 
+std::vector<bool> ValidatePacketSlab(uint8_t* data, size_t n_packets,
+        size_t packet_size, size_t stride, bool check_crc) {
+    std::vector<bool> valid(n_packets);
+    WaveformDataPacket packet(data, packet_size);
+    for (size_t ipack = 0; ipack < n_packets; ipack++) {
+        packet.Wrap(&data[ipack * stride]);
+        valid[ipack] = packet.IsValid(check_crc);
+    }
+    return valid;
+}
 
 }
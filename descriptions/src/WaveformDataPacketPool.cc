@@ -0,0 +1,245 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/descriptions/WaveformDataPacketPool.h"
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <sys/mman.h>
+
+namespace sstcam::descriptions {
+
+namespace {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Space reserved in each slot for the control block of the shared_ptr
+constexpr size_t CONTROL_BLOCK_SIZE = 64;
+
+constexpr size_t RoundUp(size_t value, size_t multiple) {
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+}
+
+class WaveformDataPacketPool::Storage {
+public:
+    struct Slot {
+        alignas(std::max_align_t) unsigned char control_block[CONTROL_BLOCK_SIZE];
+        WaveformDataPacket packet;
+        std::shared_ptr<Storage> owner; // Keeps the storage alive while in use
+
+        Slot(uint8_t* buffer, size_t packet_size)
+            : control_block(), packet(buffer, packet_size) { }
+    };
+
+    // Allocator that places the control block of a packet's shared_ptr in
+    // its slot, and returns the slot to the pool once the control block is
+    // released (i.e. after the last shared_ptr and weak_ptr are gone)
+    template <typename T>
+    struct SlotAllocator {
+        using value_type = T;
+        Slot* slot;
+
+        explicit SlotAllocator(Slot* slot_) noexcept : slot(slot_) { }
+
+        template <typename U>
+        SlotAllocator(const SlotAllocator<U>& other) noexcept : slot(other.slot) { } // NOLINT
+
+        T* allocate(size_t n) {
+            static_assert(sizeof(T) <= CONTROL_BLOCK_SIZE, "Control block too large");
+            static_assert(alignof(T) <= alignof(std::max_align_t), "Control block over-aligned");
+            if (n != 1) throw std::bad_alloc();
+            return reinterpret_cast<T*>(slot->control_block);
+        }
+
+        void deallocate(T*, size_t) noexcept {
+            Release(slot);
+        }
+
+        template <typename U>
+        bool operator==(const SlotAllocator<U>& other) const { return slot == other.slot; }
+        template <typename U>
+        bool operator!=(const SlotAllocator<U>& other) const { return slot != other.slot; }
+    };
+
+    Storage(size_t packet_size, size_t n_packets_per_slab, bool huge_pages)
+        : packet_size_(packet_size),
+          packet_stride_(RoundUp(packet_size, CACHE_LINE_SIZE)),
+          n_packets_per_slab_(n_packets_per_slab),
+          huge_pages_(huge_pages),
+          using_huge_pages_(huge_pages),
+          n_packets_total_(0)
+    {
+        if (packet_size == 0 || n_packets_per_slab == 0) {
+            throw std::runtime_error(
+                "WaveformDataPacketPool requires a non-zero packet size and slab size");
+        }
+        slab_size_ = packet_stride_ * n_packets_per_slab_;
+        if (huge_pages_) {
+            // Fill the remainder of the last huge page with packets
+            slab_size_ = RoundUp(slab_size_, HUGE_PAGE_SIZE);
+            n_packets_per_slab_ = slab_size_ / packet_stride_;
+        }
+    }
+
+    ~Storage() {
+        for (auto& slab : slabs_) munmap(slab.data, slab_size_);
+    }
+
+    Storage(const Storage&) = delete;
+    Storage& operator=(const Storage&) = delete;
+
+    std::shared_ptr<WaveformDataPacket> Acquire(const std::shared_ptr<Storage>& self) {
+        Slot* slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.empty()) AllocateSlab();
+            slot = free_.back();
+            free_.pop_back();
+        }
+        std::memset(slot->packet.GetDataPacket(), 0, packet_size_);
+        slot->owner = self;
+        return std::shared_ptr<WaveformDataPacket>(
+            &slot->packet, [](WaveformDataPacket*) { }, SlotAllocator<WaveformDataPacket>(slot));
+    }
+
+    static void Release(Slot* slot) noexcept {
+        // Take the reference to the storage before the slot can be
+        // reacquired, so the storage is only destroyed after it is unlocked
+        std::shared_ptr<Storage> owner = std::move(slot->owner);
+        std::lock_guard<std::mutex> lock(owner->mutex_);
+        owner->free_.push_back(slot);
+    }
+
+    void Reserve(size_t n_packets) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (free_.size() < n_packets) AllocateSlab();
+    }
+
+    [[nodiscard]] size_t GetPacketSize() const { return packet_size_; }
+    [[nodiscard]] size_t GetNPacketsPerSlab() const { return n_packets_per_slab_; }
+
+    [[nodiscard]] size_t GetNSlabs() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return slabs_.size();
+    }
+
+    [[nodiscard]] size_t GetNPacketsFree() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+    [[nodiscard]] size_t GetNPacketsInUse() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return n_packets_total_ - free_.size();
+    }
+
+    [[nodiscard]] bool IsUsingHugePages() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return using_huge_pages_;
+    }
+
+private:
+    struct Slab {
+        void* data;
+        std::vector<Slot> slots;
+    };
+
+    // Must be called with the mutex held
+    void AllocateSlab() {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE; // Take the page faults now, not while filling
+#endif
+        void* data = MAP_FAILED;
+        bool huge = false;
+#ifdef MAP_HUGETLB
+        if (huge_pages_) {
+            data = mmap(nullptr, slab_size_, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+            huge = data != MAP_FAILED;
+        }
+#endif
+        if (data == MAP_FAILED) {
+            data = mmap(nullptr, slab_size_, PROT_READ | PROT_WRITE, flags, -1, 0);
+        }
+        if (data == MAP_FAILED) {
+            std::ostringstream ss;
+            ss << "Cannot allocate WaveformDataPacketPool slab of " << slab_size_
+               << " bytes (" << std::strerror(errno) << ")";
+            throw std::runtime_error(ss.str());
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge_pages_ && !huge) {
+            huge = madvise(data, slab_size_, MADV_HUGEPAGE) == 0;
+        }
+#endif
+        using_huge_pages_ = using_huge_pages_ && huge;
+
+        Slab& slab = slabs_.emplace_back();
+        slab.data = data;
+        slab.slots.reserve(n_packets_per_slab_);
+        free_.reserve(free_.size() + n_packets_per_slab_);
+        auto* buffer = static_cast<uint8_t*>(data);
+        for (size_t ipack = 0; ipack < n_packets_per_slab_; ipack++) {
+            Slot& slot = slab.slots.emplace_back(&buffer[ipack * packet_stride_], packet_size_);
+            free_.push_back(&slot);
+        }
+        n_packets_total_ += n_packets_per_slab_;
+    }
+
+    size_t packet_size_;
+    size_t packet_stride_;
+    size_t n_packets_per_slab_;
+    size_t slab_size_;
+    bool huge_pages_;
+    bool using_huge_pages_;
+    size_t n_packets_total_;
+
+    mutable std::mutex mutex_;
+    std::vector<Slab> slabs_;
+    std::vector<Slot*> free_;
+};
+
+WaveformDataPacketPool::WaveformDataPacketPool(size_t packet_size,
+        size_t n_packets_per_slab, bool huge_pages)
+    : storage_(std::make_shared<Storage>(packet_size, n_packets_per_slab, huge_pages)) { }
+
+std::shared_ptr<WaveformDataPacket> WaveformDataPacketPool::Acquire() {
+    return storage_->Acquire(storage_);
+}
+
+void WaveformDataPacketPool::Reserve(size_t n_packets) {
+    storage_->Reserve(n_packets);
+}
+
+size_t WaveformDataPacketPool::GetPacketSize() const {
+    return storage_->GetPacketSize();
+}
+
+size_t WaveformDataPacketPool::GetNPacketsPerSlab() const {
+    return storage_->GetNPacketsPerSlab();
+}
+
+size_t WaveformDataPacketPool::GetNSlabs() const {
+    return storage_->GetNSlabs();
+}
+
+size_t WaveformDataPacketPool::GetNPacketsFree() const {
+    return storage_->GetNPacketsFree();
+}
+
+size_t WaveformDataPacketPool::GetNPacketsInUse() const {
+    return storage_->GetNPacketsInUse();
+}
+
+bool WaveformDataPacketPool::IsUsingHugePages() const {
+    return storage_->IsUsingHugePages();
+}
+
+}
@@ -0,0 +1,69 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/descriptions/WaveformDecodePlan.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include <sstream>
+
+namespace sstcam::descriptions {
+
+WaveformDecodePlan::WaveformDecodePlan(
+        const std::vector<WaveformDataPacket*>& packets,
+        uint8_t first_active_module_slot)
+    : n_samples_(0)
+{
+    Waveform waveform;
+    for (size_t ipack = 0; ipack < packets.size(); ipack++) {
+        WaveformDataPacket* packet = packets[ipack];
+        if (!packet || packet->IsEmpty()) {
+            std::ostringstream ss;
+            ss << "Cannot build a WaveformDecodePlan: packet " << ipack << " is missing";
+            throw std::runtime_error(ss.str());
+        }
+        if (ipack == 0) {
+            n_samples_ = packet->GetWaveformNSamples();
+        } else if (packet->GetWaveformNSamples() != n_samples_) {
+            throw std::runtime_error(
+                "Cannot build a WaveformDecodePlan: packets differ in n_samples");
+        }
+        packets_.push_back({packet->GetSlotID(), packet->GetNWaveforms(),
+                            packet->GetNBuffers()});
+
+        uint8_t module = packet->GetSlotID() - first_active_module_slot;
+        for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++) {
+            waveform.Associate(packet, iwav);
+            auto byte_offset = static_cast<uint16_t>(
+                waveform.GetSampleData() - packet->GetDataPacket());
+            auto pixel = static_cast<uint16_t>(
+                module * N_PIXELS_PER_MODULE + waveform.GetPixelID());
+            entries_.push_back({static_cast<uint16_t>(ipack), byte_offset, pixel});
+        }
+    }
+}
+
+bool WaveformDecodePlan::Matches(
+        const std::vector<WaveformDataPacket*>& packets) const {
+    if (packets.size() != packets_.size()) return false;
+    for (size_t ipack = 0; ipack < packets.size(); ipack++) {
+        const WaveformDataPacket* packet = packets[ipack];
+        const PacketGeometry& geometry = packets_[ipack];
+        if (!packet ||
+            packet->GetSlotID() != geometry.slot ||
+            packet->GetNWaveforms() != geometry.n_waveforms ||
+            packet->GetNBuffers() != geometry.n_buffers) return false;
+    }
+
+    // The channels read out can differ between events (zero suppression),
+    // so the pixel of every waveform is also compared (one header byte)
+    Waveform waveform;
+    auto entry = entries_.begin();
+    for (const WaveformDataPacket* packet : packets) {
+        for (uint16_t iwav = 0; iwav < packet->GetNWaveforms(); iwav++, entry++) {
+            waveform.Associate(packet, iwav);
+            if (waveform.GetPixelID() != entry->pixel % N_PIXELS_PER_MODULE) return false;
+        }
+    }
+    return true;
+}
+
+}
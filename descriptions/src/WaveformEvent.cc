@@ -3,6 +3,7 @@
 
 #include "sstcam/descriptions/WaveformEvent.h"
 #include <sstream>
+#include <stdexcept>
 
 namespace sstcam::descriptions {
 
@@ -43,14 +44,17 @@ WaveformEvent::WaveformEvent(size_t n_packets_per_event, size_t n_pixels,
       scale_(scale),
       offset_(offset),
       index_(index)
-{ }
+{
+    Reset();
+}
 
 void WaveformEvent::AddPacket(WaveformDataPacket* packet) {
     if (IsFilled()) { // TODO: Remove this check for speed improvement?
         std::cerr << "WaveformEvent is full" << std::endl;
         return;
     }
-    packets_[packet_index_++] = packet;
+    packets_[packet_index_] = packet;
+    SummarisePacket(packet_index_++);
 }
 
 void WaveformEvent::AddPacketShared(const std::shared_ptr<WaveformDataPacket>& packet) {
@@ -60,28 +64,115 @@ void WaveformEvent::AddPacketShared(const std::shared_ptr<WaveformDataPacket>& p
     }
     packets_[packet_index_] = packet.get();
     packets_owned_[packet_index_] = packet;
-    packet_index_++;
+    SummarisePacket(packet_index_++);
 }
 
 void WaveformEvent::Reset() {
     std::fill(packets_.begin(), packets_.end(), nullptr);
+    std::fill(packets_owned_.begin(), packets_owned_.end(), nullptr);
     packet_index_ = 0;
+    summary_ = PacketSummary();
+    summary_.missing.assign(n_packets_per_event_, true);
+    summary_.n_missing = n_packets_per_event_;
+}
+
+void WaveformEvent::SummarisePacket(size_t packet_index) {
+    WaveformDataPacket* packet = packets_[packet_index];
+    if (!packet || packet->IsEmpty()) return;
+    summary_.missing[packet_index] = false;
+    summary_.n_missing--;
+    if (!summary_.first_packet) {
+        summary_.first_packet = packet;
+        summary_.tack = packet->GetTACK();
+        summary_.first_cell_id = packet->GetFirstCellID();
+        summary_.stale = packet->GetStaleBit() == 1;
+    }
+}
+
+std::vector<bool> WaveformEvent::ValidatePackets(bool check_crc) const {
+    std::vector<bool> valid(packets_.size());
+    for (size_t ipack = 0; ipack < packets_.size(); ipack++) {
+        valid[ipack] = packets_[ipack] && packets_[ipack]->IsValid(check_crc);
+    }
+    return valid;
+}
+
+std::vector<const uint8_t*> WaveformEvent::GetPresentWaveforms() const {
+    std::vector<const uint8_t*> waveforms(n_pixels_, nullptr);
+    size_t n_modules = n_pixels_ / N_PIXELS_PER_MODULE;
+    Waveform waveform;
+    for (size_t ipack = 0; ipack < packets_.size(); ipack++) {
+        if (summary_.missing[ipack]) continue; // Not added, or added empty
+        WaveformDataPacket* packet = packets_[ipack];
+        uint8_t module = packet->GetSlotID() - first_active_module_slot_;
+        if (module >= n_modules) continue;
+        uint16_t n_waveforms = packet->GetNWaveforms();
+        uint8_t* waveform_data = &packet->GetDataPacket()[packet->GetWaveformStart(0)];
+        uint16_t waveform_n_bytes = packet->GetWaveformNBytes();
+        for (unsigned short i_waveform = 0; i_waveform < n_waveforms; i_waveform++) {
+            waveform.Associate(waveform_data);
+            waveform_data += waveform_n_bytes;
+            if (waveform.IsZeroSuppressed()) continue;
+            size_t i_pixel = module * N_PIXELS_PER_MODULE + waveform.GetPixelID();
+            waveforms[i_pixel] = waveform.GetSampleData();
+        }
+    }
+    return waveforms;
+}
+
+std::vector<uint16_t> WaveformEvent::GetPresentPixels() const {
+    std::vector<const uint8_t*> waveforms = GetPresentWaveforms();
+    std::vector<uint16_t> pixels;
+    pixels.reserve(n_pixels_);
+    for (size_t i_pixel = 0; i_pixel < waveforms.size(); i_pixel++) {
+        if (waveforms[i_pixel]) pixels.push_back(static_cast<uint16_t>(i_pixel));
+    }
+    return pixels;
+}
+
+size_t WaveformEvent::GetNPixelsPresent() const {
+    std::vector<const uint8_t*> waveforms = GetPresentWaveforms();
+    return waveforms.size() - std::count(waveforms.begin(), waveforms.end(), nullptr);
 }
 
-bool WaveformEvent::IsMissingPackets() const {
-    if (!IsFilled()) return true;
-    if (packets_.size() != n_packets_per_event_) return true;
-    for (WaveformDataPacket* packet : packets_) {
-        if (!packet || packet->IsEmpty()) return true;
+std::vector<int32_t> WaveformEvent::GetPixelSubsetRows(
+        const std::vector<uint16_t>& pixels) const {
+    std::vector<int32_t> output_rows(n_pixels_, -1);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        if (pixels[i] >= n_pixels_) {
+            std::ostringstream ss;
+            ss << "Pixel " << pixels[i] << " is not in the event (n_pixels = "
+               << n_pixels_ << ")";
+            throw std::out_of_range(ss.str());
+        }
+        if (output_rows[pixels[i]] != -1) {
+            std::ostringstream ss;
+            ss << "Pixel " << pixels[i] << " is selected more than once";
+            throw std::invalid_argument(ss.str());
+        }
+        output_rows[pixels[i]] = static_cast<int32_t>(i);
     }
-    return false;
+    return output_rows;
 }
 
-WaveformDataPacket* WaveformEvent::GetFirstPacket() const {
-    for (WaveformDataPacket* packet : packets_) {
-        if (packet && !packet->IsEmpty()) return packet;
+std::vector<int32_t> WaveformEvent::GetModuleSubsetRows(
+        const std::set<uint8_t>& module_slots) const {
+    std::vector<int32_t> output_rows(n_pixels_, -1);
+    size_t n_modules = n_pixels_ / N_PIXELS_PER_MODULE;
+    int32_t row = 0;
+    for (uint8_t slot : module_slots) {
+        size_t module = static_cast<size_t>(slot - first_active_module_slot_);
+        if (slot < first_active_module_slot_ || module >= n_modules) {
+            std::ostringstream ss;
+            ss << "Module slot " << static_cast<uint16_t>(slot)
+               << " is not in the event";
+            throw std::out_of_range(ss.str());
+        }
+        for (uint8_t ipix = 0; ipix < N_PIXELS_PER_MODULE; ipix++) {
+            output_rows[module * N_PIXELS_PER_MODULE + ipix] = row++;
+        }
     }
-    throw std::runtime_error("WaveformEvent is empty");
+    return output_rows;
 }
 
 }
@@ -170,6 +170,34 @@ TEST_CASE("FitsUtils") {
         CHECK(value_string == "15639");
     }
 
+    SUBCASE("ReadHeaderKeywords") {
+        CHECK_THROWS_AS(ReadHeaderKeywords(nullptr), std::runtime_error);
+        HeaderKeywords keywords = ReadHeaderKeywords(fits_);
+        CHECK(keywords.count("EVENT_HEADER_VERSION") == 1);
+        CHECK(keywords.count("COMMENT") == 0);
+        CHECK(keywords.count("") == 0);
+
+        // Conversions match GetHeaderKeyValue
+        for (const char* key : {"EVENT_HEADER_VERSION", "SCALE", "R1", "RUNNUMBER"}) {
+            CHECK(GetKeywordValue<int32_t>(keywords, key) ==
+                  GetHeaderKeyValue<int32_t, TINT>(fits_, key));
+            CHECK(GetKeywordValue<float>(keywords, key) ==
+                  GetHeaderKeyValue<float, TFLOAT>(fits_, key));
+            CHECK(GetKeywordValue<double>(keywords, key) ==
+                  GetHeaderKeyValue<double, TDOUBLE>(fits_, key));
+            CHECK(GetKeywordValue<std::string>(keywords, key) ==
+                  GetHeaderKeyValue<std::string, TSTRING>(fits_, key));
+        }
+        CHECK(GetKeywordValue<int16_t>(keywords, "EVENT_HEADER_VERSION") == 2);
+        CHECK(GetKeywordValue<float>(keywords, "SCALE") == 23.4f);
+        CHECK(GetKeywordValue<bool>(keywords, "R1"));
+        CHECK(GetKeywordValue<uint32_t>(keywords, "RUNNUMBER") == 15639);
+        CHECK(GetKeywordValue<std::string>(keywords, "OBSERVER") == "cta");
+        CHECK_THROWS_AS(GetKeywordValue<bool>(keywords, "OBSERVER"), std::runtime_error);
+        CHECK_THROWS(GetKeywordValue<int32_t>(keywords, "OBSERVER"));
+        CHECK_THROWS(GetKeywordValue<int32_t>(keywords, ""));
+    }
+
     status = 0;
     REQUIRE(!fits_close_file(fits_, &status));
 }
@@ -0,0 +1,47 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/MappedFile.h"
+#include "doctest.h"
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+namespace sstcam::io {
+
+TEST_CASE("MappedFile") {
+    std::string path = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    REQUIRE(file.good());
+    auto file_size = static_cast<size_t>(file.tellg());
+
+    SUBCASE("Map") {
+        MappedFile mapping(path);
+        CHECK(mapping.GetSize() == file_size);
+        CHECK(std::memcmp(mapping.GetData(), "SIMPLE  =", 9) == 0);
+    }
+
+    SUBCASE("Contents") {
+        MappedFile mapping(path);
+        std::vector<char> contents(file_size);
+        file.seekg(0);
+        file.read(contents.data(), file_size);
+        CHECK(std::memcmp(mapping.GetData(), contents.data(), file_size) == 0);
+    }
+
+    SUBCASE("Copy-on-write") {
+        {
+            MappedFile mapping(path);
+            mapping.GetData()[0] = 'X';
+            CHECK(mapping.GetData()[0] == 'X');
+        }
+        MappedFile mapping(path);
+        CHECK(mapping.GetData()[0] == 'S');
+    }
+
+    SUBCASE("Missing file") {
+        CHECK_THROWS_AS(MappedFile("/not/a/file.fits"), std::runtime_error);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOEventIndex.h"
+#include "sstcam/io/TIOReader.h"
+#include "doctest.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace sstcam::io {
+
+TEST_CASE("TIOEventIndex") {
+    std::string path = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::ifstream file(path);
+    REQUIRE(file.good());
+    file.close();
+
+    auto reader = TIOReader(path);
+    size_t n_events = reader.GetNEvents();
+    const auto& tacks = reader.GetEventTACKColumn();
+    const auto& event_ids = reader.GetEventIDColumn();
+
+    SUBCASE("Built on first use") {
+        const TIOEventIndex& index = reader.GetEventIndex();
+        CHECK(&reader.GetEventIndex() == &index);
+        CHECK(index.GetNEvents() == n_events);
+        CHECK(!index.IsLoaded());
+    }
+
+    TIOEventIndex index(reader);
+
+    SUBCASE("FindTACK") {
+        bool matches = true;
+        for (size_t iev = 0; iev < n_events; iev++) {
+            // The first event with the TACK
+            auto found = index.FindTACK(tacks[iev]);
+            if (!found || tacks[*found] != tacks[iev] || *found > iev) matches = false;
+        }
+        CHECK(matches);
+        CHECK(index.FindTACK(4426394938696) == 0);
+        CHECK(!index.FindTACK(0).has_value());
+    }
+
+    SUBCASE("FindNearestTACK") {
+        CHECK(index.FindNearestTACK(tacks[3]) == 3);
+        bool matches = true;
+        for (size_t iev = 0; iev < n_events; iev++) {
+            for (int64_t delta : {-1000, -1, 1, 1000}) {
+                uint64_t tack = tacks[iev] + delta;
+                // Reference: linear scan
+                size_t nearest = 0;
+                for (size_t jev = 1; jev < n_events; jev++) {
+                    uint64_t distance = std::max(tacks[jev], tack) - std::min(tacks[jev], tack);
+                    uint64_t nearest_distance = std::max(tacks[nearest], tack) -
+                        std::min(tacks[nearest], tack);
+                    if (distance < nearest_distance ||
+                        (distance == nearest_distance && tacks[jev] < tacks[nearest]))
+                        nearest = jev;
+                }
+                if (tacks[index.FindNearestTACK(tack)] != tacks[nearest]) matches = false;
+            }
+        }
+        CHECK(matches);
+    }
+
+    SUBCASE("FindTACKRange") {
+        uint64_t first = std::min(tacks[2], tacks[5]);
+        uint64_t last = std::max(tacks[2], tacks[5]);
+        std::vector<size_t> range = index.FindTACKRange(first, last);
+        size_t n_expected = 0;
+        for (uint64_t tack : tacks) n_expected += (tack >= first && tack <= last);
+        CHECK(range.size() == n_expected);
+        bool matches = true;
+        for (size_t i = 0; i < range.size(); i++) {
+            if (tacks[range[i]] < first || tacks[range[i]] > last) matches = false;
+            if (i > 0 && tacks[range[i]] < tacks[range[i - 1]]) matches = false;
+        }
+        CHECK(matches);
+        CHECK(index.FindTACKRange(last, first).size() == (first == last ? n_expected : 0));
+        CHECK(index.FindTACKRange(0, UINT64_MAX).size() == n_events);
+    }
+
+    SUBCASE("FindEventID") {
+        bool matches = true;
+        for (size_t iev = 0; iev < n_events; iev++) {
+            auto found = index.FindEventID(event_ids[iev]);
+            if (!found || event_ids[*found] != event_ids[iev] || *found > iev) matches = false;
+        }
+        CHECK(matches);
+        CHECK(index.FindEventID(1314276426) == 0);
+        CHECK(index.FindEventIDRange(0, UINT32_MAX).size() == n_events);
+        auto range = index.FindEventIDRange(event_ids[1], event_ids[1]);
+        CHECK(std::find(range.begin(), range.end(), 1) != range.end());
+    }
+
+    SUBCASE("Sidecar") {
+        std::string sidecar_path = "test_TIOEventIndex.idx";
+        std::remove(sidecar_path.c_str());
+
+        TIOEventIndex created(reader, sidecar_path);
+        CHECK(!created.IsLoaded());
+        TIOEventIndex loaded(reader, sidecar_path);
+        CHECK(loaded.IsLoaded());
+        CHECK(loaded.GetNEvents() == n_events);
+        bool matches = true;
+        for (size_t iev = 0; iev < n_events; iev++) {
+            if (loaded.FindTACK(tacks[iev]) != index.FindTACK(tacks[iev])) matches = false;
+            if (loaded.FindEventID(event_ids[iev]) != index.FindEventID(event_ids[iev]))
+                matches = false;
+        }
+        CHECK(matches);
+
+        // A sidecar for a different file is rebuilt
+        auto reader_r1 = TIOReader("../../share/sstcam/io/targetmodule_r1.tio");
+        TIOEventIndex rebuilt(reader_r1, sidecar_path);
+        CHECK(!rebuilt.IsLoaded());
+        CHECK(rebuilt.FindTACK(reader_r1.GetEventTACK(2)).has_value());
+
+        // A corrupt sidecar is rebuilt
+        std::ofstream(sidecar_path, std::ios::trunc) << "not an index";
+        CHECK(!TIOEventIndex(reader, sidecar_path).IsLoaded());
+        CHECK(TIOEventIndex(reader, sidecar_path).IsLoaded());
+
+        CHECK_THROWS(index.Save("/not/a/dir/file.idx"));
+        std::remove(sidecar_path.c_str());
+    }
+}
+
+}
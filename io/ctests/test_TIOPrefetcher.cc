@@ -0,0 +1,75 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOPrefetcher.h"
+#include "doctest.h"
+#include <fstream>
+
+namespace sstcam::io {
+
+TEST_CASE("TIOPrefetcher") {
+    std::string path = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::ifstream file(path);
+    REQUIRE(file.good());
+    file.close();
+
+    auto reader = TIOReader(path);
+
+    // The reader must not be used while a prefetcher is reading from it, so
+    // the expected values are obtained from a second reader
+    auto expected_reader = TIOReader(path);
+
+    SUBCASE("Sequential order") {
+        TIOPrefetcherR0 prefetcher(reader, 3);
+        CHECK(prefetcher.GetDepth() == 3);
+        size_t n_events = 0;
+        bool matches = true;
+        while (const WaveformEventR0* event = prefetcher.Next()) {
+            if (event->GetIndex() != n_events) matches = false;
+            if (event->GetTACK() != expected_reader.GetEventTACK(n_events)) matches = false;
+            n_events++;
+        }
+        CHECK(matches);
+        CHECK(n_events == reader.GetNEvents());
+        CHECK(prefetcher.Next() == nullptr);
+    }
+
+    SUBCASE("Range") {
+        TIOPrefetcherR0 prefetcher(reader, 1, 2, 3);
+        CHECK(prefetcher.Next()->GetIndex() == 2);
+        CHECK(prefetcher.Next()->GetIndex() == 3);
+        CHECK(prefetcher.Next()->GetIndex() == 4);
+        CHECK(prefetcher.Next() == nullptr);
+    }
+
+    SUBCASE("Beyond end of file") {
+        TIOPrefetcherR0 prefetcher(reader, 4, reader.GetNEvents() + 1);
+        CHECK(prefetcher.Next() == nullptr);
+    }
+
+    SUBCASE("Samples") {
+        TIOPrefetcherR0 prefetcher(reader, 2);
+        const WaveformEventR0* event = prefetcher.Next();
+        REQUIRE(event);
+        CHECK(event->GetWaveformSamplesVector() == expected_reader.GetEventR0(0).GetWaveformSamplesVector());
+    }
+
+    SUBCASE("Early destruction") {
+        auto prefetcher = std::make_unique<TIOPrefetcherR0>(reader, 2);
+        CHECK(prefetcher->Next() != nullptr);
+        prefetcher.reset();
+        CHECK(reader.GetEventR0(0).GetIndex() == 0);
+    }
+
+    SUBCASE("Reader closed") {
+        // The worker is waiting for the ring slot held by the consumer
+        TIOPrefetcherR0 prefetcher(reader, 1);
+        CHECK(prefetcher.Next()->GetIndex() == 0);
+        reader.Close();
+        CHECK_THROWS_AS(prefetcher.Next(), std::runtime_error);
+        CHECK_THROWS_AS(reader.GetEventR0(0), std::runtime_error);
+        CHECK_THROWS_AS(reader.GetEventTACK(0), std::runtime_error);
+    }
+}
+
+}
@@ -5,6 +5,8 @@
 #include "sstcam/descriptions/WaveformEvent.h"
 #include "doctest.h"
 #include <fstream>
+#include <atomic>
+#include <thread>
 
 namespace sstcam::io {
 
@@ -55,6 +57,8 @@ TEST_CASE("TIOReader") {
 
         CHECK(reader_camera_r1.IsR1());
         CHECK(reader_camera_r1.GetNPixels() == 2048);
+        CHECK(reader_camera_r1.GetScale() == 23.4f);
+        CHECK(reader_camera_r1.GetHeaderKeywords().at("RUNNUMBER") == "15639");
     }
 
     SUBCASE("TIOReader GetEventR0") {
@@ -72,6 +76,14 @@ TEST_CASE("TIOReader") {
         CHECK(event1.GetIndex() == 1);
         CHECK(event1.GetPackets() == event1.GetPackets());
         CHECK(event1.GetPackets() != event0.GetPackets());
+
+        // Events share the decode plan built from the first event
+        REQUIRE(event0.GetDecodePlan());
+        CHECK(event0.GetDecodePlan() == event1.GetDecodePlan());
+        CHECK(event1.GetDecodePlan()->Matches(event1.GetPackets()));
+        WaveformEventR0 event1_no_plan = reader_tm_r0.GetEventR0(1);
+        event1_no_plan.SetDecodePlan(nullptr);
+        CHECK(event1_no_plan.GetWaveformSamplesVector() == event1.GetWaveformSamplesVector());
     }
 
     SUBCASE("TIOReader GetEventR1") {
@@ -91,6 +103,106 @@ TEST_CASE("TIOReader") {
         CHECK(event1.GetPackets() != event0.GetPackets());
     }
 
+    SUBCASE("TIOReader GetEventsR0") {
+        std::vector<WaveformEventR0> events = reader_tm_r0.GetEventsR0(2, 4);
+        REQUIRE(events.size() == 4);
+        bool matches = true;
+        for (size_t iev = 0; iev < events.size(); iev++) {
+            WaveformEventR0 event = reader_tm_r0.GetEventR0(2 + iev);
+            if (events[iev].GetIndex() != 2 + iev) matches = false;
+            if (events[iev].GetTACK() != event.GetTACK()) matches = false;
+            if (events[iev].GetCPUTimeNanosecond() != event.GetCPUTimeNanosecond()) matches = false;
+            if (events[iev].GetWaveformSamplesVector() != event.GetWaveformSamplesVector()) matches = false;
+        }
+        CHECK(matches);
+
+        // Packets of all events share a single slab
+        CHECK(events[1].GetPackets()[0] == events[0].GetPackets()[0] + reader_tm_r0.GetNPacketsPerEvent());
+
+        CHECK(reader_tm_r0.GetEventsR0(0, 0).empty());
+        CHECK_THROWS(reader_tm_r0.GetEventsR0(6, 4));
+    }
+
+    SUBCASE("TIOReader GetEventsR1 outlives reader") {
+        std::vector<WaveformEventR1> events;
+        {
+            auto reader = TIOReader(path_tm_r1);
+            events = reader.GetEventsR1(0, reader.GetNEvents());
+        }
+        CHECK(events.size() == 8);
+        CHECK(events[7].GetIndex() == 7);
+        CHECK(events[7].GetWaveformSamplesVector().size() == 64 * 128);
+    }
+
+    SUBCASE("TIOReader ReadEventR0") {
+        WaveformEventR0 event = reader_tm_r0.GetEventR0(0);
+        const auto* packets = &event.GetPackets();
+        reader_tm_r0.ReadEventR0(3, event);
+        WaveformEventR0 expected = reader_tm_r0.GetEventR0(3);
+        CHECK(&event.GetPackets() == packets);
+        CHECK(event.IsFilled());
+        CHECK(event.GetIndex() == 3);
+        CHECK(event.GetTACK() == expected.GetTACK());
+        CHECK(event.GetCPUTimeNanosecond() == expected.GetCPUTimeNanosecond());
+        CHECK(event.GetDecodePlan() == expected.GetDecodePlan());
+        CHECK(event.GetWaveformSamplesVector() == expected.GetWaveformSamplesVector());
+
+        CHECK_THROWS(reader_tm_r0.ReadEventR0(8, event));
+        WaveformEventR0 mismatched(reader_tm_r0.GetNPacketsPerEvent() + 1);
+        CHECK_THROWS(reader_tm_r0.ReadEventR0(0, mismatched));
+    }
+
+    SUBCASE("TIOReader memory map") {
+        auto reader = TIOReader(path_camera_r1, true);
+        REQUIRE(reader.IsMemoryMapped());
+        CHECK(!reader_camera_r1.IsMemoryMapped());
+        CHECK(reader.GetNEvents() == reader_camera_r1.GetNEvents());
+        CHECK(reader.GetNPixels() == reader_camera_r1.GetNPixels());
+
+        bool matches = true;
+        for (size_t iev = 0; iev < reader.GetNEvents(); iev++) {
+            WaveformEventR1 event = reader.GetEventR1(iev);
+            WaveformEventR1 event_cfitsio = reader_camera_r1.GetEventR1(iev);
+            if (event.GetTACK() != event_cfitsio.GetTACK()) matches = false;
+            if (event.GetCPUTimeSecond() != event_cfitsio.GetCPUTimeSecond()) matches = false;
+            if (event.GetWaveformSamplesVector() != event_cfitsio.GetWaveformSamplesVector()) matches = false;
+        }
+        CHECK(matches);
+
+        // Packets are views into the mapping, which outlives the reader
+        std::vector<WaveformEventR1> events = reader.GetEventsR1(0, reader.GetNEvents());
+        reader.Close();
+        CHECK(!reader.IsMemoryMapped());
+        CHECK(events[7].GetTACK() == reader_camera_r1.GetEventTACK(7));
+    }
+
+    SUBCASE("TIOReader concurrent access") {
+        for (bool memory_map : {false, true}) {
+            auto reader = TIOReader(path_camera_r1, memory_map);
+            size_t n_events = reader.GetNEvents();
+            std::vector<std::vector<float>> expected;
+            for (size_t iev = 0; iev < n_events; iev++) {
+                expected.push_back(reader_camera_r1.GetEventR1(iev).GetWaveformSamplesVector());
+            }
+
+            std::atomic<size_t> n_mismatch(0);
+            std::vector<std::thread> threads;
+            for (size_t ithread = 0; ithread < 8; ithread++) {
+                threads.emplace_back([&, ithread] {
+                    for (size_t i = 0; i < 4 * n_events; i++) {
+                        size_t iev = (i + ithread) % n_events;
+                        WaveformEventR1 event = reader.GetEventR1(iev);
+                        if (event.GetWaveformSamplesVector() != expected[iev]) n_mismatch++;
+                        if (reader.GetEventTACK(iev) != event.GetTACK()) n_mismatch++;
+                        if (!reader.IsR1()) n_mismatch++;
+                    }
+                });
+            }
+            for (auto& thread : threads) thread.join();
+            CHECK(n_mismatch == 0);
+        }
+    }
+
     SUBCASE("TIOReader Event-wise Getters") {
         CHECK(reader_tm_r0.GetEventID(0) == 1314276426);
         CHECK(reader_tm_r0.GetEventTACK(0) == 4426394938696);
@@ -105,6 +217,27 @@ TEST_CASE("TIOReader") {
         CHECK(reader_tm_r0.GetEventCPUNanosecond(5) == 516798324);
     }
 
+    SUBCASE("TIOReader Event Header Columns") {
+        const std::vector<uint32_t>& event_id = reader_tm_r0.GetEventIDColumn();
+        const std::vector<uint64_t>& tack = reader_tm_r0.GetEventTACKColumn();
+        const std::vector<uint16_t>& n_filled = reader_tm_r0.GetEventNPacketsFilledColumn();
+        const std::vector<int64_t>& cpu_s = reader_tm_r0.GetEventCPUSecondColumn();
+        const std::vector<int64_t>& cpu_ns = reader_tm_r0.GetEventCPUNanosecondColumn();
+        REQUIRE(tack.size() == reader_tm_r0.GetNEvents());
+        REQUIRE(event_id.size() == reader_tm_r0.GetNEvents());
+
+        CHECK(event_id[5] == 1314376427);
+        CHECK(tack[5] == 4426404938700);
+        CHECK(n_filled[5] == 64);
+        CHECK(cpu_s[5] == 1510245014);
+        CHECK(cpu_ns[5] == 516798324);
+
+        // Cached: the same vector is returned
+        CHECK(&reader_tm_r0.GetEventTACKColumn() == &tack);
+
+        CHECK_THROWS_AS(reader_tm_r0.GetEventTACK(reader_tm_r0.GetNEvents()), std::runtime_error);
+    }
+
     SUBCASE("TIOReader Event-wise TACK matches packets") {
         uint32_t event_index_0 = 0;
         uint64_t expected_tack_0 = reader_camera_r1.GetEventTACK(event_index_0);
@@ -0,0 +1,78 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIORunReader.h"
+#include "doctest.h"
+#include <fstream>
+
+namespace sstcam::io {
+
+TEST_CASE("TIORunReader") {
+    std::string path_tm_r0 = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::string path_tm_r1 = "../../share/sstcam/io/targetmodule_r1.tio";
+    std::string path_camera_r1 = "../../share/sstcam/io/chec_r1.tio";
+
+    std::ifstream file_tm_r0 (path_tm_r0);
+    REQUIRE(file_tm_r0.good());
+    file_tm_r0.close();
+
+    auto reader_tm_r0 = TIOReader(path_tm_r0);
+    size_t n_events = reader_tm_r0.GetNEvents();
+
+    SUBCASE("Concatenated") {
+        TIORunReader run({path_tm_r0, path_tm_r0, path_tm_r0});
+        CHECK(run.GetNFiles() == 3);
+        CHECK(run.GetNEvents() == 3 * n_events);
+        CHECK(run.GetNPixels() == reader_tm_r0.GetNPixels());
+        CHECK(run.GetNSamples() == reader_tm_r0.GetNSamples());
+        CHECK(!run.IsR1());
+        CHECK(!run.IsMergedByTACK());
+
+        auto location = run.GetEventLocation(n_events + 3);
+        CHECK(location.file_index == 1);
+        CHECK(location.event_index == 3);
+        CHECK(run.GetEventTACK(2 * n_events + 5) == reader_tm_r0.GetEventTACK(5));
+        WaveformEventR0 event = run.GetEventR0(n_events + 1);
+        CHECK(event.GetTACK() == reader_tm_r0.GetEventTACK(1));
+        CHECK(event.GetIndex() == n_events + 1);
+        CHECK_THROWS(run.GetEventLocation(3 * n_events));
+    }
+
+    SUBCASE("Merged by TACK") {
+        TIORunReader run({path_tm_r0, path_tm_r0}, true);
+        CHECK(run.IsMergedByTACK());
+        CHECK(run.GetNEvents() == 2 * n_events);
+        bool ordered = true;
+        for (size_t iev = 1; iev < run.GetNEvents(); iev++) {
+            if (run.GetEventTACK(iev) < run.GetEventTACK(iev - 1)) ordered = false;
+            if (run.GetEventR0(iev).GetTACK() != run.GetEventTACK(iev)) ordered = false;
+        }
+        CHECK(ordered);
+        // Equal TACKs keep the order of the files
+        auto first = run.GetEventLocation(0);
+        auto second = run.GetEventLocation(1);
+        CHECK(first.file_index == 0);
+        CHECK(second.file_index == 1);
+        CHECK(first.event_index == second.event_index);
+    }
+
+    SUBCASE("R1") {
+        TIORunReader run({path_tm_r1, path_tm_r1});
+        auto reader_tm_r1 = TIOReader(path_tm_r1);
+        CHECK(run.IsR1());
+        CHECK(run.GetScale() == reader_tm_r1.GetScale());
+        CHECK(run.GetOffset() == reader_tm_r1.GetOffset());
+        WaveformEventR1 event = run.GetEventR1(reader_tm_r1.GetNEvents());
+        CHECK(event.GetTACK() == reader_tm_r1.GetEventTACK(0));
+        CHECK(event.GetIndex() == reader_tm_r1.GetNEvents());
+    }
+
+    SUBCASE("Mismatched files") {
+        CHECK_THROWS(TIORunReader({path_tm_r0, path_tm_r1}));
+        CHECK_THROWS(TIORunReader({path_tm_r1, path_camera_r1}));
+        CHECK_THROWS(TIORunReader({path_tm_r0, "/not/a/file.tio"}));
+        CHECK_THROWS(TIORunReader(std::vector<std::string>{}));
+    }
+}
+
+}
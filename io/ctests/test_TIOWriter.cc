@@ -0,0 +1,129 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOWriter.h"
+#include "sstcam/io/TIOReader.h"
+#include "doctest.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace sstcam::io {
+
+// Check that the file written contains the same events as the source file
+void CheckCopy(const TIOReader& source, const TIOReader& copy) {
+    CHECK(copy.GetNEvents() == source.GetNEvents());
+    CHECK(copy.GetNPixels() == source.GetNPixels());
+    CHECK(copy.GetNSamples() == source.GetNSamples());
+    CHECK(copy.GetNPacketsPerEvent() == source.GetNPacketsPerEvent());
+    CHECK(copy.IsR1() == source.IsR1());
+    CHECK(copy.GetScale() == source.GetScale());
+    CHECK(copy.GetOffset() == source.GetOffset());
+    CHECK(copy.GetRunID() == source.GetRunID());
+    CHECK(copy.GetCameraVersion() == source.GetCameraVersion());
+
+    bool matches = true;
+    for (size_t iev = 0; iev < source.GetNEvents(); iev++) {
+        if (copy.GetEventID(iev) != source.GetEventID(iev)) matches = false;
+        if (copy.GetEventTACK(iev) != source.GetEventTACK(iev)) matches = false;
+        if (copy.GetEventNPacketsFilled(iev) != source.GetEventNPacketsFilled(iev)) matches = false;
+        if (copy.GetEventCPUSecond(iev) != source.GetEventCPUSecond(iev)) matches = false;
+        if (copy.GetEventCPUNanosecond(iev) != source.GetEventCPUNanosecond(iev)) matches = false;
+        auto source_packets = source.GetEventR0(iev).GetPackets();
+        auto copy_packets = copy.GetEventR0(iev).GetPackets();
+        for (size_t ipack = 0; ipack < source_packets.size(); ipack++) {
+            if (std::memcmp(copy_packets[ipack]->GetDataPacket(),
+                            source_packets[ipack]->GetDataPacket(),
+                            source_packets[ipack]->GetPacketSize()) != 0) matches = false;
+        }
+    }
+    CHECK(matches);
+}
+
+TEST_CASE("TIOWriter") {
+    std::string path_tm_r0 = "../../share/sstcam/io/targetmodule_r0.tio";
+    std::string path_tm_r1 = "../../share/sstcam/io/targetmodule_r1.tio";
+    std::string path_output = "test_TIOWriter.tio";
+
+    std::ifstream file_tm_r0 (path_tm_r0);
+    REQUIRE(file_tm_r0.good());
+    file_tm_r0.close();
+
+    auto reader_tm_r0 = TIOReader(path_tm_r0);
+    auto reader_tm_r1 = TIOReader(path_tm_r1);
+    size_t n_packets = reader_tm_r0.GetNPacketsPerEvent();
+    size_t packet_size = reader_tm_r0.GetEventR0(0).GetPackets()[0]->GetPacketSize();
+
+    SUBCASE("TIOWriter Constructor") {
+        TIOWriter writer(path_output, n_packets, packet_size);
+        CHECK(writer.IsOpen());
+        CHECK(writer.GetNEvents() == 0);
+        CHECK(writer.GetNPacketsPerEvent() == n_packets);
+        CHECK(writer.GetPacketSize() == packet_size);
+        writer.Close();
+        CHECK(!writer.IsOpen());
+        CHECK_THROWS(writer.Flush());
+    }
+
+    SUBCASE("TIOWriter invalid path") {
+        CHECK_THROWS(TIOWriter("/not/a/dir/file.tio", n_packets, packet_size));
+    }
+
+    SUBCASE("TIOWriter round trip") {
+        // Exercise preallocation, growth, trimming and partial buffers
+        for (size_t n_events_reserve : {0, 3, 100}) {
+            for (size_t n_events_buffer : {1, 3, 64}) {
+                for (const TIOReader* source : {&reader_tm_r0, &reader_tm_r1}) {
+                    {
+                        TIOWriter writer(path_output, n_packets, packet_size,
+                            source->IsR1(), source->GetScale(), source->GetOffset(),
+                            n_events_reserve, n_events_buffer);
+                        writer.AddHeaderKeyValue<int32_t, TINT>(
+                            "RUNNUMBER", source->GetRunID(), "Run number");
+                        writer.AddHeaderKeyValue<std::string, TSTRING>(
+                            "CAMERAVERSION", source->GetCameraVersion(), "Camera version");
+                        for (size_t iev = 0; iev < source->GetNEvents(); iev++) {
+                            writer.WriteEvent(source->GetEventR0(iev), source->GetEventID(iev));
+                        }
+                        CHECK(writer.GetNEvents() == source->GetNEvents());
+                    }
+                    CheckCopy(*source, TIOReader(path_output));
+                    CheckCopy(*source, TIOReader(path_output, true));
+                }
+            }
+        }
+    }
+
+    SUBCASE("TIOWriter mismatched event") {
+        {
+            TIOWriter writer(path_output, n_packets, packet_size + 2);
+            CHECK_THROWS(writer.WriteEvent(reader_tm_r0.GetEventR0(0), 0));
+        }
+        {
+            TIOWriter writer(path_output, n_packets + 1, packet_size);
+            CHECK_THROWS(writer.WriteEvent(reader_tm_r0.GetEventR0(0), 0));
+        }
+    }
+
+    SUBCASE("TIOWriter event IDs") {
+        // IDs unrelated to the TACKs are stored as given
+        {
+            TIOWriter writer(path_output, n_packets, packet_size);
+            for (size_t iev = 0; iev < reader_tm_r0.GetNEvents(); iev++) {
+                writer.WriteEvent(reader_tm_r0.GetEventR0(iev),
+                                  static_cast<uint32_t>(4000000000u - 3 * iev));
+            }
+        }
+        TIOReader copy(path_output);
+        bool matches = true;
+        for (size_t iev = 0; iev < copy.GetNEvents(); iev++) {
+            if (copy.GetEventID(iev) != 4000000000u - 3 * iev) matches = false;
+            if (copy.GetEventTACK(iev) != reader_tm_r0.GetEventTACK(iev)) matches = false;
+        }
+        CHECK(matches);
+    }
+
+    std::remove(path_output.c_str());
+}
+
+}
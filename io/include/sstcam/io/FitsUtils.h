@@ -5,6 +5,7 @@
 #define SSTCAM_IO_FITSUTILS_H_
 
 #include <string>
+#include <map>
 #include <iostream>
 #include <sstream>
 #include <fitsio.h>
@@ -22,6 +23,48 @@ long long int GetNRows(fitsfile* fits, int hdu_num);
 
 bool HasHeaderKey(fitsfile* fits, const std::string& key);
 
+// Keyword values of a header, by keyword name. String values are stored
+// without their quotes.
+using HeaderKeywords = std::map<std::string, std::string>;
+
+// Read all keywords of the current HDU header with a single cfitsio call.
+HeaderKeywords ReadHeaderKeywords(fitsfile* fits);
+
+// Convert a keyword value from a HeaderKeywords cache, following the
+// conversions of fits_read_key. Throws if a numeric (or bool) type is
+// requested for a value that is not T, F or a number.
+template <typename T>
+T GetKeywordValue(const HeaderKeywords& keywords, const std::string& key) {
+    auto it = keywords.find(key);
+    if (it == keywords.end()) {
+        std::ostringstream ss;
+        ss << "Cannot find the header keyword:" << key;
+        throw std::runtime_error(ss.str());
+    }
+    const std::string& value = it->second;
+
+    if constexpr(std::is_same<T, std::string>::value) {
+        return value;
+    } else {
+        if (value == "T") return static_cast<T>(1);
+        if (value == "F") return static_cast<T>(0);
+        try {
+            size_t n_parsed;
+            double number = std::stod(value, &n_parsed);
+            if (n_parsed != value.size()) throw std::invalid_argument(value);
+            if constexpr(std::is_same<T, bool>::value) {
+                return number != 0;
+            } else {
+                return static_cast<T>(number);
+            }
+        } catch (const std::logic_error&) {
+            std::ostringstream ss;
+            ss << "Cannot read the header keyword:" << key << " (value: " << value << ")";
+            throw std::runtime_error(ss.str());
+        }
+    }
+}
+
 template <typename T, int TFITS>
 T GetHeaderKeyValue(fitsfile* fits, const std::string& key) {
     if (fits == nullptr) throw std::runtime_error("FITS file is not open");
@@ -83,7 +126,11 @@ void AddHeaderKeyValue(fitsfile* fits, const std::string& key, T value, const st
         throw std::runtime_error(ss.str());
     }
 
-    if (fits_write_key(fits, TFITS, key.c_str(), &value, comment.c_str(), &status)) {
+    void* value_ptr = &value;
+    if constexpr(std::is_same<T, std::string>::value) {
+        value_ptr = const_cast<char*>(value.c_str());
+    }
+    if (fits_write_key(fits, TFITS, key.c_str(), value_ptr, comment.c_str(), &status)) {
         std::ostringstream ss;
         ss << "Cannot write the keyword: " << key << fitsutils::ErrorMessage(status);
         throw std::runtime_error(ss.str());
@@ -103,7 +150,11 @@ void UpdateHeaderKeyValue(fitsfile* fits, const std::string& key, T value, const
         throw std::runtime_error(ss.str());
     }
 
-    if (fits_update_key(fits, TFITS, key.c_str(), &value, comment.c_str(), &status)) {
+    void* value_ptr = &value;
+    if constexpr(std::is_same<T, std::string>::value) {
+        value_ptr = const_cast<char*>(value.c_str());
+    }
+    if (fits_update_key(fits, TFITS, key.c_str(), value_ptr, comment.c_str(), &status)) {
         std::ostringstream ss;
         ss << "Cannot update the keyword: " << key << fitsutils::ErrorMessage(status);
         throw std::runtime_error(ss.str());
@@ -0,0 +1,39 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_IO_MAPPEDFILE_H_
+#define SSTCAM_IO_MAPPEDFILE_H_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace sstcam::io {
+
+/*!
+ * @class MappedFile
+ * @brief Private (copy-on-write) memory mapping of an entire file. Pages are
+ * served directly from the page cache, and are only copied if written to.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Pointer to the start of the mapped file.
+    [[nodiscard]] inline uint8_t* GetData() const { return data_; }
+
+    // Size (bytes) of the mapped file.
+    [[nodiscard]] inline size_t GetSize() const { return size_; }
+
+private:
+    uint8_t* data_;
+    size_t size_;
+};
+
+}
+
+#endif //SSTCAM_IO_MAPPEDFILE_H_
@@ -0,0 +1,96 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_IO_TIOEVENTINDEX_H_
+#define SSTCAM_IO_TIOEVENTINDEX_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace sstcam::io {
+
+class TIOReader;
+
+/*!
+ * @class TIOEventIndex
+ * @brief Sorted index of the TACKs and event IDs of the events in a TIO file,
+ * for random access to events by TACK or event ID in O(log n).
+ * The index can be persisted to a sidecar file, so that it is only built once
+ * per file. Obtained from TIOReader::GetEventIndex.
+ */
+class TIOEventIndex {
+public:
+    /*!
+     * @param reader
+     * Reader of the file to index.
+     * @param sidecar_path
+     * Optional path of a sidecar file. If it exists and was created for the
+     * same file, the index is loaded from it. Otherwise the index is built
+     * from the event header columns and written to the sidecar file.
+     */
+    explicit TIOEventIndex(const TIOReader& reader, const std::string& sidecar_path="");
+
+    // Write the index to a sidecar file.
+    void Save(const std::string& sidecar_path) const;
+
+    // Number of events in the index.
+    [[nodiscard]] inline size_t GetNEvents() const { return tacks_.size(); }
+
+    // Was the index loaded from a sidecar file?
+    [[nodiscard]] inline bool IsLoaded() const { return loaded_; }
+
+    // Index of the event with the given TACK (the first event if several
+    // share the TACK).
+    [[nodiscard]] std::optional<size_t> FindTACK(uint64_t tack) const;
+
+    // Index of the event with the TACK closest to the given value (the
+    // earlier event if two are equally close).
+    [[nodiscard]] size_t FindNearestTACK(uint64_t tack) const;
+
+    // Indices of the events with first_tack <= TACK <= last_tack, in TACK order.
+    [[nodiscard]] std::vector<size_t> FindTACKRange(
+        uint64_t first_tack, uint64_t last_tack) const;
+
+    // Index of the event with the given event ID (the first event if several
+    // share the event ID).
+    [[nodiscard]] std::optional<size_t> FindEventID(uint32_t event_id) const;
+
+    // Indices of the events with first_id <= event ID <= last_id, in event ID order.
+    [[nodiscard]] std::vector<size_t> FindEventIDRange(
+        uint32_t first_id, uint32_t last_id) const;
+
+private:
+    // Identifies the indexed file, to reject stale sidecar files
+    struct Signature {
+        uint64_t n_events;
+        uint64_t file_size;
+        int64_t file_mtime;
+
+        bool operator==(const Signature& other) const {
+            return n_events == other.n_events && file_size == other.file_size &&
+                file_mtime == other.file_mtime;
+        }
+    };
+
+    Signature signature_;
+    bool loaded_;
+    std::vector<uint64_t> tacks_; // Sorted TACKs
+    std::vector<uint64_t> tack_events_; // Event index for each entry of tacks_
+    std::vector<uint32_t> event_ids_; // Sorted event IDs
+    std::vector<uint64_t> event_id_events_; // Event index for each entry of event_ids_
+
+    // Sort the keys, keeping the event index of each key.
+    template<typename T>
+    static void Sort(const std::vector<T>& column,
+        std::vector<T>& keys, std::vector<uint64_t>& events);
+
+    // Load the index from a sidecar file, if it matches the signature.
+    bool Load(const std::string& sidecar_path);
+};
+
+}
+
+#endif //SSTCAM_IO_TIOEVENTINDEX_H_
@@ -0,0 +1,162 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_IO_TIOPREFETCHER_H_
+#define SSTCAM_IO_TIOPREFETCHER_H_
+
+#include "sstcam/io/TIOReader.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace sstcam::io {
+
+/*!
+ * @class TIOPrefetcher
+ * @brief Sequential event iterator that reads ahead on a worker thread.
+ * Events are read into a bounded ring of WaveformEvent slots, which are
+ * recycled (reset and refilled) rather than reallocated, so that the I/O and
+ * decoding of the next events overlaps with the processing of the current
+ * one. The consumer only waits when it outruns the reader.
+ *
+ * The reader must outlive the prefetcher. If the reader is closed first, its
+ * Close waits for the read in progress, and Next then rethrows the error
+ * raised by the following read.
+ */
+template<typename TWaveformEvent>
+class TIOPrefetcher {
+public:
+    /*!
+     * @param reader
+     * The reader to obtain the events from.
+     * @param depth
+     * Number of events to read ahead (size of the ring).
+     * @param first_event_index
+     * Index of the first event to iterate over.
+     * @param n_events
+     * Number of events to iterate over (defaults to the rest of the file).
+     */
+    explicit TIOPrefetcher(const TIOReader& reader, size_t depth=8,
+            size_t first_event_index=0,
+            size_t n_events=std::numeric_limits<size_t>::max())
+        : reader_(reader),
+          ring_(std::max<size_t>(depth, 1),
+                TWaveformEvent(reader.GetNPacketsPerEvent(), reader.GetNPixels(),
+                    static_cast<uint8_t>(reader.GetFirstActiveModuleSlot()),
+                    0, 0, reader.GetScale(), reader.GetOffset())),
+          read_(0),
+          write_(0),
+          n_filled_(0),
+          holding_(false),
+          finished_(false),
+          stop_(false)
+    {
+        size_t n_available = first_event_index < reader.GetNEvents() ?
+            reader.GetNEvents() - first_event_index : 0;
+        size_t end = first_event_index + std::min(n_events, n_available);
+        worker_ = std::thread(&TIOPrefetcher::Run, this, first_event_index, end);
+    }
+
+    ~TIOPrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        not_full_.notify_all();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    TIOPrefetcher(const TIOPrefetcher&) = delete;
+    TIOPrefetcher& operator=(const TIOPrefetcher&) = delete;
+
+    // Number of events read ahead (size of the ring).
+    [[nodiscard]] inline size_t GetDepth() const { return ring_.size(); }
+
+    // Obtain the next event. The returned event is replaced by a later event
+    // on the following call, so copy it if it is needed for longer. Returns
+    // nullptr once all events have been consumed. Exceptions raised while
+    // reading are rethrown here.
+    const TWaveformEvent* Next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (holding_) { // Return the previous event to the ring
+            holding_ = false;
+            read_ = (read_ + 1) % ring_.size();
+            not_full_.notify_one();
+        }
+        not_empty_.wait(lock, [this] { return n_filled_ > 0 || finished_; });
+        if (n_filled_ == 0) {
+            if (error_) std::rethrow_exception(error_);
+            return nullptr;
+        }
+        n_filled_--;
+        holding_ = true;
+        return &ring_[read_];
+    }
+
+private:
+    const TIOReader& reader_;
+    std::vector<TWaveformEvent> ring_;
+    size_t read_;  // Ring position of the next event for the consumer
+    size_t write_; // Ring position of the next event for the worker
+    size_t n_filled_;
+    bool holding_;
+    bool finished_;
+    bool stop_;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::thread worker_;
+
+    void Run(size_t first_event_index, size_t end) {
+        for (size_t event_index = first_event_index; event_index < end; event_index++) {
+            size_t slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_full_.wait(lock, [this] {
+                    return stop_ || n_filled_ + holding_ < ring_.size();
+                });
+                if (stop_) break;
+                slot = write_;
+            }
+
+            try {
+                if constexpr (std::is_same_v<TWaveformEvent, WaveformEventR1>) {
+                    reader_.ReadEventR1(event_index, ring_[slot]);
+                } else {
+                    reader_.ReadEventR0(event_index, ring_[slot]);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                write_ = (write_ + 1) % ring_.size();
+                n_filled_++;
+            }
+            not_empty_.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+        }
+        not_empty_.notify_one();
+    }
+};
+
+using TIOPrefetcherR0 = TIOPrefetcher<WaveformEventR0>;
+using TIOPrefetcherR1 = TIOPrefetcher<WaveformEventR1>;
+
+}
+
+#endif //SSTCAM_IO_TIOPREFETCHER_H_
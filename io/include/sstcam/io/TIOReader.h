@@ -5,12 +5,19 @@
 #define SSTCAM_IO_TIOREADER_H_
 
 #include "sstcam/io/FitsUtils.h"
+#include "sstcam/io/MappedFile.h"
+#include "sstcam/io/TIOEventIndex.h"
 #include "sstcam/descriptions/WaveformDataPacket.h"
 #include "sstcam/descriptions/Waveform.h"
 #include "sstcam/descriptions/WaveformEvent.h"
 #include <set>
 #include <ostream>
 #include <variant>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 
 
 namespace sstcam::io {
@@ -24,18 +31,42 @@ using WaveformEventR1 = sstcam::descriptions::WaveformEventR1;
 /*!
  * @class TIOReader
  * @brief Reader for the TIO file format containing waveforms from the SST camera
+ *
+ * The const methods can be called concurrently from many threads. For
+ * uncompressed files, the event rows are read with position-independent
+ * reads (or directly from the memory mapping), so threads do not contend.
+ * The file headers are parsed when the file is opened. Access to cfitsio
+ * (header columns on first use, and event rows of compressed files) is
+ * serialised internally.
+ *
+ * Close waits for the reads in progress on other threads (e.g. a
+ * TIOPrefetcher) to finish, and later reads throw. It must not be called
+ * while the thread holds references returned by the column getters.
  */
 class TIOReader {
 public:
-    explicit TIOReader(const std::string& path);
+    /*!
+     * @param path
+     * Path to the TIO file.
+     * @param memory_map
+     * Memory map the file, so that the packets of an event are views directly
+     * into the mapping (no copy or allocation per packet). Only possible for
+     * uncompressed files on disk; otherwise the reader silently falls back to
+     * reading the rows into a buffer (see `IsMemoryMapped`).
+     */
+    explicit TIOReader(const std::string& path, bool memory_map=false);
     ~TIOReader() { Close(); }
 
-    // Close the file.
+    // Close the file, once the reads in progress on other threads have
+    // finished. Reads that are started afterwards throw.
     void Close();
 
     // Is the file open?
     [[nodiscard]] inline bool IsOpen() const { return fits_ != nullptr; }
 
+    // Are the events read directly from a memory mapping of the file?
+    [[nodiscard]] inline bool IsMemoryMapped() const { return mapping_ != nullptr; }
+
     // Path to the file if it is open.
     [[nodiscard]] inline std::string GetPath() const {
         return fits_ ? std::string(fits_->Fptr->filename) : "";
@@ -73,15 +104,20 @@ public:
         return active_modules_;
     }
 
+    // Keywords of the primary file header, parsed when the file is opened.
+    [[nodiscard]] inline const fitsutils::HeaderKeywords& GetHeaderKeywords() const {
+        return header_keywords_;
+    }
+
     // Run ID. Obtained from the file header.
     [[nodiscard]] uint32_t GetRunID() const;
 
     // Has waveform calibration (R1) already been applied to the waveform
     // samples? Obtained from the file header.
-    [[nodiscard]] bool IsR1() const;
+    [[nodiscard]] inline bool IsR1() const { return is_r1_; }
 
     // Version of the camera from the file header.
-    [[nodiscard]] std::string GetCameraVersion() const;
+    [[nodiscard]] inline std::string GetCameraVersion() const { return camera_version_; }
 
     // Obtain event ID for a particular event index from the event header.
     [[nodiscard]] uint32_t GetEventID(size_t event_index) const;
@@ -98,6 +134,30 @@ public:
     // Obtain CPU timestamp (nanoseconds) for a particular event from the event header.
     [[nodiscard]] int64_t GetEventCPUNanosecond(size_t event_index) const;
 
+    // Event header columns for all events in the file. Each column is read
+    // from the file in a single call on first use, and then cached. The
+    // returned references are invalidated by Close.
+
+    // Event IDs of all events.
+    [[nodiscard]] const std::vector<uint32_t>& GetEventIDColumn() const;
+
+    // TACKs of all events.
+    [[nodiscard]] const std::vector<uint64_t>& GetEventTACKColumn() const;
+
+    // Number of packets filled for all events.
+    [[nodiscard]] const std::vector<uint16_t>& GetEventNPacketsFilledColumn() const;
+
+    // CPU timestamps (seconds) of all events.
+    [[nodiscard]] const std::vector<int64_t>& GetEventCPUSecondColumn() const;
+
+    // CPU timestamps (nanoseconds) of all events.
+    [[nodiscard]] const std::vector<int64_t>& GetEventCPUNanosecondColumn() const;
+
+    // Index of the event TACKs and IDs, for finding events in O(log n). Built
+    // on first use, or loaded from (and saved to) the optional sidecar file.
+    [[nodiscard]] const TIOEventIndex& GetEventIndex(
+        const std::string& sidecar_path="") const;
+
     // Obtain an event (pre-waveform calibration formatted).
     [[nodiscard]] inline WaveformEventR0 GetEventR0(size_t event_index) const {
         return GetEvent<WaveformEventR0>(event_index);
@@ -108,6 +168,34 @@ public:
         return GetEvent<WaveformEventR1>(event_index);
     }
 
+    // Read an event into an existing event, which is reset and refilled so
+    // that its storage is reused. The event must describe the same packets
+    // and pixels as the events of the file (e.g. obtained from this reader).
+    inline void ReadEventR0(size_t event_index, WaveformEventR0& event) const {
+        ReadEvent(event_index, event);
+    }
+
+    // Read an event into an existing event (see ReadEventR0).
+    inline void ReadEventR1(size_t event_index, WaveformEventR1& event) const {
+        ReadEvent(event_index, event);
+    }
+
+    // Obtain a contiguous range of events (pre-waveform calibration formatted).
+    // The rows are read from the file in a single call into one memory slab,
+    // which is shared by the packets of the returned events.
+    [[nodiscard]] inline std::vector<WaveformEventR0> GetEventsR0(
+            size_t first_event_index, size_t n_events) const {
+        return GetEvents<WaveformEventR0>(first_event_index, n_events);
+    }
+
+    // Obtain a contiguous range of events (post-waveform calibration formatted).
+    // The rows are read from the file in a single call into one memory slab,
+    // which is shared by the packets of the returned events.
+    [[nodiscard]] inline std::vector<WaveformEventR1> GetEventsR1(
+            size_t first_event_index, size_t n_events) const {
+        return GetEvents<WaveformEventR1>(first_event_index, n_events);
+    }
+
 private:
     fitsfile* fits_;
     int32_t event_hdu_num_;
@@ -121,12 +209,119 @@ private:
     uint8_t first_active_module_slot_;
     float scale_;
     float offset_;
-
+    size_t row_size_;
+    size_t packet_offset_;
+    int fd_; // Descriptor for position-independent reads (-1 if unused)
+    size_t event_data_offset_; // Start of the EVENTS table within the file
+    std::shared_ptr<MappedFile> mapping_;
+    uint8_t* event_data_; // Start of the EVENTS table within mapping_
+    mutable std::mutex fits_mutex_; // Serialises all access to fits_
+    // Held shared by the reads, and exclusively by Close, so that the file is
+    // not closed under a read in progress on another thread
+    mutable std::shared_mutex close_mutex_;
+    fitsutils::HeaderKeywords header_keywords_;
+    bool is_r1_;
+    std::string camera_version_;
+    // Built from the first event, and shared by the events read from the file
+    std::shared_ptr<const sstcam::descriptions::WaveformDecodePlan> decode_plan_;
+
+    // Event header column, read from the file on first use. Once loaded, the
+    // column is read without locking.
+    template<typename T>
+    struct CachedColumn {
+        std::atomic<bool> loaded{false};
+        std::vector<T> values;
+
+        void Reset() {
+            loaded = false;
+            values = std::vector<T>();
+        }
+    };
+    mutable CachedColumn<uint32_t> event_id_column_;
+    mutable CachedColumn<uint64_t> event_tack_column_;
+    mutable CachedColumn<uint16_t> event_n_packets_filled_column_;
+    mutable CachedColumn<int64_t> event_cpu_second_column_;
+    mutable CachedColumn<int64_t> event_cpu_nanosecond_column_;
+    mutable std::unique_ptr<const TIOEventIndex> event_index_;
+    mutable std::mutex event_index_mutex_;
+
+    // Packets for a contiguous range of events, viewing a single memory slab
+    // (or the memory mapping). Events share ownership of the block through
+    // their packets.
+    struct EventBlock {
+        std::shared_ptr<uint8_t> slab;
+        std::vector<WaveformDataPacket> packets;
+    };
+
+    // Move to the EVENTS HDU. Requires fits_mutex_ to be held (or exclusive
+    // access during construction).
     void MoveToEventHDU() const;
 
-    // Read a WaveformDataPacket from the file.
-    [[nodiscard]] std::shared_ptr<WaveformDataPacket> ReadPacket(
-        size_t event_index, uint16_t packet_id) const;
+    // If the EVENTS table of the file on disk can be addressed directly,
+    // set up position-independent reads or the memory mapping.
+    void OpenDirectAccess(const std::string& path, bool memory_map);
+
+    // Read an entire event header column from the file. Requires fits_mutex_.
+    template<typename T, int TFITS>
+    [[nodiscard]] std::vector<T> ReadColumn(int column_num, const std::string& name) const;
+
+    // Obtain a cached event header column, reading it on first use.
+    template<typename T, typename TRead>
+    [[nodiscard]] const std::vector<T>& GetCachedColumn(
+        CachedColumn<T>& column, TRead read) const;
+
+    // Read the rows for a contiguous range of events into an EventBlock.
+    // Requires close_mutex_ to be held (or exclusive access during
+    // construction).
+    [[nodiscard]] std::shared_ptr<EventBlock> ReadEventBlock(
+        size_t first_event_index, size_t n_events) const;
+
+    // Fill an empty event with the packets of an event of an EventBlock.
+    inline void FillEvent(const std::shared_ptr<EventBlock>& block,
+            size_t first_event_index, size_t i_event, WaveformEvent& event) const {
+        size_t event_index = first_event_index + i_event;
+        event.SetCPUTime(GetEventCPUSecondColumn()[event_index],
+                         GetEventCPUNanosecondColumn()[event_index]);
+        event.SetIndex(event_index);
+        WaveformDataPacket* packets = &block->packets[i_event * n_packets_per_event_];
+        for (uint32_t ipack = 0; ipack < n_packets_per_event_; ipack++) {
+            // Aliasing constructor: the packet shares ownership of the block
+            event.AddPacketShared(std::shared_ptr<WaveformDataPacket>(
+                block, &packets[ipack]));
+        }
+        event.SetDecodePlan(decode_plan_);
+    }
+
+    // Template to define how events are built from an EventBlock.
+    template<typename TWaveformEvent>
+    [[nodiscard]] inline TWaveformEvent BuildEvent(
+            const std::shared_ptr<EventBlock>& block,
+            size_t first_event_index, size_t i_event) const {
+        TWaveformEvent event(
+            n_packets_per_event_,
+            n_pixels_, first_active_module_slot_,
+            0, 0, scale_, offset_);
+        FillEvent(block, first_event_index, i_event, event);
+        return event;
+    }
+
+    // Read an event of the file into an existing event.
+    template<typename TWaveformEvent>
+    inline void ReadEvent(size_t event_index, TWaveformEvent& event) const {
+        if (event_index >= GetNEvents())
+            throw std::runtime_error("Event index out of range");
+        if (event.GetPackets().size() != n_packets_per_event_ ||
+            event.GetNPixels() != n_pixels_ ||
+            event.GetFirstActiveModuleSlot() != first_active_module_slot_ ||
+            event.GetScale() != scale_ || event.GetOffset() != offset_) {
+            throw std::runtime_error("Event does not match the events of the file");
+        }
+
+        std::shared_lock<std::shared_mutex> lock(close_mutex_);
+        auto block = ReadEventBlock(event_index, 1);
+        event.Reset();
+        FillEvent(block, event_index, 0, event);
+    }
 
     // Template to define how events are read from the file.
     template<typename TWaveformEvent>
@@ -134,16 +329,28 @@ private:
         if (event_index >= GetNEvents())
             throw std::runtime_error("Event index out of range");
 
-        int64_t cpu_time_second = GetEventCPUSecond(event_index);
-        int64_t cpu_time_nanosecond = GetEventCPUNanosecond(event_index);
-        TWaveformEvent event(
-            n_packets_per_event_,
-            n_pixels_, first_active_module_slot_,
-            cpu_time_second, cpu_time_nanosecond, scale_, offset_, event_index);
-        for (uint32_t ipack = 0; ipack < n_packets_per_event_; ipack++) {
-            event.AddPacketShared(ReadPacket(event_index, ipack));
+        std::shared_lock<std::shared_mutex> lock(close_mutex_);
+        auto block = ReadEventBlock(event_index, 1);
+        return BuildEvent<TWaveformEvent>(block, event_index, 0);
+    }
+
+    // Template to define how a range of events are read from the file.
+    template<typename TWaveformEvent>
+    [[nodiscard]] inline std::vector<TWaveformEvent> GetEvents(
+            size_t first_event_index, size_t n_events) const {
+        if (first_event_index + n_events > GetNEvents())
+            throw std::runtime_error("Event index out of range");
+
+        std::vector<TWaveformEvent> events;
+        if (n_events == 0) return events;
+        events.reserve(n_events);
+        std::shared_lock<std::shared_mutex> lock(close_mutex_);
+        auto block = ReadEventBlock(first_event_index, n_events);
+        for (size_t iev = 0; iev < n_events; iev++) {
+            events.push_back(BuildEvent<TWaveformEvent>(
+                block, first_event_index, iev));
         }
-        return event;
+        return events;
     }
 };
 
@@ -0,0 +1,103 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_IO_TIORUNREADER_H_
+#define SSTCAM_IO_TIORUNREADER_H_
+
+#include "sstcam/io/TIOReader.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace sstcam::io {
+
+/*!
+ * @class TIORunReader
+ * @brief Reader for a run that is split across multiple TIO files.
+ * The files are opened in parallel, and are required to agree on the
+ * number of pixels, the number of samples, and the R1 calibration. The
+ * events of all files are presented with a single global event index.
+ */
+class TIORunReader {
+public:
+    // Location of an event within the files of the run
+    struct EventLocation {
+        size_t file_index;
+        size_t event_index;
+    };
+
+    /*!
+     * @param paths
+     * Paths to the TIO files of the run.
+     * @param merge_by_tack
+     * Order the global event index by TACK across all files. Otherwise the
+     * events are ordered by file, in the order of the paths.
+     * @param memory_map
+     * Memory map the files (see TIOReader).
+     */
+    explicit TIORunReader(const std::vector<std::string>& paths,
+        bool merge_by_tack=false, bool memory_map=false);
+
+    // Close all files.
+    void Close();
+
+    // Number of files in the run.
+    [[nodiscard]] inline size_t GetNFiles() const { return readers_.size(); }
+
+    // Reader for one of the files in the run.
+    [[nodiscard]] inline const TIOReader& GetReader(size_t file_index) const {
+        return *readers_.at(file_index);
+    }
+
+    // Total number of events in the run.
+    [[nodiscard]] inline size_t GetNEvents() const { return locations_.size(); }
+
+    // Number of camera pixels per event.
+    [[nodiscard]] inline size_t GetNPixels() const { return readers_[0]->GetNPixels(); }
+
+    // Number of samples for pixel waveform.
+    [[nodiscard]] inline size_t GetNSamples() const { return readers_[0]->GetNSamples(); }
+
+    // Has waveform calibration (R1) already been applied to the waveform samples?
+    [[nodiscard]] inline bool IsR1() const { return is_r1_; }
+
+    // Compression scale for the R1 waveform samples.
+    [[nodiscard]] inline float GetScale() const { return readers_[0]->GetScale(); }
+
+    // Compression offset for the R1 waveform samples.
+    [[nodiscard]] inline float GetOffset() const { return readers_[0]->GetOffset(); }
+
+    // Are the events ordered by TACK across the files?
+    [[nodiscard]] inline bool IsMergedByTACK() const { return merge_by_tack_; }
+
+    // File and local event index for a global event index.
+    [[nodiscard]] inline EventLocation GetEventLocation(size_t event_index) const {
+        if (event_index >= GetNEvents())
+            throw std::runtime_error("Event index out of range");
+        return locations_[event_index];
+    }
+
+    // Obtain TACK for a global event index.
+    [[nodiscard]] uint64_t GetEventTACK(size_t event_index) const;
+
+    // Obtain an event (pre-waveform calibration formatted) for a global event
+    // index. The index of the returned event is the global event index.
+    [[nodiscard]] WaveformEventR0 GetEventR0(size_t event_index) const;
+
+    // Obtain an event (post-waveform calibration formatted) for a global event index.
+    [[nodiscard]] WaveformEventR1 GetEventR1(size_t event_index) const;
+
+private:
+    std::vector<std::unique_ptr<TIOReader>> readers_;
+    std::vector<EventLocation> locations_;
+    bool merge_by_tack_;
+    bool is_r1_;
+
+    // Check that the files agree with the first file of the run.
+    void ValidateFiles() const;
+};
+
+}
+
+#endif //SSTCAM_IO_TIORUNREADER_H_
@@ -0,0 +1,109 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#ifndef SSTCAM_IO_TIOWRITER_H_
+#define SSTCAM_IO_TIOWRITER_H_
+
+#include "sstcam/io/FitsUtils.h"
+#include "sstcam/descriptions/WaveformDataPacket.h"
+#include "sstcam/descriptions/WaveformEvent.h"
+#include <string>
+#include <vector>
+
+
+namespace sstcam::io {
+
+constexpr int16_t TIO_EVENT_HEADER_VERSION = 2;
+
+/*!
+ * @class TIOWriter
+ * @brief Writer for the TIO file format containing waveforms from the SST camera.
+ * Events are encoded into whole table rows (event header columns and packet
+ * columns together) in a memory buffer, which is written to the file with a
+ * single call once full. Table rows are preallocated in large steps, and
+ * unused rows are removed when the file is closed.
+ */
+class TIOWriter {
+public:
+    /*!
+     * @param path
+     * Path of the file to create (an existing file is overwritten).
+     * @param n_packets_per_event
+     * Number of WaveformDataPackets per event.
+     * @param packet_size
+     * Size (bytes) of each WaveformDataPacket.
+     * @param is_r1
+     * Are the waveform samples R1 (post-waveform calibration)?
+     * @param scale
+     * The scaling applied to the R1 samples to store them as uint16_t.
+     * @param offset
+     * The offset applied to the R1 samples to store them as uint16_t.
+     * @param n_events_reserve
+     * Number of rows to preallocate in the table (e.g. the expected number
+     * of events in the file).
+     * @param n_events_buffer
+     * Number of events buffered in memory before they are written to file.
+     */
+    TIOWriter(const std::string& path,
+              size_t n_packets_per_event, size_t packet_size,
+              bool is_r1=false, float scale=1., float offset=0.,
+              size_t n_events_reserve=0, size_t n_events_buffer=64);
+    ~TIOWriter();
+
+    TIOWriter(const TIOWriter&) = delete;
+    TIOWriter& operator=(const TIOWriter&) = delete;
+
+    // Write the buffered events, remove unused preallocated rows, and
+    // close the file.
+    void Close();
+
+    // Is the file open?
+    [[nodiscard]] inline bool IsOpen() const { return fits_ != nullptr; }
+
+    // Number of events written (including those still buffered).
+    [[nodiscard]] inline size_t GetNEvents() const {
+        return n_events_flushed_ + n_events_buffered_;
+    }
+
+    // Number of WaveformDataPackets per event.
+    [[nodiscard]] inline size_t GetNPacketsPerEvent() const {
+        return n_packets_per_event_;
+    }
+
+    // Size (bytes) of each WaveformDataPacket.
+    [[nodiscard]] inline size_t GetPacketSize() const { return packet_size_; }
+
+    // Add a keyword to the primary header (e.g. RUNNUMBER, CAMERAVERSION).
+    template<typename T, int TFITS>
+    void AddHeaderKeyValue(const std::string& key, T value, const std::string& comment) {
+        if (!IsOpen()) throw std::runtime_error("File is not open");
+        fitsutils::AddHeaderKeyValue<T, TFITS>(fits_, key, value, comment);
+        MoveToEventHDU();
+    }
+
+    // Append an event to the file, with the event ID to store in its event
+    // header (e.g. TIOReader::GetEventID of the source file). Missing packets
+    // are written as zeros.
+    void WriteEvent(const descriptions::WaveformEvent& event, uint32_t event_id);
+
+    // Write the buffered events to the file.
+    void Flush();
+
+private:
+    fitsfile* fits_;
+    int event_hdu_num_;
+    size_t n_packets_per_event_;
+    size_t packet_size_;
+    size_t row_size_;
+    size_t n_rows_allocated_;
+    size_t n_events_flushed_;
+    size_t n_events_buffered_;
+    size_t n_events_buffer_;
+    std::vector<uint8_t> buffer_;
+
+    void MoveToEventHDU() const;
+};
+
+}
+
+#endif //SSTCAM_IO_TIOWRITER_H_
@@ -2,8 +2,12 @@
 // This software is distributed under the terms of the BSD-3-Clause license.
 
 #include "sstcam/io/TIOReader.h"
+#include "sstcam/io/TIOPrefetcher.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/operators.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <optional>
 
 namespace py = pybind11;
 
@@ -14,10 +18,40 @@ using WaveformEventR0 = sstcam::descriptions::WaveformEventR0;
 using WaveformEventR1 = sstcam::descriptions::WaveformEventR1;
 
 
+// Read an event without holding the GIL, so that python threads can read
+// events concurrently
+template<typename TResult, typename TRead>
+py::object ReadWithoutGIL(TRead read) {
+    std::optional<TResult> result;
+    {
+        py::gil_scoped_release release;
+        result.emplace(read());
+    }
+    return py::cast(std::move(*result));
+}
+
 // Obtain the correct WaveformEvent subclass based on the file type
 py::object GetEvent(const TIOReader& reader, uint32_t event_index) {
-    if (reader.IsR1()) return py::cast(reader.GetEventR1(event_index));
-    else return py::cast(reader.GetEventR0(event_index));
+    if (reader.IsR1()) return ReadWithoutGIL<WaveformEventR1>(
+        [&] { return reader.GetEventR1(event_index); });
+    else return ReadWithoutGIL<WaveformEventR0>(
+        [&] { return reader.GetEventR0(event_index); });
+}
+
+// Obtain a range of events as the correct WaveformEvent subclass
+py::object GetEvents(const TIOReader& reader, size_t first_event_index, size_t n_events) {
+    if (reader.IsR1()) return ReadWithoutGIL<std::vector<WaveformEventR1>>(
+        [&] { return reader.GetEventsR1(first_event_index, n_events); });
+    else return ReadWithoutGIL<std::vector<WaveformEventR0>>(
+        [&] { return reader.GetEventsR0(first_event_index, n_events); });
+}
+
+// Copy a cached event header column into a numpy array. The cache is freed
+// when the reader is closed, so the array must own its data.
+template<typename T, const std::vector<T>& (TIOReader::*TGetColumn)() const>
+py::array_t<T> GetColumn(const TIOReader& reader) {
+    const std::vector<T>& column = (reader.*TGetColumn)();
+    return py::array_t<T>(column.size(), column.data());
 }
 
 class TIOIter {
@@ -37,6 +71,29 @@ public:
     }
 };
 
+template<typename TWaveformEvent>
+void tio_prefetcher(py::module &m, const char* name) {
+    using Prefetcher = TIOPrefetcher<TWaveformEvent>;
+    py::class_<Prefetcher> prefetcher(m, name);
+    prefetcher.def_property_readonly("depth", &Prefetcher::GetDepth);
+    prefetcher.def("__iter__", [](Prefetcher& p) -> Prefetcher& { return p; });
+    prefetcher.def("__next__", [](Prefetcher& p) {
+        const TWaveformEvent* event;
+        {
+            py::gil_scoped_release release;
+            event = p.Next();
+        }
+        if (!event) throw py::stop_iteration();
+        return *event; // Copy, as the ring slot is recycled
+    });
+}
+
+// Obtain the correct TIOPrefetcher subclass based on the file type
+py::object Prefetch(const TIOReader& reader, size_t depth) {
+    if (reader.IsR1()) return py::cast(std::make_unique<TIOPrefetcherR1>(reader, depth));
+    else return py::cast(std::make_unique<TIOPrefetcherR0>(reader, depth));
+}
+
 std::string ReaderInfo(const TIOReader& reader) {
     std::stringstream ss;
     ss << "path: " << reader.GetPath() << std::endl;
@@ -54,11 +111,30 @@ std::string ReaderInfo(const TIOReader& reader) {
 }
 
 void tio_reader(py::module &m) {
+    tio_prefetcher<WaveformEventR0>(m, "TIOPrefetcherR0");
+    tio_prefetcher<WaveformEventR1>(m, "TIOPrefetcherR1");
+
+    py::class_<TIOEventIndex> tio_event_index(m, "TIOEventIndex");
+    tio_event_index.def_property_readonly("n_events", &TIOEventIndex::GetNEvents);
+    tio_event_index.def_property_readonly("is_loaded", &TIOEventIndex::IsLoaded);
+    tio_event_index.def("save", &TIOEventIndex::Save, py::arg("sidecar_path"));
+    tio_event_index.def("find_tack", &TIOEventIndex::FindTACK, py::arg("tack"));
+    tio_event_index.def("find_nearest_tack", &TIOEventIndex::FindNearestTACK, py::arg("tack"));
+    tio_event_index.def("find_tack_range", &TIOEventIndex::FindTACKRange,
+        py::arg("first_tack"), py::arg("last_tack"));
+    tio_event_index.def("find_event_id", &TIOEventIndex::FindEventID, py::arg("event_id"));
+    tio_event_index.def("find_event_id_range", &TIOEventIndex::FindEventIDRange,
+        py::arg("first_id"), py::arg("last_id"));
+
     py::class_<TIOReader> tio_reader(m, "TIOReader");
     py::module::import("sstcam.descriptions"); // Require the WaveformEvent wrappings
-    tio_reader.def(py::init<std::string>());
-    tio_reader.def("close", &TIOReader::Close);
+    tio_reader.def(py::init<std::string, bool>(),
+        py::arg("path"), py::arg("memory_map")=false);
+    // Close waits for the reads of other threads (e.g. a prefetcher)
+    tio_reader.def("close", &TIOReader::Close,
+        py::call_guard<py::gil_scoped_release>());
     tio_reader.def_property_readonly("is_open", &TIOReader::IsOpen);
+    tio_reader.def_property_readonly("is_memory_mapped", &TIOReader::IsMemoryMapped);
     tio_reader.def_property_readonly("path", &TIOReader::GetPath);
     tio_reader.def_property_readonly("scale", &TIOReader::GetScale);
     tio_reader.def_property_readonly("offset", &TIOReader::GetOffset);
@@ -70,11 +146,28 @@ void tio_reader(py::module &m) {
     tio_reader.def_property_readonly("run_id", &TIOReader::GetRunID);
     tio_reader.def_property_readonly("is_r1", &TIOReader::IsR1);
     tio_reader.def_property_readonly("camera_version", &TIOReader::GetCameraVersion);
+    tio_reader.def_property_readonly("event_ids",
+        GetColumn<uint32_t, &TIOReader::GetEventIDColumn>);
+    tio_reader.def_property_readonly("event_tacks",
+        GetColumn<uint64_t, &TIOReader::GetEventTACKColumn>);
+    tio_reader.def_property_readonly("event_n_packets_filled",
+        GetColumn<uint16_t, &TIOReader::GetEventNPacketsFilledColumn>);
+    tio_reader.def_property_readonly("event_cpu_sec",
+        GetColumn<int64_t, &TIOReader::GetEventCPUSecondColumn>);
+    tio_reader.def_property_readonly("event_cpu_ns",
+        GetColumn<int64_t, &TIOReader::GetEventCPUNanosecondColumn>);
     tio_reader.def("__str__", ReaderInfo);
     tio_reader.def("__getitem__", [](const TIOReader& reader, int64_t event_index) {
         if (event_index < 0) event_index += reader.GetNEvents();
         return GetEvent(reader, static_cast<uint32_t>(event_index));
     });
+    tio_reader.def("get_events", GetEvents,
+        py::arg("first_event_index"), py::arg("n_events"));
+    tio_reader.def("get_event_index", &TIOReader::GetEventIndex,
+        py::arg("sidecar_path")="", py::return_value_policy::reference_internal,
+        py::call_guard<py::gil_scoped_release>());
+    tio_reader.def("prefetch", Prefetch, py::arg("depth")=8,
+        py::keep_alive<0, 1>());
     tio_reader.def("__len__", [](const TIOReader& reader) {
         return reader.GetNEvents();
     });
@@ -89,6 +182,7 @@ void tio_reader(py::module &m) {
         (void)exc_type;
         (void)exc_val;
         (void)exc_tb;
+        py::gil_scoped_release release;
         reader->Close();
     });
 }
@@ -0,0 +1,74 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIORunReader.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <optional>
+
+namespace sstcam::io {
+
+namespace py = pybind11;
+
+// Obtain the correct WaveformEvent subclass based on the file type
+py::object GetRunEvent(const TIORunReader& reader, int64_t event_index) {
+    if (event_index < 0) event_index += reader.GetNEvents();
+    if (reader.IsR1()) {
+        std::optional<WaveformEventR1> event;
+        {
+            py::gil_scoped_release release;
+            event.emplace(reader.GetEventR1(event_index));
+        }
+        return py::cast(std::move(*event));
+    } else {
+        std::optional<WaveformEventR0> event;
+        {
+            py::gil_scoped_release release;
+            event.emplace(reader.GetEventR0(event_index));
+        }
+        return py::cast(std::move(*event));
+    }
+}
+
+void tio_run_reader(py::module &m) {
+    py::class_<TIORunReader> tio_run_reader(m, "TIORunReader");
+    py::module::import("sstcam.descriptions"); // Require the WaveformEvent wrappings
+    tio_run_reader.def(py::init<std::vector<std::string>, bool, bool>(),
+        py::arg("paths"), py::arg("merge_by_tack")=false, py::arg("memory_map")=false,
+        py::call_guard<py::gil_scoped_release>());
+    tio_run_reader.def("close", &TIORunReader::Close);
+    tio_run_reader.def_property_readonly("n_files", &TIORunReader::GetNFiles);
+    tio_run_reader.def_property_readonly("n_events", &TIORunReader::GetNEvents);
+    tio_run_reader.def_property_readonly("n_pixels", &TIORunReader::GetNPixels);
+    tio_run_reader.def_property_readonly("n_samples", &TIORunReader::GetNSamples);
+    tio_run_reader.def_property_readonly("is_r1", &TIORunReader::IsR1);
+    tio_run_reader.def_property_readonly("scale", &TIORunReader::GetScale);
+    tio_run_reader.def_property_readonly("offset", &TIORunReader::GetOffset);
+    tio_run_reader.def_property_readonly("is_merged_by_tack", &TIORunReader::IsMergedByTACK);
+    tio_run_reader.def("get_reader", &TIORunReader::GetReader,
+        py::arg("file_index"), py::return_value_policy::reference_internal);
+    tio_run_reader.def("get_event_location", [](const TIORunReader& reader, size_t event_index) {
+        auto location = reader.GetEventLocation(event_index);
+        return py::make_tuple(location.file_index, location.event_index);
+    }, py::arg("event_index"));
+    tio_run_reader.def("get_event_tack", &TIORunReader::GetEventTACK, py::arg("event_index"));
+    tio_run_reader.def("__getitem__", GetRunEvent);
+    tio_run_reader.def("__len__", &TIORunReader::GetNEvents);
+    tio_run_reader.def("__iter__", [](py::object& reader) {
+        // Lazily obtain each event in order of the global event index
+        py::module builtins = py::module::import("builtins");
+        return builtins.attr("map")(reader.attr("__getitem__"),
+            builtins.attr("range")(reader.attr("n_events")));
+    });
+    tio_run_reader.def("__enter__", [&](TIORunReader* reader) {
+        return reader;
+    });
+    tio_run_reader.def("__exit__", [&](TIORunReader* reader, py::object& exc_type, py::object& exc_val, py::object& exc_tb) {
+        (void)exc_type;
+        (void)exc_val;
+        (void)exc_tb;
+        reader->Close();
+    });
+}
+
+}
@@ -0,0 +1,50 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOWriter.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace sstcam::io {
+
+namespace py = pybind11;
+
+void tio_writer(py::module &m) {
+    py::class_<TIOWriter> tio_writer(m, "TIOWriter");
+    py::module::import("sstcam.descriptions"); // Require the WaveformEvent wrappings
+    tio_writer.def(py::init<std::string, size_t, size_t, bool, float, float, size_t, size_t>(),
+        py::arg("path"), py::arg("n_packets_per_event"), py::arg("packet_size"),
+        py::arg("is_r1")=false, py::arg("scale")=1., py::arg("offset")=0.,
+        py::arg("n_events_reserve")=0, py::arg("n_events_buffer")=64);
+    tio_writer.def("close", &TIOWriter::Close);
+    tio_writer.def("flush", &TIOWriter::Flush);
+    tio_writer.def_property_readonly("is_open", &TIOWriter::IsOpen);
+    tio_writer.def_property_readonly("n_events", &TIOWriter::GetNEvents);
+    tio_writer.def_property_readonly("n_packets_per_event", &TIOWriter::GetNPacketsPerEvent);
+    tio_writer.def_property_readonly("packet_size", &TIOWriter::GetPacketSize);
+    tio_writer.def("write_event", &TIOWriter::WriteEvent,
+        py::arg("event"), py::arg("event_id"),
+        py::call_guard<py::gil_scoped_release>());
+    // Overloads are tried in order, so bool must come before int
+    tio_writer.def("add_header_key", [](TIOWriter& writer,
+            const std::string& key, bool value, const std::string& comment) {
+        writer.AddHeaderKeyValue<int, TLOGICAL>(key, value ? 1 : 0, comment);
+    }, py::arg("key"), py::arg("value"), py::arg("comment")="");
+    tio_writer.def("add_header_key", &TIOWriter::AddHeaderKeyValue<int64_t, TLONGLONG>,
+        py::arg("key"), py::arg("value"), py::arg("comment")="");
+    tio_writer.def("add_header_key", &TIOWriter::AddHeaderKeyValue<double, TDOUBLE>,
+        py::arg("key"), py::arg("value"), py::arg("comment")="");
+    tio_writer.def("add_header_key", &TIOWriter::AddHeaderKeyValue<std::string, TSTRING>,
+        py::arg("key"), py::arg("value"), py::arg("comment")="");
+    tio_writer.def("__enter__", [&](TIOWriter* writer) {
+        return writer;
+    });
+    tio_writer.def("__exit__", [&](TIOWriter* writer, py::object& exc_type, py::object& exc_val, py::object& exc_tb) {
+        (void)exc_type;
+        (void)exc_val;
+        (void)exc_tb;
+        writer->Close();
+    });
+}
+
+}
@@ -10,10 +10,14 @@ namespace io {
 namespace py = pybind11;
 
 void tio_reader(py::module &m);
+void tio_writer(py::module &m);
+void tio_run_reader(py::module &m);
 
 PYBIND11_MODULE(sstcam_io, m) {
     m.def("_get_version",&getSSTCamCommonGitVersion);
     tio_reader(m);
+    tio_writer(m);
+    tio_run_reader(m);
 }
 
 }
@@ -114,6 +114,108 @@ def test_getitem(single_tm_r1):
     np.testing.assert_equal(samples_0, samples_1)
 
 
+def test_get_events(single_tm_r1):
+    events = single_tm_r1.get_events(2, 4)
+    assert len(events) == 4
+    for i, event in enumerate(events):
+        assert event.index == 2 + i
+        assert event.tack == single_tm_r1[2 + i].tack
+        np.testing.assert_equal(event.get_array(), single_tm_r1[2 + i].get_array())
+
+    with pytest.raises(RuntimeError):
+        single_tm_r1.get_events(6, 4)
+
+
+def test_memory_map(camera_r1):
+    with TIOReader("../share/sstcam/io/chec_r1.tio", memory_map=True) as reader:
+        assert reader.is_memory_mapped
+        assert not camera_r1.is_memory_mapped
+        for iev in range(reader.n_events):
+            event = reader[iev]
+            assert event.tack == camera_r1[iev].tack
+            np.testing.assert_equal(event.get_array(), camera_r1[iev].get_array())
+        events = reader.get_events(0, reader.n_events)
+    assert events[-1].tack == camera_r1[camera_r1.n_events - 1].tack
+
+
+def test_prefetch(single_tm_r0):
+    prefetcher = single_tm_r0.prefetch(depth=3)
+    assert prefetcher.depth == 3
+    events = list(prefetcher)
+    assert len(events) == single_tm_r0.n_events
+    for iev, event in enumerate(events):
+        assert event.index == iev
+        np.testing.assert_equal(event.get_array(), single_tm_r0[iev].get_array())
+
+
+def test_prefetch_after_close():
+    with TIOReader("../share/sstcam/io/targetmodule_r0.tio") as reader:
+        prefetcher = reader.prefetch(depth=1)
+        assert next(prefetcher).index == 0
+    with pytest.raises(RuntimeError):
+        next(prefetcher)
+
+
+def test_event_header_columns(single_tm_r0):
+    tacks = single_tm_r0.event_tacks
+    assert tacks.dtype == np.uint64
+    assert tacks.size == single_tm_r0.n_events
+    assert tacks[0] == 4426394938696
+    assert tacks[5] == 4426404938700
+    assert single_tm_r0.event_ids[5] == 1314376427
+    assert (single_tm_r0.event_n_packets_filled == 64).all()
+    assert single_tm_r0.event_cpu_sec[0] == 1510245014
+    assert single_tm_r0.event_cpu_ns[5] == 516798324
+    for iev, event in enumerate(single_tm_r0):
+        assert event.tack == tacks[iev]
+        assert event.cpu_ns == single_tm_r0.event_cpu_ns[iev]
+
+
+def test_event_header_columns_after_close():
+    reader = TIOReader("../share/sstcam/io/targetmodule_r0.tio")
+    tacks = reader.event_tacks
+    ids = reader.event_ids
+    assert tacks.flags.owndata
+    expected = tacks.copy()
+    reader.close()
+    np.testing.assert_array_equal(tacks, expected)
+    assert tacks[5] == 4426404938700
+    assert ids[5] == 1314376427
+
+
+
+def test_event_index(tmp_path, single_tm_r0):
+    index = single_tm_r0.get_event_index()
+    assert index.n_events == single_tm_r0.n_events
+    assert index.find_tack(4426394938696) == 0
+    assert index.find_tack(4426404938700) == 5
+    assert index.find_tack(0) is None
+    assert index.find_nearest_tack(4426404938700 + 1) == 5
+    assert index.find_event_id(1314376427) == 5
+    assert index.find_tack_range(0, 2**64 - 1) == sorted(
+        range(single_tm_r0.n_events), key=lambda i: single_tm_r0.event_tacks[i]
+    )
+    assert 5 in index.find_event_id_range(1314376427, 1314376427)
+
+    sidecar_path = str(tmp_path / "targetmodule_r0.idx")
+    with TIOReader("../share/sstcam/io/targetmodule_r0.tio") as reader:
+        assert not reader.get_event_index(sidecar_path).is_loaded
+    with TIOReader("../share/sstcam/io/targetmodule_r0.tio") as reader:
+        index = reader.get_event_index(sidecar_path)
+        assert index.is_loaded
+        assert index.find_tack(4426404938700) == 5
+
+
+def test_threads(camera_r1):
+    from concurrent.futures import ThreadPoolExecutor
+    expected = [camera_r1[iev].get_array() for iev in range(camera_r1.n_events)]
+    indices = list(range(camera_r1.n_events)) * 4
+    with ThreadPoolExecutor(max_workers=8) as executor:
+        arrays = list(executor.map(lambda iev: camera_r1[iev].get_array(), indices))
+    for iev, array in zip(indices, arrays):
+        np.testing.assert_equal(array, expected[iev])
+
+
 @pytest.fixture(params=["single_tm_r0", "single_tm_r1", "camera_r1"])
 def reader(request):
     return request.getfixturevalue(request.param)
@@ -0,0 +1,38 @@
+from sstcam.io import TIOReader, TIORunReader
+import numpy as np
+import pytest
+
+PATH_TM_R0 = "../share/sstcam/io/targetmodule_r0.tio"
+PATH_TM_R1 = "../share/sstcam/io/targetmodule_r1.tio"
+
+
+def test_concatenated():
+    reader = TIOReader(PATH_TM_R1)
+    with TIORunReader([PATH_TM_R1, PATH_TM_R1]) as run:
+        assert run.n_files == 2
+        assert run.n_events == len(run) == 2 * reader.n_events
+        assert run.n_pixels == reader.n_pixels
+        assert run.n_samples == reader.n_samples
+        assert run.is_r1
+        assert run.scale == reader.scale
+        assert run.offset == reader.offset
+        assert run.get_event_location(reader.n_events + 2) == (1, 2)
+        assert run.get_reader(1).n_events == reader.n_events
+        np.testing.assert_equal(
+            run[reader.n_events + 2].get_array(), reader[2].get_array()
+        )
+        assert run[reader.n_events + 2].index == reader.n_events + 2
+        tacks = [event.tack for event in run]
+        np.testing.assert_equal(tacks, np.tile(reader.event_tacks, 2))
+
+
+def test_merge_by_tack():
+    with TIORunReader([PATH_TM_R0, PATH_TM_R0], merge_by_tack=True) as run:
+        assert run.is_merged_by_tack
+        tacks = [run.get_event_tack(i) for i in range(run.n_events)]
+        assert tacks == sorted(tacks)
+
+
+def test_mismatched_files():
+    with pytest.raises(RuntimeError):
+        TIORunReader([PATH_TM_R0, PATH_TM_R1])
@@ -0,0 +1,64 @@
+from sstcam.io import TIOReader, TIOWriter
+import numpy as np
+import pytest
+
+
+@pytest.fixture(scope="module")
+def single_tm_r1():
+    return TIOReader("../share/sstcam/io/targetmodule_r1.tio")
+
+
+def test_write_read(tmp_path, single_tm_r1):
+    reader = single_tm_r1
+    path = str(tmp_path / "test_TIOWriter.tio")
+    packet_size = reader[0].packets[0].GetPacketSize()
+    with TIOWriter(
+        path,
+        reader.n_packets_per_event,
+        packet_size,
+        is_r1=True,
+        scale=reader.scale,
+        offset=reader.offset,
+        n_events_buffer=3,
+    ) as writer:
+        writer.add_header_key("RUNNUMBER", reader.run_id, "Run number")
+        writer.add_header_key("CAMERAVERSION", reader.camera_version)
+        for iev in range(reader.n_events):
+            writer.write_event(reader[iev], reader.event_ids[iev])
+        assert writer.n_events == reader.n_events
+    assert not writer.is_open
+
+    with TIOReader(path) as copy:
+        assert copy.n_events == reader.n_events
+        assert copy.is_r1
+        assert copy.run_id == reader.run_id
+        assert copy.camera_version == reader.camera_version
+        assert copy.scale == reader.scale
+        assert copy.offset == reader.offset
+        np.testing.assert_equal(copy.event_ids, reader.event_ids)
+        np.testing.assert_equal(copy.event_tacks, reader.event_tacks)
+        np.testing.assert_equal(copy.event_cpu_ns, reader.event_cpu_ns)
+        for iev in range(copy.n_events):
+            np.testing.assert_equal(copy[iev].get_array(), reader[iev].get_array())
+
+
+def test_mismatched_event(tmp_path, single_tm_r1):
+    path = str(tmp_path / "test_TIOWriter.tio")
+    n_packets = single_tm_r1.n_packets_per_event
+    packet_size = single_tm_r1[0].packets[0].GetPacketSize()
+    with TIOWriter(path, n_packets + 1, packet_size) as writer:
+        with pytest.raises(RuntimeError):
+            writer.write_event(single_tm_r1[0], 0)
+
+
+def test_event_ids(tmp_path, single_tm_r1):
+    path = str(tmp_path / "test_TIOWriter.tio")
+    n_packets = single_tm_r1.n_packets_per_event
+    packet_size = single_tm_r1[0].packets[0].GetPacketSize()
+    event_ids = 4000000000 - 3 * np.arange(single_tm_r1.n_events)
+    with TIOWriter(path, n_packets, packet_size) as writer:
+        for iev, event_id in enumerate(event_ids):
+            writer.write_event(single_tm_r1[iev], int(event_id))
+    with TIOReader(path) as copy:
+        np.testing.assert_equal(copy.event_ids, event_ids)
+        np.testing.assert_equal(copy.event_tacks, single_tm_r1.event_tacks)
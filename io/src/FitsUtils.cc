@@ -2,6 +2,7 @@
 // This software is distributed under the terms of the BSD-3-Clause license.
 
 #include "sstcam/io/FitsUtils.h"
+#include <cstring>
 
 namespace sstcam {
 namespace io {
@@ -58,4 +59,63 @@ bool HasHeaderKey(fitsfile* fits, const std::string& key) {
     return fits_read_keyword(fits, key.c_str(), keyvalue, comment, &status) == 0;
 }
 
+HeaderKeywords ReadHeaderKeywords(fitsfile* fits) {
+    if (fits == nullptr) throw std::runtime_error("FITS file is not open");
+
+    int status = 0;
+    char* header = nullptr;
+    int n_keys = 0;
+    if (fits_hdr2str(fits, 0, nullptr, 0, &header, &n_keys, &status)) {
+        std::ostringstream ss;
+        ss << "Cannot read the header" << ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+
+    // The header is a concatenation of 80 character cards
+    HeaderKeywords keywords;
+    char card[FLEN_CARD];
+    char value[FLEN_VALUE];
+    char comment[FLEN_COMMENT];
+    for (int i = 0; i < n_keys; i++) {
+        std::memcpy(card, &header[i * 80], 80);
+        card[80] = '\0';
+
+        // Keywords longer than 8 characters are written with the HIERARCH
+        // convention (e.g. "HIERARCH EVENT_HEADER_VERSION = 2")
+        std::string key;
+        if (std::strncmp(card, "HIERARCH ", 9) == 0) {
+            const char* equals = std::strchr(card, '=');
+            if (!equals) continue; // No value
+            key.assign(&card[9], static_cast<size_t>(equals - &card[9]));
+            key.erase(0, key.find_first_not_of(' '));
+        } else {
+            if (std::strncmp(&card[8], "= ", 2) != 0) continue; // No value
+            key.assign(card, 8);
+        }
+        key.erase(key.find_last_not_of(' ') + 1);
+
+        status = 0;
+        if (fits_parse_value(card, value, comment, &status)) continue;
+        std::string keyvalue(value);
+        if (!keyvalue.empty() && keyvalue[0] == '\'') {
+            // Remove the quotes, the trailing spaces, and unescape quotes
+            std::string unquoted;
+            for (size_t j = 1; j < keyvalue.size(); j++) {
+                if (keyvalue[j] == '\'') {
+                    if (j + 1 < keyvalue.size() && keyvalue[j + 1] == '\'') j++;
+                    else break;
+                }
+                unquoted += keyvalue[j];
+            }
+            unquoted.erase(unquoted.find_last_not_of(' ') + 1);
+            keyvalue = unquoted;
+        }
+        keywords.emplace(key, keyvalue);
+    }
+
+    status = 0;
+    fits_free_memory(header, &status);
+    return keywords;
+}
+
 }}}
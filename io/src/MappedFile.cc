@@ -0,0 +1,50 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/MappedFile.h"
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sstcam::io {
+
+MappedFile::MappedFile(const std::string& path)
+    : data_(nullptr),
+      size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::ostringstream ss;
+        ss << "Cannot open: " << path << " (" << std::strerror(errno) << ")";
+        throw std::runtime_error(ss.str());
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        std::ostringstream ss;
+        ss << "Cannot map: " << path << " (not a regular non-empty file)";
+        throw std::runtime_error(ss.str());
+    }
+    size_ = static_cast<size_t>(st.st_size);
+
+    void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping remains valid after the descriptor is closed
+    if (data == MAP_FAILED) {
+        std::ostringstream ss;
+        ss << "Cannot map: " << path << " (" << std::strerror(errno) << ")";
+        throw std::runtime_error(ss.str());
+    }
+    data_ = static_cast<uint8_t*>(data);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) munmap(data_, size_);
+}
+
+}
@@ -0,0 +1,161 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOEventIndex.h"
+#include "sstcam/io/TIOReader.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sys/stat.h>
+
+namespace sstcam::io {
+
+namespace {
+
+constexpr char SIDECAR_MAGIC[8] = {'T', 'I', 'O', 'I', 'D', 'X', '0', '1'};
+
+template<typename T>
+void WriteVector(std::ofstream& file, const std::vector<T>& vector) {
+    file.write(reinterpret_cast<const char*>(vector.data()),
+        static_cast<std::streamsize>(vector.size() * sizeof(T)));
+}
+
+template<typename T>
+void ReadVector(std::ifstream& file, std::vector<T>& vector, size_t size) {
+    vector.resize(size);
+    file.read(reinterpret_cast<char*>(vector.data()),
+        static_cast<std::streamsize>(size * sizeof(T)));
+}
+
+}
+
+TIOEventIndex::TIOEventIndex(const TIOReader& reader, const std::string& sidecar_path)
+    : signature_{reader.GetNEvents(), 0, 0},
+      loaded_(false)
+{
+    struct stat file_stat{};
+    if (stat(reader.GetPath().c_str(), &file_stat) == 0) {
+        signature_.file_size = static_cast<uint64_t>(file_stat.st_size);
+        signature_.file_mtime = static_cast<int64_t>(file_stat.st_mtime);
+    }
+
+    if (!sidecar_path.empty() && Load(sidecar_path)) {
+        loaded_ = true;
+        return;
+    }
+
+    Sort(reader.GetEventTACKColumn(), tacks_, tack_events_);
+    Sort(reader.GetEventIDColumn(), event_ids_, event_id_events_);
+
+    if (!sidecar_path.empty()) Save(sidecar_path);
+}
+
+template<typename T>
+void TIOEventIndex::Sort(const std::vector<T>& column,
+        std::vector<T>& keys, std::vector<uint64_t>& events) {
+    events.resize(column.size());
+    std::iota(events.begin(), events.end(), 0);
+
+    // Events are usually already in TACK order, so only sort when needed
+    if (!std::is_sorted(column.begin(), column.end())) {
+        std::stable_sort(events.begin(), events.end(),
+            [&column](uint64_t a, uint64_t b) { return column[a] < column[b]; });
+    }
+
+    keys.resize(column.size());
+    for (size_t i = 0; i < column.size(); i++) keys[i] = column[events[i]];
+}
+
+void TIOEventIndex::Save(const std::string& sidecar_path) const {
+    std::ofstream file(sidecar_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::ostringstream ss;
+        ss << "Cannot create the event index file: " << sidecar_path;
+        throw std::runtime_error(ss.str());
+    }
+    file.write(SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    file.write(reinterpret_cast<const char*>(&signature_), sizeof(signature_));
+    WriteVector(file, tacks_);
+    WriteVector(file, tack_events_);
+    WriteVector(file, event_ids_);
+    WriteVector(file, event_id_events_);
+    if (!file) {
+        std::ostringstream ss;
+        ss << "Cannot write the event index file: " << sidecar_path;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+bool TIOEventIndex::Load(const std::string& sidecar_path) {
+    std::ifstream file(sidecar_path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[sizeof(SIDECAR_MAGIC)];
+    Signature signature{};
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&signature), sizeof(signature));
+    if (!file || std::memcmp(magic, SIDECAR_MAGIC, sizeof(magic)) != 0 ||
+        !(signature == signature_)) return false;
+
+    size_t n_events = signature.n_events;
+    ReadVector(file, tacks_, n_events);
+    ReadVector(file, tack_events_, n_events);
+    ReadVector(file, event_ids_, n_events);
+    ReadVector(file, event_id_events_, n_events);
+    if (!file) { // Truncated file
+        tacks_.clear();
+        tack_events_.clear();
+        event_ids_.clear();
+        event_id_events_.clear();
+        return false;
+    }
+    return true;
+}
+
+std::optional<size_t> TIOEventIndex::FindTACK(uint64_t tack) const {
+    auto it = std::lower_bound(tacks_.begin(), tacks_.end(), tack);
+    if (it == tacks_.end() || *it != tack) return std::nullopt;
+    return tack_events_[it - tacks_.begin()];
+}
+
+size_t TIOEventIndex::FindNearestTACK(uint64_t tack) const {
+    if (tacks_.empty()) throw std::runtime_error("Event index is empty");
+
+    auto it = std::lower_bound(tacks_.begin(), tacks_.end(), tack);
+    uint64_t nearest;
+    if (it == tacks_.end()) {
+        nearest = tacks_.back();
+    } else if (it == tacks_.begin() || *it == tack) {
+        nearest = *it;
+    } else {
+        uint64_t previous = *(it - 1);
+        nearest = (tack - previous <= *it - tack) ? previous : *it;
+    }
+    return *FindTACK(nearest);
+}
+
+std::vector<size_t> TIOEventIndex::FindTACKRange(
+        uint64_t first_tack, uint64_t last_tack) const {
+    auto begin = std::lower_bound(tacks_.begin(), tacks_.end(), first_tack);
+    auto end = std::upper_bound(begin, tacks_.end(), last_tack);
+    return std::vector<size_t>(tack_events_.begin() + (begin - tacks_.begin()),
+                               tack_events_.begin() + (end - tacks_.begin()));
+}
+
+std::optional<size_t> TIOEventIndex::FindEventID(uint32_t event_id) const {
+    auto it = std::lower_bound(event_ids_.begin(), event_ids_.end(), event_id);
+    if (it == event_ids_.end() || *it != event_id) return std::nullopt;
+    return event_id_events_[it - event_ids_.begin()];
+}
+
+std::vector<size_t> TIOEventIndex::FindEventIDRange(
+        uint32_t first_id, uint32_t last_id) const {
+    auto begin = std::lower_bound(event_ids_.begin(), event_ids_.end(), first_id);
+    auto end = std::upper_bound(begin, event_ids_.end(), last_id);
+    return std::vector<size_t>(
+        event_id_events_.begin() + (begin - event_ids_.begin()),
+        event_id_events_.begin() + (end - event_ids_.begin()));
+}
+
+}
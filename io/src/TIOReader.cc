@@ -7,10 +7,32 @@
 #include <cinttypes>
 #include <memory>
 #include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace sstcam::io {
 
-TIOReader::TIOReader(const std::string& path)
+namespace {
+
+// Position-independent read of n_bytes at offset, retrying partial reads.
+bool ReadAt(int fd, void* buffer, size_t n_bytes, size_t offset) {
+    auto* dest = static_cast<uint8_t*>(buffer);
+    while (n_bytes > 0) {
+        ssize_t n_read = pread(fd, dest, n_bytes, static_cast<off_t>(offset));
+        if (n_read < 0 && errno == EINTR) continue;
+        if (n_read <= 0) return false;
+        dest += n_read;
+        n_bytes -= static_cast<size_t>(n_read);
+        offset += static_cast<size_t>(n_read);
+    }
+    return true;
+}
+
+}
+
+TIOReader::TIOReader(const std::string& path, bool memory_map)
     : fits_(nullptr),
       event_hdu_num_(0),
       n_event_headers_(0),
@@ -21,7 +43,14 @@ TIOReader::TIOReader(const std::string& path)
       n_samples_(0),
       first_active_module_slot_(0),
       scale_(1.),
-      offset_(0.)
+      offset_(0.),
+      row_size_(0),
+      packet_offset_(0),
+      fd_(-1),
+      event_data_offset_(0),
+      event_data_(nullptr),
+      is_r1_(false),
+      camera_version_("1.1.0") // Default = CHEC-S
 {
     // Open fits file
     int status = 0;
@@ -31,11 +60,30 @@ TIOReader::TIOReader(const std::string& path)
         throw std::runtime_error(ss.str());
     }
 
+    // The destructor is not run if the construction fails (e.g. a header
+    // keyword is missing), so the file is closed by this guard instead
+    struct CloseOnFailure {
+        TIOReader* reader;
+        ~CloseOnFailure() {
+            if (!reader) return;
+            try { reader->Close(); } catch (...) { } // Keep the original error
+        }
+    } guard{this};
+
+    // Parse the primary header once; the run-wise metadata getters are then
+    // answered from memory
+    int hdutype = IMAGE_HDU;
+    if (fits_movabs_hdu(fits_, 1, &hdutype, &status)) {
+        std::ostringstream ss;
+        ss << "Cannot move to the primary HDU" << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+    header_keywords_ = fitsutils::ReadHeaderKeywords(fits_);
+
     // Get EventHeaderVersion
     std::string key = "EVENT_HEADER_VERSION";
-    uint16_t version = fitsutils::GetHeaderKeyValue<int16_t, TINT>(fits_, key);
+    auto version = fitsutils::GetKeywordValue<int16_t>(header_keywords_, key);
     if (version < 1) {
-        Close();
         std::ostringstream ss;
         ss << "Incompatible EVENT_HEADER_VERSION: " << version;
         throw std::runtime_error(ss.str());
@@ -43,40 +91,26 @@ TIOReader::TIOReader(const std::string& path)
 
     // Move pointer to EVENTS HDU
     if (fits_movnam_hdu(fits_, BINARY_TBL, const_cast<char *>("EVENTS"), 0, &status)) {
-        Close();
         std::ostringstream ss;
         ss << "Cannot move to the HDU: EVENTS " << fitsutils::ErrorMessage(status);
         throw std::runtime_error(ss.str());
     }
     fits_get_hdu_num(fits_, &event_hdu_num_);
 
-    char comment[FLEN_COMMENT];
-    char value[FLEN_VALUE];
-    char tform[FLEN_KEYWORD];
+    // Parse the EVENTS header with a single call, rather than reading the
+    // column keywords one at a time
+    fitsutils::HeaderKeywords event_keywords = fitsutils::ReadHeaderKeywords(fits_);
 
     // Get Number of columns in EVENTS HDU
-    long n_event_columns;
-    if (fits_read_key_lng(fits_, "TFIELDS", &n_event_columns, comment, &status)) {
-        Close();
-        std::ostringstream ss;
-        ss << "Cannot read TFIELDS " << fitsutils::ErrorMessage(status);
-        throw std::runtime_error(ss.str());
-    }
+    auto n_event_columns = fitsutils::GetKeywordValue<int64_t>(event_keywords, "TFIELDS");
 
     // Find first packet column (and therefore calculate the number of headers)
     for (int64_t i = 0; i < n_event_columns && i < 256; ++i) {
-        snprintf(tform, FLEN_KEYWORD, "TTYPE%" PRIi64, i + 1);
-        if (fits_read_key_str(fits_, tform, value, comment, &status)) {
-            Close();
-            std::ostringstream ss;
-            ss << "Cannot read TTYPE " << i + 1 << fitsutils::ErrorMessage(status);
-            throw std::runtime_error(ss.str());
-        } else {
-            // Found the first packet column
-            if (strcmp(value, "EVENT_PACKET_0") == 0) {
-                n_event_headers_ = static_cast<uint8_t>(i);
-                break;
-            }
+        std::string ttype = "TTYPE" + std::to_string(i + 1);
+        auto value = fitsutils::GetKeywordValue<std::string>(event_keywords, ttype);
+        if (value == "EVENT_PACKET_0") { // Found the first packet column
+            n_event_headers_ = static_cast<uint8_t>(i);
+            break;
         }
     }
 
@@ -86,62 +120,102 @@ TIOReader::TIOReader(const std::string& path)
 
     // Obtain the size of a waveform packet, and check that all waveform packet
     // columns share this packet size
-    status = 0;
-    comment[0] = 0;
-    value[0] = 0;
-    tform[0] = 0;
-    for (int i = n_event_headers_; i < n_event_columns; ++i) {
-        snprintf(tform, FLEN_KEYWORD, "TFORM%d", i + 1);
-        if (fits_read_key_str(fits_, tform, value, comment, &status)) {
-            Close();
-            std::ostringstream ss;
-            ss << "Cannot read TFORM " << i + 1 << fitsutils::ErrorMessage(status);
-            throw std::runtime_error(ss.str());
-        }
+    for (int64_t i = n_event_headers_; i < n_event_columns; ++i) {
+        std::string tform = "TFORM" + std::to_string(i + 1);
+        auto value = fitsutils::GetKeywordValue<std::string>(event_keywords, tform);
 
         uint16_t packet_size_i;
-        if (sscanf(value, "%" SCNu16 "B", &packet_size_i) == 1) {
+        if (sscanf(value.c_str(), "%" SCNu16 "B", &packet_size_i) == 1) {
             if (packet_size_ == 0) {
                 packet_size_ = packet_size_i;
             }
             else if (packet_size_i != packet_size_) {
-                Close();
                 std::ostringstream ss;
                 ss << "Expected value of TFORM " << i << " is "
                 << packet_size_ << " but it is " << value;
                 throw std::runtime_error(ss.str());
             }
         } else {
-            Close();
             std::ostringstream ss;
             ss << "Expected value of TFORM " << i << " is xxxB, but it is " << value;
             throw std::runtime_error(ss.str());
         }
     }
 
+    // Size of a row, and the position of the first packet column within it.
+    // The packet columns are the last columns in the row.
+    row_size_ = fitsutils::GetKeywordValue<size_t>(event_keywords, "NAXIS1");
+    if (row_size_ < n_packets_per_event_ * packet_size_) {
+        std::ostringstream ss;
+        ss << "NAXIS1 (" << row_size_ << ") is smaller than the packet columns";
+        throw std::runtime_error(ss.str());
+    }
+    packet_offset_ = row_size_ - n_packets_per_event_ * packet_size_;
+
     // Get number of events in file
-    n_events_ = static_cast<size_t>(fitsutils::GetNRows(fits_, event_hdu_num_));
+    n_events_ = fitsutils::GetKeywordValue<size_t>(event_keywords, "NAXIS2");
+
+    OpenDirectAccess(path, memory_map);
+
+    // Obtain the modules that were active and obtain the hardcoded module
+    // situation, and n_samples, from the packets of the first event (read
+    // in a single call)
+    if (n_events_ > 0) {
+        auto block = ReadEventBlock(0, 1);
+        for (const WaveformDataPacket& packet : block->packets) {
+            active_modules_.insert(packet.GetSlotID());
+        }
+        sstcam::descriptions::GetHardcodedModuleSituation(
+            active_modules_, n_pixels_, first_active_module_slot_);
+        n_samples_ = block->packets[0].GetWaveformNSamples();
 
-    // Obtain the modules that were active and obtain the hardcoded module situation
-    for (uint32_t ipack=0; ipack < n_packets_per_event_; ipack++) {
-        active_modules_.insert(ReadPacket(0, ipack)->GetSlotID());
+        // The packet geometry of the first event is used to fill the sample
+        // arrays of all events (validated per event). Without a plan (e.g. if
+        // the first event is missing packets), the events are filled by
+        // parsing the packet headers.
+        std::vector<WaveformDataPacket*> packets;
+        for (WaveformDataPacket& packet : block->packets) packets.push_back(&packet);
+        try {
+            decode_plan_ = std::make_shared<const sstcam::descriptions::WaveformDecodePlan>(
+                packets, first_active_module_slot_);
+        } catch (const std::runtime_error&) {
+            decode_plan_ = nullptr;
+        }
     }
-    sstcam::descriptions::GetHardcodedModuleSituation(
-        active_modules_, n_pixels_, first_active_module_slot_);
 
-    // Get n_samples from first packet
-    n_samples_ = ReadPacket(0, 0)->GetWaveformNSamples();
+    // Run-wise metadata from the primary header
+    if (header_keywords_.count("R1")) {
+        is_r1_ = fitsutils::GetKeywordValue<bool>(header_keywords_, "R1");
+    }
+    if (header_keywords_.count("CAMERAVERSION")) {
+        camera_version_ = fitsutils::GetKeywordValue<std::string>(
+            header_keywords_, "CAMERAVERSION");
+    }
 
     // Get scale and offset to return to float from uint16
-    if (IsR1()) {
-        scale_ = fitsutils::GetHeaderKeyValue<float, TFLOAT>(fits_, "SCALE");
-        offset_ = fitsutils::GetHeaderKeyValue<float, TFLOAT>(fits_, "OFFSET");
+    if (is_r1_) {
+        scale_ = fitsutils::GetKeywordValue<float>(header_keywords_, "SCALE");
+        offset_ = fitsutils::GetKeywordValue<float>(header_keywords_, "OFFSET");
     }
+    guard.reader = nullptr;
 }
 
 void TIOReader::Close() {
+    std::unique_lock<std::shared_mutex> lock(close_mutex_);
     if (!IsOpen()) return;
 
+    // Events that were read keep their own reference to the mapping
+    mapping_ = nullptr;
+    event_data_ = nullptr;
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+
+    event_id_column_.Reset();
+    event_tack_column_.Reset();
+    event_n_packets_filled_column_.Reset();
+    event_cpu_second_column_.Reset();
+    event_cpu_nanosecond_column_.Reset();
+
     int status = 0;
     if (fits_close_file(fits_, &status)) {
         std::ostringstream ss;
@@ -152,100 +226,118 @@ void TIOReader::Close() {
 }
 
 uint32_t TIOReader::GetRunID() const {
-    return fitsutils::GetHeaderKeyValue<int32_t, TINT>(fits_, "RUNNUMBER");
+    return fitsutils::GetKeywordValue<uint32_t>(header_keywords_, "RUNNUMBER");
 }
 
-bool TIOReader::IsR1() const {
-    if (fitsutils::HasHeaderKey(fits_, "R1")) {
-        return fitsutils::GetHeaderKeyValue<bool, TLOGICAL>(fits_, "R1");
-    } else {
-        return false;
-    }
+uint32_t TIOReader::GetEventID(size_t event_index) const {
+    if (event_index >= GetNEvents())
+        throw std::runtime_error("Event index out of range");
+    std::shared_lock<std::shared_mutex> lock(close_mutex_);
+    return GetEventIDColumn()[event_index];
 }
 
-std::string TIOReader::GetCameraVersion() const {
-    if (fitsutils::HasHeaderKey(fits_, "CAMERAVERSION")) {
-        auto camera_version = fitsutils::GetHeaderKeyValue<
-            std::string, TSTRING>(fits_, "CAMERAVERSION");
-        return camera_version;
-    } else {
-        return "1.1.0"; // Default = CHEC-S;
-    }
+uint64_t TIOReader::GetEventTACK(size_t event_index) const {
+    if (event_index >= GetNEvents())
+        throw std::runtime_error("Event index out of range");
+    std::shared_lock<std::shared_mutex> lock(close_mutex_);
+    return GetEventTACKColumn()[event_index];
 }
 
-uint32_t TIOReader::GetEventID(size_t event_index) const {
-    MoveToEventHDU();
-    uint32_t event_id;
-    int status = 0;
-    fits_read_col(fits_, TUINT, 1, event_index + 1, 1, 1, nullptr,
-                  &event_id, nullptr, &status);
-    if (status != 0) {
-        std::ostringstream ss;
-        ss << "Error reading Event ID from file " << fitsutils::ErrorMessage(status);
-        throw std::runtime_error(ss.str());
-    }
-    return event_id;
+uint16_t TIOReader::GetEventNPacketsFilled(size_t event_index) const{
+    if (event_index >= GetNEvents())
+        throw std::runtime_error("Event index out of range");
+    std::shared_lock<std::shared_mutex> lock(close_mutex_);
+    return GetEventNPacketsFilledColumn()[event_index];
 }
 
-uint64_t TIOReader::GetEventTACK(size_t event_index) const {
-    MoveToEventHDU();
-    uint32_t tack32msb, tack32lsb;
-    int status = 0;
-    fits_read_col(fits_, TUINT, 2, event_index + 1, 1, 1, nullptr,
-                  &tack32msb, nullptr, &status);
-    fits_read_col(fits_, TUINT, 3, event_index + 1, 1, 1, nullptr,
-                  &tack32lsb, nullptr, &status);
-    if (status != 0) {
-        std::ostringstream ss;
-        ss << "Error reading event TACK from file " << fitsutils::ErrorMessage(status);
-        throw std::runtime_error(ss.str());
-    }
-    return (static_cast<uint64_t>(tack32msb) << 32u) | static_cast<uint64_t>(tack32lsb);
+int64_t TIOReader::GetEventCPUSecond(size_t event_index) const {
+    if (event_index >= GetNEvents())
+        throw std::runtime_error("Event index out of range");
+    std::shared_lock<std::shared_mutex> lock(close_mutex_);
+    return GetEventCPUSecondColumn()[event_index];
 }
 
-uint16_t TIOReader::GetEventNPacketsFilled(size_t event_index) const{
-    MoveToEventHDU();
-    int status = 0;
-    uint16_t n_filled = 0;
-    fits_read_col(fits_, TUSHORT, 4, event_index + 1, 1, 1, nullptr,
-                  &n_filled, nullptr, &status);
-    if (status != 0) {
-        std::ostringstream ss;
-        ss << "Error reading Event 'Number of Packets Filled' from file "
-            << fitsutils::ErrorMessage(status);
-        throw std::runtime_error(ss.str());
+int64_t TIOReader::GetEventCPUNanosecond(size_t event_index) const {
+    if (event_index >= GetNEvents())
+        throw std::runtime_error("Event index out of range");
+    std::shared_lock<std::shared_mutex> lock(close_mutex_);
+    return GetEventCPUNanosecondColumn()[event_index];
+}
+
+const std::vector<uint32_t>& TIOReader::GetEventIDColumn() const {
+    return GetCachedColumn(event_id_column_, [this] {
+        return ReadColumn<uint32_t, TUINT>(1, "Event ID");
+    });
+}
+
+const std::vector<uint64_t>& TIOReader::GetEventTACKColumn() const {
+    return GetCachedColumn(event_tack_column_, [this] {
+        auto tack32msb = ReadColumn<uint32_t, TUINT>(2, "event TACK (MSB)");
+        auto tack32lsb = ReadColumn<uint32_t, TUINT>(3, "event TACK (LSB)");
+        std::vector<uint64_t> tack(tack32msb.size());
+        for (size_t i = 0; i < tack.size(); i++) {
+            tack[i] = (static_cast<uint64_t>(tack32msb[i]) << 32u) |
+                static_cast<uint64_t>(tack32lsb[i]);
+        }
+        return tack;
+    });
+}
+
+const std::vector<uint16_t>& TIOReader::GetEventNPacketsFilledColumn() const {
+    return GetCachedColumn(event_n_packets_filled_column_, [this] {
+        return ReadColumn<uint16_t, TUSHORT>(4, "Event 'Number of Packets Filled'");
+    });
+}
+
+const std::vector<int64_t>& TIOReader::GetEventCPUSecondColumn() const {
+    return GetCachedColumn(event_cpu_second_column_, [this] {
+        return ReadColumn<int64_t, TLONGLONG>(5, "event CPU timestamp (seconds)");
+    });
+}
+
+const std::vector<int64_t>& TIOReader::GetEventCPUNanosecondColumn() const {
+    return GetCachedColumn(event_cpu_nanosecond_column_, [this] {
+        return ReadColumn<int64_t, TLONGLONG>(6, "event CPU timestamp (nanosecond)");
+    });
+}
+
+const TIOEventIndex& TIOReader::GetEventIndex(const std::string& sidecar_path) const {
+    std::shared_lock<std::shared_mutex> close_lock(close_mutex_);
+    std::lock_guard<std::mutex> lock(event_index_mutex_);
+    if (!event_index_) {
+        event_index_ = std::make_unique<TIOEventIndex>(*this, sidecar_path);
     }
-    return n_filled;
+    return *event_index_;
 }
 
-int64_t TIOReader::GetEventCPUSecond(size_t event_index) const {
-    MoveToEventHDU();
-    int status = 0;
-    int64_t cpu_s = 0;
-    fits_read_col(fits_, TLONGLONG, 5, event_index + 1, 1, 1, nullptr,
-                  &cpu_s, nullptr, &status);
-    if (status != 0) {
-        std::ostringstream ss;
-        ss << "Error reading event CPU timestamp (seconds) from file "
-           << fitsutils::ErrorMessage(status);
-        throw std::runtime_error(ss.str());
+template<typename T, typename TRead>
+const std::vector<T>& TIOReader::GetCachedColumn(
+        CachedColumn<T>& column, TRead read) const {
+    if (!column.loaded.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(fits_mutex_);
+        if (!column.loaded.load(std::memory_order_relaxed)) {
+            column.values = read();
+            column.loaded.store(true, std::memory_order_release);
+        }
     }
-    return cpu_s;
+    return column.values;
 }
 
-int64_t TIOReader::GetEventCPUNanosecond(size_t event_index) const {
+template<typename T, int TFITS>
+std::vector<T> TIOReader::ReadColumn(int column_num, const std::string& name) const {
     MoveToEventHDU();
+    std::vector<T> values(n_events_);
+    if (n_events_ == 0) return values;
+
     int status = 0;
-    int64_t cpu_ns = 0;
-    fits_read_col(fits_, TLONGLONG, 6, event_index + 1, 1, 1, nullptr,
-                  &cpu_ns, nullptr, &status);
-    if (status != 0) {
+    if (fits_read_col(fits_, TFITS, column_num, 1, 1, n_events_, nullptr,
+                      values.data(), nullptr, &status)) {
         std::ostringstream ss;
-        ss << "Error reading event CPU timestamp (nanosecond) from file "
+        ss << "Error reading " << name << " from file "
            << fitsutils::ErrorMessage(status);
         throw std::runtime_error(ss.str());
     }
-    return cpu_ns;
+    return values;
 }
 
 void TIOReader::MoveToEventHDU() const {
@@ -260,24 +352,91 @@ void TIOReader::MoveToEventHDU() const {
     }
 }
 
-std::shared_ptr<WaveformDataPacket> TIOReader::ReadPacket(
-        size_t event_index, uint16_t packet_id) const {
-    auto packet = std::make_shared<WaveformDataPacket>(packet_size_);
-
+void TIOReader::OpenDirectAccess(const std::string& path, bool memory_map) {
     MoveToEventHDU();
-
     int status = 0;
-    int anynull;
-    if (fits_read_col(fits_, TBYTE, packet_id + n_event_headers_ + 1,
-                      event_index + 1, 1, packet->GetPacketSize(), nullptr,
-                      packet->GetDataPacket(), &anynull, &status)) {
+    LONGLONG header_start, data_start, data_end;
+    if (fits_get_hduaddrll(fits_, &header_start, &data_start, &data_end, &status)) {
+        Close();
         std::ostringstream ss;
-        ss << "Cannot read the " << packet_id << "th packet of "
-           << "the " << event_index << "th event "
-           << fitsutils::ErrorMessage(status);
+        ss << "Cannot obtain the EVENTS HDU address " << fitsutils::ErrorMessage(status);
         throw std::runtime_error(ss.str());
     }
-    return packet;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return; // Not a plain file (e.g. cfitsio extended filename syntax)
+
+    // The byte offsets given by cfitsio only correspond to the file on disk
+    // if it is an uncompressed FITS file (e.g. not gzipped)
+    char magic[9];
+    struct stat st{};
+    auto table_end = static_cast<size_t>(data_start) + n_events_ * row_size_;
+    if (!ReadAt(fd, magic, sizeof(magic), 0) ||
+        std::memcmp(magic, "SIMPLE  =", sizeof(magic)) != 0 ||
+        fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < table_end) {
+        close(fd);
+        return;
+    }
+    event_data_offset_ = static_cast<size_t>(data_start);
+
+    if (memory_map) {
+        try {
+            mapping_ = std::make_shared<MappedFile>(path);
+            event_data_ = mapping_->GetData() + event_data_offset_;
+            close(fd);
+            return;
+        } catch (const std::runtime_error&) {
+            mapping_ = nullptr; // Fall back to position-independent reads
+        }
+    }
+    fd_ = fd;
+}
+
+std::shared_ptr<TIOReader::EventBlock> TIOReader::ReadEventBlock(
+        size_t first_event_index, size_t n_events) const {
+    auto block = std::make_shared<EventBlock>();
+
+    if (mapping_) {
+        // Zero-copy: the slab is the mapping itself, which the block keeps alive
+        block->slab = std::shared_ptr<uint8_t>(
+            mapping_, event_data_ + first_event_index * row_size_);
+    } else if (fd_ >= 0) {
+        // Read all rows in one position-independent call (no locking required)
+        block->slab = std::shared_ptr<uint8_t>(
+            new uint8_t[n_events * row_size_], std::default_delete<uint8_t[]>());
+        if (!ReadAt(fd_, block->slab.get(), n_events * row_size_,
+                    event_data_offset_ + first_event_index * row_size_)) {
+            std::ostringstream ss;
+            ss << "Cannot read rows " << first_event_index << " to "
+               << first_event_index + n_events << " (" << std::strerror(errno) << ")";
+            throw std::runtime_error(ss.str());
+        }
+    } else {
+        // Read all rows in one cfitsio call
+        block->slab = std::shared_ptr<uint8_t>(
+            new uint8_t[n_events * row_size_], std::default_delete<uint8_t[]>());
+        std::lock_guard<std::mutex> lock(fits_mutex_);
+        MoveToEventHDU();
+        int status = 0;
+        auto first_row = static_cast<LONGLONG>(first_event_index + 1);
+        if (fits_read_tblbytes(fits_, first_row, 1, n_events * row_size_,
+                               block->slab.get(), &status)) {
+            std::ostringstream ss;
+            ss << "Cannot read rows " << first_event_index << " to "
+               << first_event_index + n_events << fitsutils::ErrorMessage(status);
+            throw std::runtime_error(ss.str());
+        }
+    }
+
+    // Create the packet views into the slab
+    block->packets.reserve(n_events * n_packets_per_event_);
+    for (size_t iev = 0; iev < n_events; iev++) {
+        uint8_t* row = block->slab.get() + iev * row_size_ + packet_offset_;
+        for (size_t ipack = 0; ipack < n_packets_per_event_; ipack++) {
+            block->packets.emplace_back(&row[ipack * packet_size_], packet_size_);
+        }
+    }
+    return block;
 }
 
 }
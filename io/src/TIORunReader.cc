@@ -0,0 +1,120 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIORunReader.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace sstcam::io {
+
+TIORunReader::TIORunReader(const std::vector<std::string>& paths,
+        bool merge_by_tack, bool memory_map)
+    : readers_(paths.size()),
+      merge_by_tack_(merge_by_tack),
+      is_r1_(false)
+{
+    if (paths.empty()) throw std::runtime_error("No files provided for the run");
+
+    // Open the files in parallel, as opening is dominated by the file
+    // system latency and the reading of the headers
+    std::vector<std::exception_ptr> errors(paths.size());
+    std::atomic<size_t> next_file(0);
+    auto open = [&] {
+        for (size_t i = next_file++; i < paths.size(); i = next_file++) {
+            try {
+                readers_[i] = std::make_unique<TIOReader>(paths[i], memory_map);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    size_t n_threads = std::min<size_t>(paths.size(),
+        std::max(std::thread::hardware_concurrency(), 1u));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_threads; i++) threads.emplace_back(open);
+    open();
+    for (std::thread& thread : threads) thread.join();
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    is_r1_ = readers_[0]->IsR1();
+    ValidateFiles();
+
+    size_t n_events = 0;
+    for (const auto& reader : readers_) n_events += reader->GetNEvents();
+    locations_.reserve(n_events);
+    for (size_t ifile = 0; ifile < readers_.size(); ifile++) {
+        for (size_t iev = 0; iev < readers_[ifile]->GetNEvents(); iev++) {
+            locations_.push_back({ifile, iev});
+        }
+    }
+
+    if (merge_by_tack_) {
+        std::vector<uint64_t> tacks;
+        tacks.reserve(n_events);
+        for (const auto& reader : readers_) {
+            const std::vector<uint64_t>& column = reader->GetEventTACKColumn();
+            tacks.insert(tacks.end(), column.begin(), column.end());
+        }
+        std::vector<size_t> order(n_events);
+        for (size_t i = 0; i < n_events; i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&tacks](size_t a, size_t b) { return tacks[a] < tacks[b]; });
+        std::vector<EventLocation> merged(n_events);
+        for (size_t i = 0; i < n_events; i++) merged[i] = locations_[order[i]];
+        locations_ = std::move(merged);
+    }
+}
+
+void TIORunReader::ValidateFiles() const {
+    const TIOReader& first = *readers_[0];
+    for (const auto& reader : readers_) {
+        std::ostringstream ss;
+        if (reader->GetNPixels() != first.GetNPixels()) {
+            ss << "Number of pixels (" << reader->GetNPixels() << ") differs from "
+               << "the first file of the run (" << first.GetNPixels() << ")";
+        } else if (reader->GetNSamples() != first.GetNSamples()) {
+            ss << "Number of samples (" << reader->GetNSamples() << ") differs from "
+               << "the first file of the run (" << first.GetNSamples() << ")";
+        } else if (reader->IsR1() != is_r1_) {
+            ss << "R1 calibration differs from the first file of the run";
+        } else if (is_r1_ && (reader->GetScale() != first.GetScale() ||
+                              reader->GetOffset() != first.GetOffset())) {
+            ss << "R1 scale/offset (" << reader->GetScale() << "/"
+               << reader->GetOffset() << ") differs from the first file of the run ("
+               << first.GetScale() << "/" << first.GetOffset() << ")";
+        } else {
+            continue;
+        }
+        ss << ": " << reader->GetPath();
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void TIORunReader::Close() {
+    for (auto& reader : readers_) reader->Close();
+}
+
+uint64_t TIORunReader::GetEventTACK(size_t event_index) const {
+    EventLocation location = GetEventLocation(event_index);
+    return readers_[location.file_index]->GetEventTACK(location.event_index);
+}
+
+WaveformEventR0 TIORunReader::GetEventR0(size_t event_index) const {
+    EventLocation location = GetEventLocation(event_index);
+    WaveformEventR0 event = readers_[location.file_index]->GetEventR0(location.event_index);
+    event.SetIndex(event_index);
+    return event;
+}
+
+WaveformEventR1 TIORunReader::GetEventR1(size_t event_index) const {
+    EventLocation location = GetEventLocation(event_index);
+    WaveformEventR1 event = readers_[location.file_index]->GetEventR1(location.event_index);
+    event.SetIndex(event_index);
+    return event;
+}
+
+}
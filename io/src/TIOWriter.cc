@@ -0,0 +1,226 @@
+// Copyright 2020 Cherenkov Telescope Array Observatory
+// This software is distributed under the terms of the BSD-3-Clause license.
+
+#include "sstcam/io/TIOWriter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace sstcam::io {
+
+namespace {
+
+// Bytes occupied by the event header columns in a row.
+constexpr size_t EVENT_HEADER_SIZE = 4 + 4 + 4 + 2 + 8 + 8;
+
+// Store a value in the big-endian byte order of FITS binary tables.
+template<typename T>
+inline uint8_t* StoreBigEndian(uint8_t* dest, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) {
+        dest[i] = static_cast<uint8_t>(value >> (8u * (sizeof(T) - 1 - i)));
+    }
+    return dest + sizeof(T);
+}
+
+}
+
+TIOWriter::TIOWriter(const std::string& path,
+        size_t n_packets_per_event, size_t packet_size,
+        bool is_r1, float scale, float offset,
+        size_t n_events_reserve, size_t n_events_buffer)
+    : fits_(nullptr),
+      event_hdu_num_(0),
+      n_packets_per_event_(n_packets_per_event),
+      packet_size_(packet_size),
+      row_size_(EVENT_HEADER_SIZE + n_packets_per_event * packet_size),
+      n_rows_allocated_(n_events_reserve),
+      n_events_flushed_(0),
+      n_events_buffered_(0),
+      n_events_buffer_(std::max<size_t>(n_events_buffer, 1)),
+      buffer_(n_events_buffer_ * row_size_)
+{
+    // Create fits file ("!" overwrites an existing file)
+    int status = 0;
+    std::string clobber_path = "!" + path;
+    if (fits_create_file(&fits_, clobber_path.c_str(), &status)) {
+        fits_ = nullptr;
+        std::ostringstream ss;
+        ss << "Cannot create: " << path << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+
+    // The destructor is not run if the construction fails (e.g. a header
+    // keyword cannot be written), so the file is closed by this guard instead
+    struct CloseOnFailure {
+        TIOWriter* writer;
+        ~CloseOnFailure() {
+            if (!writer) return;
+            try { writer->Close(); } catch (...) { } // Keep the original error
+        }
+    } guard{this};
+
+    // Empty primary HDU, holding the run-wise header keywords
+    if (fits_create_img(fits_, BYTE_IMG, 0, nullptr, &status)) {
+        std::ostringstream ss;
+        ss << "Cannot create the primary HDU " << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+    fitsutils::AddHeaderKeyValue<int, TINT>(fits_, "EVENT_HEADER_VERSION",
+        TIO_EVENT_HEADER_VERSION, "Version of the event header columns");
+    fitsutils::AddHeaderKeyValue<int, TLOGICAL>(fits_, "R1",
+        is_r1 ? 1 : 0, "Waveform samples are R1 (calibrated)");
+    if (is_r1) {
+        fitsutils::AddHeaderKeyValue<float, TFLOAT>(fits_, "SCALE",
+            scale, "Scale applied to the R1 samples");
+        fitsutils::AddHeaderKeyValue<float, TFLOAT>(fits_, "OFFSET",
+            offset, "Offset applied to the R1 samples");
+    }
+
+    // EVENTS table: header columns followed by one column per packet
+    std::vector<std::string> names = {
+        "EVENT_ID", "TACK_MSB", "TACK_LSB", "NPACKETS_FILLED",
+        "CPU_TIME_SECOND", "CPU_TIME_NANOSECOND"
+    };
+    std::vector<std::string> forms = {"1V", "1V", "1V", "1U", "1K", "1K"};
+    for (size_t ipack = 0; ipack < n_packets_per_event_; ipack++) {
+        names.push_back("EVENT_PACKET_" + std::to_string(ipack));
+        forms.push_back(std::to_string(packet_size_) + "B");
+    }
+    std::vector<char*> ttype, tform;
+    for (size_t i = 0; i < names.size(); i++) {
+        ttype.push_back(const_cast<char*>(names[i].c_str()));
+        tform.push_back(const_cast<char*>(forms[i].c_str()));
+    }
+    if (fits_create_tbl(fits_, BINARY_TBL, static_cast<LONGLONG>(n_rows_allocated_),
+                        static_cast<int>(names.size()), ttype.data(), tform.data(),
+                        nullptr, "EVENTS", &status)) {
+        std::ostringstream ss;
+        ss << "Cannot create the EVENTS table " << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+    fits_get_hdu_num(fits_, &event_hdu_num_);
+    guard.writer = nullptr;
+}
+
+TIOWriter::~TIOWriter() {
+    try {
+        Close();
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void TIOWriter::Close() {
+    if (!IsOpen()) return;
+
+    int status = 0;
+    if (event_hdu_num_ > 0) {
+        Flush();
+
+        // Remove the preallocated rows that were not used
+        if (n_rows_allocated_ > n_events_flushed_) {
+            MoveToEventHDU();
+            fits_delete_rows(fits_, static_cast<LONGLONG>(n_events_flushed_ + 1),
+                static_cast<LONGLONG>(n_rows_allocated_ - n_events_flushed_), &status);
+            n_rows_allocated_ = n_events_flushed_;
+        }
+    }
+
+    fits_close_file(fits_, &status);
+    fits_ = nullptr;
+    if (status != 0) {
+        std::ostringstream ss;
+        ss << "Cannot close the file " << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void TIOWriter::WriteEvent(const descriptions::WaveformEvent& event,
+        uint32_t event_id) {
+    if (!IsOpen()) throw std::runtime_error("File is not open");
+
+    std::vector<descriptions::WaveformDataPacket*> packets = event.GetPackets();
+    if (packets.size() != n_packets_per_event_) {
+        std::ostringstream ss;
+        ss << "Event contains " << packets.size() << " packets, but the file "
+           << "expects " << n_packets_per_event_;
+        throw std::runtime_error(ss.str());
+    }
+
+    uint64_t tack = event.GetTACK();
+    auto tack32msb = static_cast<uint32_t>(tack >> 32u);
+    auto tack32lsb = static_cast<uint32_t>(tack & 0xFFFFFFFFu);
+
+    // Unsigned columns are stored with TZERO (i.e. with the sign bit flipped)
+    uint8_t* row = &buffer_[n_events_buffered_ * row_size_];
+    row = StoreBigEndian<uint32_t>(row, event_id ^ 0x80000000u);
+    row = StoreBigEndian<uint32_t>(row, tack32msb ^ 0x80000000u);
+    row = StoreBigEndian<uint32_t>(row, tack32lsb ^ 0x80000000u);
+    row = StoreBigEndian<uint16_t>(row, event.GetNPacketsAdded() ^ 0x8000u);
+    row = StoreBigEndian<uint64_t>(row, static_cast<uint64_t>(event.GetCPUTimeSecond()));
+    row = StoreBigEndian<uint64_t>(row, static_cast<uint64_t>(event.GetCPUTimeNanosecond()));
+
+    for (descriptions::WaveformDataPacket* packet : packets) {
+        if (!packet) {
+            std::memset(row, 0, packet_size_);
+        } else if (packet->GetPacketSize() == packet_size_) {
+            std::memcpy(row, packet->GetDataPacket(), packet_size_);
+        } else {
+            std::ostringstream ss;
+            ss << "Packet size " << packet->GetPacketSize() << " does not match "
+               << "the file packet size " << packet_size_;
+            throw std::runtime_error(ss.str());
+        }
+        row += packet_size_;
+    }
+
+    if (++n_events_buffered_ == n_events_buffer_) Flush();
+}
+
+void TIOWriter::Flush() {
+    if (!IsOpen()) throw std::runtime_error("File is not open");
+    if (n_events_buffered_ == 0) return;
+
+    MoveToEventHDU();
+    int status = 0;
+
+    // Preallocate rows in large steps, rather than extending the table on
+    // every write
+    size_t n_rows_required = n_events_flushed_ + n_events_buffered_;
+    if (n_rows_required > n_rows_allocated_) {
+        size_t n_rows_insert = std::max(n_rows_required - n_rows_allocated_,
+            std::max(n_rows_allocated_, n_events_buffer_));
+        if (fits_insert_rows(fits_, static_cast<LONGLONG>(n_rows_allocated_),
+                             static_cast<LONGLONG>(n_rows_insert), &status)) {
+            std::ostringstream ss;
+            ss << "Cannot allocate rows in the EVENTS table "
+               << fitsutils::ErrorMessage(status);
+            throw std::runtime_error(ss.str());
+        }
+        n_rows_allocated_ += n_rows_insert;
+    }
+
+    if (fits_write_tblbytes(fits_, static_cast<LONGLONG>(n_events_flushed_ + 1), 1,
+                            static_cast<LONGLONG>(n_events_buffered_ * row_size_),
+                            buffer_.data(), &status)) {
+        std::ostringstream ss;
+        ss << "Cannot write the events " << n_events_flushed_ << " to "
+           << n_rows_required << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+    n_events_flushed_ = n_rows_required;
+    n_events_buffered_ = 0;
+}
+
+void TIOWriter::MoveToEventHDU() const {
+    if (!IsOpen()) throw std::runtime_error("File is not open");
+
+    int status = 0;
+    int hdutype = BINARY_TBL;
+    if (fits_movabs_hdu(fits_, event_hdu_num_, &hdutype, &status)) {
+        std::ostringstream ss;
+        ss << "Cannot move to the event HDU " << fitsutils::ErrorMessage(status);
+        throw std::runtime_error(ss.str());
+    }
+}
+
+}